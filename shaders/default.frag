@@ -8,22 +8,24 @@ struct Material{
     float shininess;
 };
 
+// Light structs follow the std140 layout of GpuLightBlock in lightbuffer.hpp:
+// every vec3 is paired with a scalar so that each row is 16 bytes
 struct PointLight {    
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;  
-
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
+    bool enabled;
 }; 
 
 vec3 calcPointLight(PointLight pointlight, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 struct DirLight{
     vec3 direction;
+    bool enabled;
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
@@ -33,17 +35,16 @@ vec3 calcDirLight(DirLight dirlight, vec3 normal, vec3 viewDir);
 
 struct FlashLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
-  
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
-    vec3 specular;       
+    float cutOff;
+    vec3 specular;
+    float outerCutOff;
+    bool enabled;
 };
 
 vec3 calcFlashLight(FlashLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
@@ -60,13 +61,28 @@ uniform int activePointLight;
 uniform vec3 viewPos;
 uniform Material material;
 
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform DirLight dirlight;
-uniform FlashLight flashLight;
+// Filled by LightManager::applyAll through a single uniform buffer
+layout(std140) uniform Lights {
+    DirLight dirlight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    FlashLight flashLight;
+};
+
+#ifdef CLUSTERED_LIGHTING
+// Filled by LightClusters: 4 texels per light (position/range, ambient/constant, diffuse/linear, specular/quadratic),
+// a (first index, count) pair per cluster, and the light indices of every cluster
+uniform samplerBuffer clusterLights;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterIndices;
+
+uniform vec3 clusterDims;
+uniform vec2 clusterTileSize;
+uniform float clusterNear;
+uniform float clusterDepthScale;
+uniform mat4 view;
 
-uniform bool useDirLight;
-uniform bool usePointLight[NR_POINT_LIGHTS];
-uniform bool useFlashLight;
+PointLight fetchClusterLight(int index);
+#endif
 
 void main()
 {   
@@ -75,17 +91,30 @@ void main()
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 result = vec3(0.f);
     // phase 1: Directional lighting
-    if(useDirLight){
+    if(dirlight.enabled){
         result = calcDirLight(dirlight, norm, viewDir);
     }
     // phase 2: Point lights
+#ifdef CLUSTERED_LIGHTING
+    // Only the lights binned into this fragment's cluster
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    ivec3 dims = ivec3(clusterDims);
+    int slice = clamp(int(log(depth / clusterNear) * clusterDepthScale), 0, dims.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0), dims.xy - 1);
+    uvec2 range = texelFetch(clusterGrid, tile.x + dims.x * (tile.y + dims.y * slice)).rg;
+    for(uint i = 0u; i < range.y; i++){
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).r);
+        result += calcPointLight(fetchClusterLight(light), norm, FragPos, viewDir);
+    }
+#else
     for(int i = 0; i < NR_POINT_LIGHTS; i++){
-        if(usePointLight[i]){
+        if(pointLights[i].enabled){
             result += calcPointLight(pointLights[i], norm, FragPos, viewDir);
         }
     }    
+#endif
     // phase 3: Flashlight
-    if(useFlashLight){
+    if(flashLight.enabled){
         result += calcFlashLight(flashLight, norm, FragPos, viewDir);    
     }
     
@@ -152,4 +181,18 @@ vec3 calcFlashLight(FlashLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
-}
\ No newline at end of file
+}
+
+#ifdef CLUSTERED_LIGHTING
+PointLight fetchClusterLight(int index)
+{
+    vec4 positionRange = texelFetch(clusterLights, index * 4);
+    vec4 ambientConstant = texelFetch(clusterLights, index * 4 + 1);
+    vec4 diffuseLinear = texelFetch(clusterLights, index * 4 + 2);
+    vec4 specularQuadratic = texelFetch(clusterLights, index * 4 + 3);
+    return PointLight(positionRange.xyz, ambientConstant.w,
+                      ambientConstant.xyz, diffuseLinear.w,
+                      diffuseLinear.xyz, specularQuadratic.w,
+                      specularQuadratic.xyz, true);
+}
+#endif
\ No newline at end of file
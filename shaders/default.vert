@@ -1,7 +1,32 @@
 #version 330 core
+#ifdef DRAW_PARAMETERS
+#extension GL_ARB_shader_draw_parameters : require
+#endif
 layout (location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTex;
+#ifdef OCTAHEDRAL_NORMALS
+// Compact and Quantized vertices (VertexFormat) store the normal as a point of the unfolded octahedron
+layout(location = 2) in vec2 aNor;
+vec3 decodeNormal(vec2 e)
+{
+   vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+   if (n.z < 0.0)
+      n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+   return normalize(n);
+}
+#define NORMAL decodeNormal(aNor)
+#else
 layout(location = 2) in vec3 aNor;
+#define NORMAL aNor
+#endif
+#ifdef QUANTIZED_POSITIONS
+// Quantized positions read as 0-1 within the mesh bounds
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#define POSITION (positionOffset + positionScale * aPos)
+#else
+#define POSITION aPos
+#endif
 
 // out vec3 color;
 
@@ -9,14 +34,37 @@ out vec2 texCoord;
 out vec3 Normal;
 out vec3 FragPos; 
 
+#ifdef INSTANCED
+// Per-instance model matrix, streamed by Mesh::DrawInstanced or compacted by GpuCuller (locations 3-6)
+layout(location = 3) in mat4 aModel;
+#define model aModel
+#elif defined(BATCHED)
+// Per-draw model matrices, four texels each, written by BatchRenderer. A multi-draw call numbers its
+// draws in gl_DrawIDARB; drawBase offsets them (and is the whole index when drawing one at a time).
+uniform samplerBuffer drawTransforms;
+uniform int drawBase;
+#ifdef DRAW_PARAMETERS
+#define DRAW_INDEX (drawBase + gl_DrawIDARB)
+#else
+#define DRAW_INDEX drawBase
+#endif
+mat4 drawModel()
+{
+   int texel = DRAW_INDEX * 4;
+   return mat4(texelFetch(drawTransforms, texel), texelFetch(drawTransforms, texel + 1),
+               texelFetch(drawTransforms, texel + 2), texelFetch(drawTransforms, texel + 3));
+}
+#define model drawModel()
+#else
 uniform mat4 model;
+#endif
 uniform mat4 view;
 uniform mat4 proj;
 
 void main()
 {
-   gl_Position = proj * view * model * vec4(aPos, 1.0f); 
+   gl_Position = proj * view * model * vec4(POSITION, 1.0f); 
    texCoord = aTex;
-   FragPos = vec3(model * vec4(aPos, 1.0));
-   Normal = aNor;
+   FragPos = vec3(model * vec4(POSITION, 1.0));
+   Normal = NORMAL;
 }
\ No newline at end of file
@@ -1,10 +1,43 @@
 #version 330 core 
+#ifdef DRAW_PARAMETERS
+#extension GL_ARB_shader_draw_parameters : require
+#endif
 layout (location = 0) in vec3 lightPos;
+#ifdef QUANTIZED_POSITIONS
+// Quantized positions read as 0-1 within the mesh bounds (VertexFormat)
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#define POSITION (positionOffset + positionScale * lightPos)
+#else
+#define POSITION lightPos
+#endif
 
+#ifdef INSTANCED
+// Per-instance model matrix, streamed by Mesh::DrawInstanced (locations 3-6)
+layout(location = 3) in mat4 aModel;
+#define model aModel
+#elif defined(BATCHED)
+// Per-draw model matrices, four texels each, written by BatchRenderer. A multi-draw call numbers its
+// draws in gl_DrawIDARB; drawBase offsets them (and is the whole index when drawing one at a time).
+uniform samplerBuffer drawTransforms;
+uniform int drawBase;
+#ifdef DRAW_PARAMETERS
+#define DRAW_INDEX (drawBase + gl_DrawIDARB)
+#else
+#define DRAW_INDEX drawBase
+#endif
+mat4 drawModel(){
+    int texel = DRAW_INDEX * 4;
+    return mat4(texelFetch(drawTransforms, texel), texelFetch(drawTransforms, texel + 1),
+                texelFetch(drawTransforms, texel + 2), texelFetch(drawTransforms, texel + 3));
+}
+#define model drawModel()
+#else
 uniform mat4 model;
+#endif
 uniform mat4 view;
 uniform mat4 proj;
 
 void main(){
-    gl_Position = proj * view * model * vec4(lightPos, 1.0f);
+    gl_Position = proj * view * model * vec4(POSITION, 1.0f);
 }
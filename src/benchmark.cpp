@@ -0,0 +1,1308 @@
+#include "benchmark.hpp"
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine/core/allocationcounter.hpp"
+#include "engine/graphics/buffers/ebo.hpp"
+#include "engine/graphics/buffers/fbo.hpp"
+#include "engine/graphics/buffers/vao.hpp"
+#include "engine/graphics/bvh.hpp"
+#include "engine/graphics/culling.hpp"
+#include "engine/graphics/meshlets.hpp"
+#include "engine/graphics/meshlod.hpp"
+#include "engine/graphics/meshprocessing.hpp"
+#include "engine/graphics/offscreencontext.hpp"
+#include "engine/graphics/profiler.hpp"
+#include "engine/graphics/programcache.hpp"
+#include "engine/graphics/renderstats.hpp"
+#include "engine/graphics/shader.hpp"
+
+// Timer queries in flight; results are read back this many frames later so the CPU never waits on the GPU
+static const int QUERY_RING = 4;
+
+struct FrameResult
+{
+    // Wall time from this frame's start to the next one's, which also catches work a driver defers to flushes
+    double frameMs = 0.0;
+    // Time spent recording the frame, and the GPU time measured by a timer query
+    double cpuMs = 0.0;
+    double gpuMs = 0.0;
+    // Heap allocations made while recording the frame
+    size_t allocations = 0;
+    // Cubes that passed frustum culling
+    size_t visibleCubes = 0;
+    Engine::Graphics::RenderStats stats;
+};
+
+static bool parseCount(const char* text, int& value)
+{
+    char* end;
+    long parsed = std::strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || parsed < 0 || parsed > INT_MAX)
+        return false;
+    value = (int)parsed;
+    return true;
+}
+
+static bool parseBatchPath(const char* text, Engine::Graphics::BatchPath& path)
+{
+    for (Engine::Graphics::BatchPath candidate : {Engine::Graphics::BatchPath::Indirect, Engine::Graphics::BatchPath::MultiDraw,
+                                                  Engine::Graphics::BatchPath::Loop})
+    {
+        if (std::strcmp(text, Engine::Graphics::GetBatchPathName(candidate)) == 0)
+        {
+            path = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseVertexFormat(const char* text, Engine::Graphics::VertexFormat& format)
+{
+    for (Engine::Graphics::VertexFormat candidate : {Engine::Graphics::VertexFormat::Float, Engine::Graphics::VertexFormat::Compact,
+                                                     Engine::Graphics::VertexFormat::Quantized})
+    {
+        if (std::strcmp(text, Engine::Graphics::GetVertexFormatName(candidate)) == 0)
+        {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseBenchmarkOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (std::strcmp(arg, "--bench") == 0)
+            options.enabled = true;
+        else if (std::strcmp(arg, "--clustered") == 0)
+            options.scene.clusteredLighting = true;
+        else if (std::strcmp(arg, "--instanced") == 0)
+            options.scene.instancedDrawing = true;
+        else if (std::strcmp(arg, "--uniform-bench") == 0)
+            options.uniformBenchmark = true;
+        else if (std::strcmp(arg, "--no-render-queue") == 0)
+            options.scene.renderQueue = false;
+        else if (std::strcmp(arg, "--batched") == 0)
+            options.scene.batchedDrawing = true;
+        else if (std::strcmp(arg, "--no-culling") == 0)
+            options.scene.frustumCulling = false;
+        else if (std::strcmp(arg, "--bvh-culling") == 0)
+            options.scene.hierarchicalCulling = true;
+        else if (std::strcmp(arg, "--gpu-culling") == 0)
+            options.scene.gpuCulling = true;
+        else if (std::strcmp(arg, "--no-meshlet-culling") == 0)
+            options.scene.meshletCulling = false;
+        else if (std::strcmp(arg, "--cull-bench") == 0)
+            options.cullBenchmark = true;
+        else if (std::strcmp(arg, "--bvh-bench") == 0)
+            options.bvhBenchmark = true;
+        else if (std::strcmp(arg, "--mesh-bench") == 0)
+            options.meshBenchmark = true;
+        else if (std::strcmp(arg, "--lod-bench") == 0)
+            options.lodBenchmark = true;
+        else if (std::strcmp(arg, "--meshlet-bench") == 0)
+            options.meshletBenchmark = true;
+        else if (std::strcmp(arg, "--no-program-cache") == 0)
+            options.programCache.clear();
+        else if (value == nullptr)
+            ok = false;
+        else
+        {
+            i++;
+            if (std::strcmp(arg, "--frames") == 0)
+                ok = parseCount(value, options.frames) && options.frames > 0;
+            else if (std::strcmp(arg, "--warmup") == 0)
+                ok = parseCount(value, options.warmup);
+            else if (std::strcmp(arg, "--lights") == 0)
+                ok = parseCount(value, options.scene.extraPointLights);
+            else if (std::strcmp(arg, "--cubes") == 0)
+                ok = parseCount(value, options.scene.extraCubes);
+            else if (std::strcmp(arg, "--detail-meshes") == 0)
+                ok = parseCount(value, options.scene.detailMeshes);
+            else if (std::strcmp(arg, "--uniform-calls") == 0)
+                ok = parseCount(value, options.uniformCalls) && options.uniformCalls > 0;
+            else if (std::strcmp(arg, "--cull-objects") == 0)
+                ok = parseCount(value, options.cullObjects) && options.cullObjects > 0;
+            else if (std::strcmp(arg, "--bvh-objects") == 0)
+                ok = parseCount(value, options.bvhObjects) && options.bvhObjects > 0;
+            else if (std::strcmp(arg, "--mesh-segments") == 0)
+                ok = parseCount(value, options.meshSegments) && options.meshSegments >= 4;
+            else if (std::strcmp(arg, "--batch-path") == 0)
+                ok = parseBatchPath(value, options.scene.batchPath);
+            else if (std::strcmp(arg, "--vertex-format") == 0)
+                ok = parseVertexFormat(value, options.vertexFormat);
+            else if (std::strcmp(arg, "--out") == 0)
+                options.output = value;
+            else if (std::strcmp(arg, "--program-cache") == 0)
+                options.programCache = value;
+            else if (std::strcmp(arg, "--trace") == 0)
+                options.trace = value;
+            else if (std::strcmp(arg, "--size") == 0)
+                ok = std::sscanf(value, "%dx%d", &options.width, &options.height) == 2
+                     && options.width > 0 && options.height > 0;
+            else
+                ok = false;
+        }
+
+        if (!ok)
+        {
+            std::cerr << "Invalid option " << arg << (value != nullptr ? " " : "") << (value != nullptr ? value : "")
+                      << " (see benchmark.hpp)" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Orbits the scene once over the run, at a fixed height, always looking at its center
+static void placeCamera(Engine::Graphics::Camera& camera, int frame, int frameCount)
+{
+    float angle = glm::two_pi<float>() * frame / frameCount;
+    camera.Position = glm::vec3(12.0f * glm::cos(angle), 4.0f, 12.0f * glm::sin(angle));
+    camera.LookAt(glm::vec3(0.0f));
+}
+
+static void writeString(std::ostream& out, const char* text)
+{
+    out << '"';
+    for (const char* c = text; c != nullptr && *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            out << '\\';
+        if ((unsigned char)*c >= 0x20)
+            out << *c;
+    }
+    out << '"';
+}
+
+// Writes {"mean", "min", "p50", "p95", "p99", "max"} of a series
+static void writeDistribution(std::ostream& out, std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values)
+        sum += value;
+    auto percentile = [&values](double p) {
+        return values[std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5))];
+    };
+    out << "{\"mean\": " << sum / values.size() << ", \"min\": " << values.front()
+        << ", \"p50\": " << percentile(0.50) << ", \"p95\": " << percentile(0.95)
+        << ", \"p99\": " << percentile(0.99) << ", \"max\": " << values.back() << "}";
+}
+
+static void writeReport(std::ostream& out, const BenchmarkOptions& options, const char* backend,
+                        size_t cubeCount, double startupMs, double texturesMs, const std::vector<FrameResult>& frames)
+{
+    std::vector<double> frameTimes, cpu, gpu, drawCalls, stateChanges, skippedBinds, allocations;
+    for (const FrameResult& frame : frames)
+    {
+        frameTimes.push_back(frame.frameMs);
+        cpu.push_back(frame.cpuMs);
+        gpu.push_back(frame.gpuMs);
+        drawCalls.push_back(frame.stats.drawCalls);
+        stateChanges.push_back(frame.stats.StateChanges());
+        skippedBinds.push_back(frame.stats.skippedBinds);
+        allocations.push_back((double)frame.allocations);
+    }
+
+    out << "{\n  \"backend\": ";
+    writeString(out, backend);
+    out << ",\n  \"renderer\": ";
+    writeString(out, (const char*)glGetString(GL_RENDERER));
+    out << ",\n  \"version\": ";
+    writeString(out, (const char*)glGetString(GL_VERSION));
+    out << ",\n  \"width\": " << options.width << ", \"height\": " << options.height
+        << ", \"frames\": " << options.frames << ", \"warmup\": " << options.warmup
+        << ",\n  \"scene\": {\"clustered\": " << (options.scene.clusteredLighting ? "true" : "false")
+        << ", \"instanced\": " << (options.scene.instancedDrawing ? "true" : "false")
+        << ", \"render_queue\": " << (options.scene.renderQueue ? "true" : "false")
+        << ", \"culling\": " << (options.scene.frustumCulling ? "true" : "false")
+        << ", \"bvh_culling\": " << (options.scene.hierarchicalCulling ? "true" : "false")
+        << ", \"cull_path\": ";
+    writeString(out, Engine::Graphics::GetCullPathName(Engine::Graphics::GetBestCullPath()));
+    // Off when the driver can't run it, as the scene then culls on the CPU
+    out << ", \"gpu_culling\": " << (options.scene.gpuCulling && Engine::Graphics::GpuCuller::IsSupported() ? "true" : "false");
+    out << ", \"batched\": " << (options.scene.batchedDrawing ? "true" : "false")
+        << ", \"batch_path\": ";
+    // Paths the driver lacks fall back to the best supported one
+    writeString(out, Engine::Graphics::GetBatchPathName(Engine::Graphics::IsBatchPathSupported(options.scene.batchPath)
+                                                            ? options.scene.batchPath : Engine::Graphics::BatchPath::Best));
+    out << ", \"vertex_format\": ";
+    writeString(out, Engine::Graphics::GetVertexFormatName(
+                         Engine::Graphics::GeometryArena::GetStorageFormat(options.vertexFormat)));
+    out << ", \"point_lights\": " << Scene::ANIMATED_POINT_LIGHTS + options.scene.extraPointLights
+        << ", \"cubes\": " << cubeCount << ", \"detail_meshes\": " << options.scene.detailMeshes
+        << ", \"meshlet_culling\": " << (options.scene.meshletCulling ? "true" : "false") << "}"
+        << ",\n  \"startup_ms\": " << startupMs << ", \"textures_ms\": " << texturesMs
+        << ", \"program_cache\": {\"enabled\": " << (Engine::Graphics::ProgramCache::IsEnabled() ? "true" : "false")
+        << ", \"hits\": " << Engine::Graphics::ProgramCache::GetHits()
+        << ", \"misses\": " << Engine::Graphics::ProgramCache::GetMisses() << "}"
+        << ",\n  \"summary\": {\n    \"frame_ms\": ";
+    writeDistribution(out, frameTimes);
+    out << ",\n    \"cpu_ms\": ";
+    writeDistribution(out, cpu);
+    out << ",\n    \"gpu_ms\": ";
+    writeDistribution(out, gpu);
+    out << ",\n    \"draw_calls\": ";
+    writeDistribution(out, drawCalls);
+    out << ",\n    \"state_changes\": ";
+    writeDistribution(out, stateChanges);
+    out << ",\n    \"skipped_binds\": ";
+    writeDistribution(out, skippedBinds);
+    out << ",\n    \"allocations\": ";
+    writeDistribution(out, allocations);
+    out << "\n  },\n  \"frames\": [\n";
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        const FrameResult& frame = frames[i];
+        out << "    {\"frame_ms\": " << frame.frameMs << ", \"cpu_ms\": " << frame.cpuMs << ", \"gpu_ms\": " << frame.gpuMs
+            << ", \"draw_calls\": " << frame.stats.drawCalls
+            << ", \"program_binds\": " << frame.stats.programBinds
+            << ", \"texture_binds\": " << frame.stats.textureBinds
+            << ", \"vertex_array_binds\": " << frame.stats.vertexArrayBinds
+            << ", \"buffer_binds\": " << frame.stats.bufferBinds
+            << ", \"buffer_uploads\": " << frame.stats.bufferUploads
+            << ", \"uniform_uploads\": " << frame.stats.uniformUploads
+            << ", \"state_changes\": " << frame.stats.StateChanges()
+            << ", \"skipped_binds\": " << frame.stats.skippedBinds
+            << ", \"visible_cubes\": " << frame.visibleCubes
+            << ", \"allocations\": " << frame.allocations << "}"
+            << (i + 1 < frames.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}" << std::endl;
+}
+
+// Loads the GL entry points of a new offscreen context; prints the problem and returns false on failure
+static bool initContext(Engine::Graphics::OffscreenContext& context)
+{
+    if (!context.IsValid())
+    {
+        std::cerr << "Failed to create an offscreen OpenGL context" << std::endl;
+        return false;
+    }
+
+    // Core profile contexts need experimental mode to load every entry point
+    glewExperimental = GL_TRUE;
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW built for GLX still loads the core functions of an EGL context before failing on GLX
+    if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY)
+        glewStatus = GLEW_OK;
+#endif
+    if (glewStatus != GLEW_OK)
+    {
+        std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(glewStatus) << std::endl;
+        context.Delete();
+        return false;
+    }
+    // GLEW may leave an error from probing extensions
+    while (glGetError() != GL_NO_ERROR)
+        ;
+    return true;
+}
+
+int RunBenchmark(const BenchmarkOptions& options)
+{
+    Engine::Graphics::OffscreenContext context;
+    if (!initContext(context))
+        return -1;
+
+    int exitCode = 0;
+    {
+        Engine::Graphics::Buffers::FBO framebuffer(options.width, options.height);
+        if (!framebuffer.IsComplete())
+        {
+            std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+            framebuffer.Delete();
+            context.Delete();
+            return -1;
+        }
+
+        // Startup covers shader compilation (or program cache loads) until the scene can render with
+        // placeholder textures; textures_ms additionally waits for the background texture loads
+        Engine::Graphics::ProgramCache::SetDirectory(options.programCache);
+        auto loadStart = std::chrono::steady_clock::now();
+        Engine::Graphics::Camera camera;
+        Engine::Graphics::LightManager lightManager;
+        Scene scene(lightManager, camera, options.vertexFormat);
+        double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        scene.FinishLoading();
+        double texturesMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        scene.ApplySettings(options.scene);
+
+        framebuffer.Bind();
+        glViewport(0, 0, options.width, options.height);
+        glEnable(GL_DEPTH_TEST);
+
+        GLuint queries[QUERY_RING];
+        int queryFrame[QUERY_RING];
+        glGenQueries(QUERY_RING, queries);
+        std::fill(queryFrame, queryFrame + QUERY_RING, -1);
+
+        std::vector<FrameResult> results(options.frames);
+        const int totalFrames = options.warmup + options.frames;
+        const glm::vec2 viewportSize(options.width, options.height);
+        const float aspect = (float)options.width / (float)options.height;
+
+        auto previousStart = std::chrono::steady_clock::now();
+        for (int frame = 0; frame <= totalFrames; frame++)
+        {
+            // The extra iteration only waits for the last frame and closes its time
+            if (frame == totalFrames)
+                glFinish();
+            auto frameStart = std::chrono::steady_clock::now();
+            if (frame > options.warmup)
+                results[frame - options.warmup - 1].frameMs =
+                    std::chrono::duration<double, std::milli>(frameStart - previousStart).count();
+            previousStart = frameStart;
+            if (frame == totalFrames)
+                break;
+
+            int slot = frame % QUERY_RING;
+            if (queryFrame[slot] >= 0)
+            {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+                results[queryFrame[slot]].gpuMs = elapsed / 1e6;
+            }
+
+            placeCamera(camera, frame, totalFrames);
+            // Only records anything when tracing, which enables the profiler for the GPU track
+            Engine::Graphics::Profiler::BeginFrame();
+            Engine::Graphics::RenderStats::Reset();
+            size_t allocationsBefore = Engine::Core::GetAllocationCount();
+            auto start = std::chrono::steady_clock::now();
+            glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // Fixed 60 Hz time step so every run animates the same way
+            scene.Update(frame / 60.0f, camera);
+            scene.Render(camera, viewportSize, aspect);
+
+            glEndQuery(GL_TIME_ELAPSED);
+            Engine::Graphics::Profiler::EndFrame();
+            auto end = std::chrono::steady_clock::now();
+            size_t allocations = Engine::Core::GetAllocationCount() - allocationsBefore;
+
+            int measured = frame - options.warmup;
+            queryFrame[slot] = measured;
+            if (measured >= 0)
+            {
+                results[measured].cpuMs = std::chrono::duration<double, std::milli>(end - start).count();
+                results[measured].stats = Engine::Graphics::RenderStats::Current();
+                results[measured].allocations = allocations;
+                results[measured].visibleCubes = scene.GetVisibleCubeCount();
+            }
+        }
+
+        for (int slot = 0; slot < QUERY_RING; slot++)
+        {
+            if (queryFrame[slot] >= 0)
+            {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+                results[queryFrame[slot]].gpuMs = elapsed / 1e6;
+            }
+        }
+        glDeleteQueries(QUERY_RING, queries);
+
+        GLenum err;
+        while ((err = glGetError()) != GL_NO_ERROR)
+        {
+            std::cerr << "OpenGL error during benchmark: " << err << std::endl;
+            exitCode = -1;
+        }
+
+        if (options.output.empty())
+        {
+            writeReport(std::cout, options, context.GetBackend(), scene.GetCubeCount(), startupMs, texturesMs, results);
+        }
+        else
+        {
+            std::ofstream file(options.output);
+            if (!file)
+            {
+                std::cerr << "Failed to open " << options.output << std::endl;
+                exitCode = -1;
+            }
+            else
+            {
+                writeReport(file, options, context.GetBackend(), scene.GetCubeCount(), startupMs, texturesMs, results);
+            }
+        }
+
+        if (!options.trace.empty() && !Engine::Core::TraceRecorder::Write(options.trace))
+        {
+            std::cerr << "Failed to write " << options.trace << std::endl;
+            exitCode = -1;
+        }
+
+        framebuffer.Unbind();
+        framebuffer.Delete();
+        scene.Delete();
+        Engine::Graphics::Profiler::Delete();
+    }
+
+    context.Delete();
+    return exitCode;
+}
+
+// Boxes of random size scattered around the camera orbit, seeded so every run uses the same set
+static std::vector<Engine::Graphics::AABB> randomBoxes(int count)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-FAR_PLANE, FAR_PLANE);
+    std::uniform_real_distribution<float> size(0.5f, 2.0f);
+    std::vector<Engine::Graphics::AABB> boxes(count);
+    for (Engine::Graphics::AABB& box : boxes)
+    {
+        glm::vec3 center(position(rng), position(rng), position(rng));
+        glm::vec3 extent(size(rng), size(rng), size(rng));
+        box.min = center - extent * 0.5f;
+        box.max = center + extent * 0.5f;
+    }
+    return boxes;
+}
+
+// Opens the output file if there is one; the report goes to stdout otherwise
+static bool openOutput(const BenchmarkOptions& options, std::ofstream& file)
+{
+    if (options.output.empty())
+        return true;
+    file.open(options.output);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << options.output << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int RunCullingBenchmark(const BenchmarkOptions& options)
+{
+    std::vector<Engine::Graphics::AABB> boxes = randomBoxes(options.cullObjects);
+    Engine::Graphics::CullBounds bounds;
+    bounds.Reserve(boxes.size());
+    for (const Engine::Graphics::AABB& box : boxes)
+        bounds.Add(box.min, box.max);
+
+    Engine::Graphics::Camera camera;
+    placeCamera(camera, 0, 1);
+    Engine::Graphics::Frustum frustum =
+        camera.GetFrustum((float)options.width / (float)options.height, NEAR_PLANE, FAR_PLANE);
+
+    // The per-object loop over the array of boxes is the baseline every path is compared against
+    std::vector<uint32_t> expected;
+    expected.reserve(bounds.GetPaddedCount());
+    std::vector<uint32_t> visible(bounds.GetPaddedCount());
+
+    struct PathResult
+    {
+        const char* name;
+        std::vector<double> times;
+        size_t visible = 0;
+        bool matches = true;
+    };
+    std::vector<PathResult> results;
+
+    const int totalRuns = options.warmup + options.frames;
+    PathResult reference;
+    reference.name = "reference";
+    for (int run = 0; run < totalRuns; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        expected.clear();
+        for (int i = 0; i < options.cullObjects; i++)
+        {
+            if (frustum.IntersectsAABB(boxes[i].min, boxes[i].max))
+                expected.push_back((uint32_t)i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (run >= options.warmup)
+            reference.times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    reference.visible = expected.size();
+    results.push_back(reference);
+
+    const Engine::Graphics::CullPath paths[] = {Engine::Graphics::CullPath::Scalar, Engine::Graphics::CullPath::SSE,
+                                                Engine::Graphics::CullPath::AVX, Engine::Graphics::CullPath::NEON};
+    for (Engine::Graphics::CullPath path : paths)
+    {
+        if (!Engine::Graphics::IsCullPathSupported(path))
+            continue;
+        PathResult result;
+        result.name = Engine::Graphics::GetCullPathName(path);
+        for (int run = 0; run < totalRuns; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            result.visible = Engine::Graphics::CullAABBs(frustum, bounds, visible.data(), path);
+            auto end = std::chrono::steady_clock::now();
+            if (run >= options.warmup)
+                result.times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        result.matches = result.visible == expected.size()
+                         && std::equal(expected.begin(), expected.end(), visible.begin());
+        results.push_back(result);
+    }
+
+    std::ofstream file;
+    if (!openOutput(options, file))
+        return -1;
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    out << "{\n  \"objects\": " << options.cullObjects << ", \"runs\": " << options.frames
+        << ", \"warmup\": " << options.warmup << ", \"best_path\": ";
+    writeString(out, Engine::Graphics::GetCullPathName(Engine::Graphics::GetBestCullPath()));
+    out << ",\n  \"paths\": [\n";
+    bool allMatch = true;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const PathResult& result = results[i];
+        allMatch = allMatch && result.matches;
+        out << "    {\"path\": ";
+        writeString(out, result.name);
+        out << ", \"visible\": " << result.visible << ", \"matches_reference\": " << (result.matches ? "true" : "false")
+            << ", \"ms\": ";
+        writeDistribution(out, result.times);
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}" << std::endl;
+
+    // Boxes exactly touching a plane may round differently, so a mismatch is reported but not an error
+    if (!allMatch)
+        std::cerr << "Culling paths disagree with the reference loop" << std::endl;
+    return 0;
+}
+
+int RunBVHBenchmark(const BenchmarkOptions& options)
+{
+    const int QUERIES = 1024;
+    // Queries checked against brute force loops, which are too slow to run for every query
+    const int CHECKED_QUERIES = 32;
+
+    std::vector<Engine::Graphics::AABB> boxes = randomBoxes(options.bvhObjects);
+    const int totalRuns = options.warmup + options.frames;
+    auto timeRuns = [&](auto&& body) {
+        std::vector<double> times;
+        for (int run = 0; run < totalRuns; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+            if (run >= options.warmup)
+                times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return times;
+    };
+
+    Engine::Graphics::BVH bvh;
+    std::vector<double> buildTimes = timeRuns([&]() { bvh.Build(boxes); });
+    float builtCost = bvh.GetCost();
+
+    // Every refit moves a different tenth of the boxes a little, as animated objects would
+    std::mt19937 rng(5678);
+    std::uniform_int_distribution<int> pickObject(0, options.bvhObjects - 1);
+    std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+    const int moved = std::max(1, options.bvhObjects / 10);
+    std::vector<double> refitTimes = timeRuns([&]() {
+        for (int i = 0; i < moved; i++)
+        {
+            uint32_t object = (uint32_t)pickObject(rng);
+            glm::vec3 offset(step(rng), step(rng), step(rng));
+            boxes[object].min += offset;
+            boxes[object].max += offset;
+            bvh.SetBounds(object, boxes[object]);
+        }
+        bvh.Refit();
+    });
+    float refittedCost = bvh.GetCost();
+    Engine::Graphics::BVH rebuilt;
+    rebuilt.Build(boxes);
+    float rebuiltCost = rebuilt.GetCost();
+
+    // Frustum culling against the batched linear test
+    Engine::Graphics::Camera camera;
+    placeCamera(camera, 0, 1);
+    const float aspect = (float)options.width / (float)options.height;
+    Engine::Graphics::Frustum frustum = camera.GetFrustum(aspect, NEAR_PLANE, FAR_PLANE);
+    Engine::Graphics::CullBounds cullBounds;
+    cullBounds.Reserve(boxes.size());
+    for (const Engine::Graphics::AABB& box : boxes)
+        cullBounds.Add(box.min, box.max);
+    std::vector<uint32_t> bvhVisible(boxes.size()), linearVisible(cullBounds.GetPaddedCount());
+    size_t bvhVisibleCount = 0, linearVisibleCount = 0;
+    std::vector<double> bvhFrustumTimes = timeRuns([&]() { bvhVisibleCount = bvh.QueryFrustum(frustum, bvhVisible.data()); });
+    std::vector<double> linearFrustumTimes = timeRuns([&]() {
+        linearVisibleCount = Engine::Graphics::CullAABBs(frustum, cullBounds, linearVisible.data());
+    });
+    std::sort(bvhVisible.begin(), bvhVisible.begin() + bvhVisibleCount);
+    bool frustumMatches = bvhVisibleCount == linearVisibleCount
+                          && std::equal(bvhVisible.begin(), bvhVisible.begin() + bvhVisibleCount, linearVisible.begin());
+
+    // Rays through random cursor positions, as picking casts them
+    std::uniform_real_distribution<float> cursorX(0.0f, (float)options.width), cursorY(0.0f, (float)options.height);
+    std::vector<glm::vec3> rays(QUERIES);
+    for (glm::vec3& ray : rays)
+        ray = camera.GetCursorRay(glm::vec2(cursorX(rng), cursorY(rng)), glm::vec2(options.width, options.height), aspect);
+    std::vector<Engine::Graphics::BVHHit> hits(QUERIES);
+    std::vector<unsigned char> hitFound(QUERIES);
+    std::vector<double> rayTimes = timeRuns([&]() {
+        for (int i = 0; i < QUERIES; i++)
+            hitFound[i] = bvh.Raycast(camera.Position, rays[i], FAR_PLANE, hits[i]);
+    });
+    size_t hitCount = std::count(hitFound.begin(), hitFound.end(), 1);
+    bool raysMatch = true;
+    for (int i = 0; i < CHECKED_QUERIES; i++)
+    {
+        // The closest entry distance over every box with the same slab test
+        glm::vec3 inverseDirection = 1.0f / rays[i];
+        float closest = FAR_PLANE;
+        bool found = false;
+        for (const Engine::Graphics::AABB& box : boxes)
+        {
+            glm::vec3 t0 = (box.min - camera.Position) * inverseDirection;
+            glm::vec3 t1 = (box.max - camera.Position) * inverseDirection;
+            glm::vec3 entering = glm::min(t0, t1), leaving = glm::max(t0, t1);
+            float enter = std::max(std::max(entering.x, entering.y), std::max(entering.z, 0.0f));
+            float exit = std::min(std::min(leaving.x, leaving.y), std::min(leaving.z, closest));
+            if (enter <= exit)
+            {
+                closest = enter;
+                found = true;
+            }
+        }
+        raysMatch = raysMatch && found == (bool)hitFound[i] && (!found || closest == hits[i].distance);
+    }
+
+    // Spheres the size of point light ranges, as light culling queries them
+    std::uniform_real_distribution<float> position(-FAR_PLANE, FAR_PLANE), radius(2.0f, 10.0f);
+    std::vector<glm::vec4> spheres(QUERIES);
+    for (glm::vec4& sphere : spheres)
+        sphere = glm::vec4(position(rng), position(rng), position(rng), radius(rng));
+    std::vector<uint32_t> overlapping(boxes.size());
+    size_t overlapCount = 0;
+    std::vector<double> sphereTimes = timeRuns([&]() {
+        overlapCount = 0;
+        for (const glm::vec4& sphere : spheres)
+            overlapCount += bvh.QuerySphere(glm::vec3(sphere), sphere.w, overlapping.data());
+    });
+    bool spheresMatch = true;
+    for (int i = 0; i < CHECKED_QUERIES; i++)
+    {
+        size_t expected = 0;
+        for (const Engine::Graphics::AABB& box : boxes)
+            expected += Engine::Graphics::SphereIntersectsAABB(glm::vec3(spheres[i]), spheres[i].w, box.min, box.max);
+        spheresMatch = spheresMatch && expected == bvh.QuerySphere(glm::vec3(spheres[i]), spheres[i].w, overlapping.data());
+    }
+
+    std::ofstream file;
+    if (!openOutput(options, file))
+        return -1;
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    out << "{\n  \"objects\": " << options.bvhObjects << ", \"nodes\": " << bvh.GetNodeCount()
+        << ", \"runs\": " << options.frames << ", \"warmup\": " << options.warmup
+        << ",\n  \"build_ms\": ";
+    writeDistribution(out, buildTimes);
+    out << ",\n  \"refit\": {\"moved_objects\": " << moved << ", \"ms\": ";
+    writeDistribution(out, refitTimes);
+    out << "},\n  \"sah_cost\": {\"built\": " << builtCost << ", \"refitted\": " << refittedCost
+        << ", \"rebuilt\": " << rebuiltCost << "}"
+        << ",\n  \"frustum\": {\"visible\": " << bvhVisibleCount << ", \"matches_linear\": " << (frustumMatches ? "true" : "false")
+        << ", \"bvh_ms\": ";
+    writeDistribution(out, bvhFrustumTimes);
+    out << ", \"linear_ms\": ";
+    writeDistribution(out, linearFrustumTimes);
+    out << "},\n  \"rays\": {\"count\": " << QUERIES << ", \"hits\": " << hitCount
+        << ", \"matches_brute_force\": " << (raysMatch ? "true" : "false") << ", \"ms\": ";
+    writeDistribution(out, rayTimes);
+    out << "},\n  \"spheres\": {\"count\": " << QUERIES << ", \"overlaps\": " << overlapCount
+        << ", \"matches_brute_force\": " << (spheresMatch ? "true" : "false") << ", \"ms\": ";
+    writeDistribution(out, sphereTimes);
+    out << "}\n}" << std::endl;
+
+    if (!frustumMatches || !raysMatch || !spheresMatch)
+        std::cerr << "BVH queries disagree with the linear loops" << std::endl;
+    return 0;
+}
+
+// Bumps all over the benchmarks' sphere give it concavities that overdraw ordering can matter for
+static const float MESH_BUMP_HEIGHT = 0.3f;
+
+int RunMeshBenchmark(const BenchmarkOptions& options)
+{
+    // Views the mesh is drawn from for the pipeline statistics
+    const int VIEWS = 8;
+
+    // Triangles in a random order stand in for a mesh exported without any care for the GPU
+    Engine::Graphics::IndexedGeometry source =
+        Engine::Graphics::CreateSphereGeometry(options.meshSegments, MESH_BUMP_HEIGHT);
+    std::vector<GLuint> shuffled = source.indices;
+    {
+        std::vector<size_t> order(shuffled.size() / 3);
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::mt19937 rng(1234);
+        std::shuffle(order.begin(), order.end(), rng);
+        for (size_t i = 0; i < order.size(); i++)
+            std::copy_n(&source.indices[order[i] * 3], 3, &shuffled[i * 3]);
+    }
+
+    const int totalRuns = options.warmup + options.frames;
+    auto timeRuns = [&](auto&& body) {
+        std::vector<double> times;
+        for (int run = 0; run < totalRuns; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+            if (run >= options.warmup)
+                times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return times;
+    };
+
+    // Each pass works on the output of the one before, as OptimizeMesh runs them
+    struct Stage
+    {
+        const char* name;
+        std::vector<Engine::Graphics::Vertex> vertices;
+        std::vector<GLuint> indices;
+        std::vector<double> times;
+        GLuint64 vertexInvocations = 0;
+        GLuint64 fragmentInvocations = 0;
+    };
+    std::vector<Stage> stages(4);
+    stages[0].name = "shuffled";
+    stages[0].vertices = source.vertices;
+    stages[0].indices = shuffled;
+
+    stages[1].name = "vertex_cache";
+    stages[1].vertices = source.vertices;
+    stages[1].times = timeRuns([&]() {
+        stages[1].indices = Engine::Graphics::OptimizeVertexCache(shuffled, source.vertices.size());
+    });
+
+    stages[2].name = "overdraw";
+    stages[2].vertices = source.vertices;
+    stages[2].times = timeRuns([&]() {
+        stages[2].indices = Engine::Graphics::OptimizeOverdraw(stages[1].indices, source.vertices);
+    });
+
+    stages[3].name = "vertex_fetch";
+    stages[3].times = timeRuns([&]() {
+        stages[3].vertices = source.vertices;
+        stages[3].indices = stages[2].indices;
+        Engine::Graphics::OptimizeVertexFetch(stages[3].vertices, stages[3].indices);
+    });
+
+    // Shader invocations of every order, counted by pipeline statistics queries where the driver has them
+    bool statisticsSupported = false;
+    Engine::Graphics::OffscreenContext context;
+    if (initContext(context))
+    {
+        statisticsSupported = GLEW_VERSION_4_6 || GLEW_ARB_pipeline_statistics_query;
+        Engine::Graphics::Buffers::FBO framebuffer(options.width, options.height);
+        if (statisticsSupported && framebuffer.IsComplete())
+        {
+            Engine::Graphics::Shader shader("../shaders/light.vert", "../shaders/light.frag");
+            shader.Activate();
+            shader.setMat4("model", glm::mat4(1.0f));
+            shader.setMat4("proj", glm::perspective(glm::radians(45.0f), (float)options.width / (float)options.height,
+                                                    NEAR_PLANE, FAR_PLANE));
+            shader.setVec3("lightColor", glm::vec3(1.0f));
+
+            framebuffer.Bind();
+            glViewport(0, 0, options.width, options.height);
+            glEnable(GL_DEPTH_TEST);
+            GLuint queries[2];
+            glGenQueries(2, queries);
+            for (Stage& stage : stages)
+            {
+                Engine::Graphics::Buffers::VAO vao;
+                vao.Bind();
+                Engine::Graphics::Buffers::VBO vbo(stage.vertices.data(),
+                                                   stage.vertices.size() * sizeof(Engine::Graphics::Vertex));
+                Engine::Graphics::Buffers::EBO ebo(stage.indices.data(), stage.indices.size() * sizeof(GLuint));
+                vao.LinkAttrib(vbo, 0, 3, GL_FLOAT, sizeof(Engine::Graphics::Vertex), (void*)0);
+
+                glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS, queries[0]);
+                glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, queries[1]);
+                for (int view = 0; view < VIEWS; view++)
+                {
+                    float angle = glm::two_pi<float>() * view / VIEWS;
+                    glm::vec3 eye(3.5f * glm::cos(angle), 1.5f * glm::sin(2.0f * angle), 3.5f * glm::sin(angle));
+                    shader.setMat4("view", glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    glDrawElements(GL_TRIANGLES, (GLsizei)stage.indices.size(), GL_UNSIGNED_INT, nullptr);
+                }
+                glEndQuery(GL_VERTEX_SHADER_INVOCATIONS);
+                glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+                glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &stage.vertexInvocations);
+                glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &stage.fragmentInvocations);
+
+                ebo.Delete();
+                vbo.Delete();
+                vao.Delete();
+            }
+            glDeleteQueries(2, queries);
+            shader.Delete();
+        }
+        else
+            statisticsSupported = false;
+        framebuffer.Delete();
+        context.Delete();
+    }
+
+    // Size of the vertices in each format, and the largest error decoding them brings
+    struct FormatResult
+    {
+        Engine::Graphics::VertexFormat format;
+        size_t bytes = 0;
+        float positionError = 0.0f;
+        float texCoordError = 0.0f;
+        float normalErrorDegrees = 0.0f;
+    };
+    std::vector<FormatResult> formats;
+    glm::vec3 boundsMin = source.vertices[0].position, boundsMax = boundsMin;
+    for (const Engine::Graphics::Vertex& vertex : source.vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    for (Engine::Graphics::VertexFormat format : {Engine::Graphics::VertexFormat::Float, Engine::Graphics::VertexFormat::Compact,
+                                                  Engine::Graphics::VertexFormat::Quantized})
+    {
+        FormatResult result;
+        result.format = format;
+        std::vector<unsigned char> encoded = Engine::Graphics::EncodeVertices(source.vertices, format, boundsMin, boundsMax);
+        std::vector<Engine::Graphics::Vertex> decoded =
+            Engine::Graphics::DecodeVertices(encoded.data(), source.vertices.size(), format, boundsMin, boundsMax);
+        result.bytes = encoded.size();
+        for (size_t i = 0; i < decoded.size(); i++)
+        {
+            const Engine::Graphics::Vertex& original = source.vertices[i];
+            result.positionError = std::max(result.positionError, glm::length(decoded[i].position - original.position));
+            result.texCoordError = std::max(result.texCoordError, glm::length(decoded[i].texCoords - original.texCoords));
+            // The angle from its sine and cosine, as acos alone is too coarse near 0
+            float angle = std::atan2(glm::length(glm::cross(decoded[i].normal, original.normal)),
+                                     glm::dot(decoded[i].normal, original.normal));
+            result.normalErrorDegrees = std::max(result.normalErrorDegrees, glm::degrees(angle));
+        }
+        formats.push_back(result);
+    }
+
+    std::ofstream file;
+    if (!openOutput(options, file))
+        return -1;
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    out << "{\n  \"vertices\": " << source.vertices.size() << ", \"triangles\": " << source.indices.size() / 3
+        << ", \"runs\": " << options.frames << ", \"warmup\": " << options.warmup
+        << ", \"pipeline_statistics\": " << (statisticsSupported ? "true" : "false") << ", \"views\": " << VIEWS
+        << ",\n  \"stages\": [\n";
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        const Stage& stage = stages[i];
+        Engine::Graphics::VertexCacheStats cache16 =
+            Engine::Graphics::AnalyzeVertexCache(stage.indices, stage.vertices.size(), 16);
+        Engine::Graphics::VertexCacheStats cache32 =
+            Engine::Graphics::AnalyzeVertexCache(stage.indices, stage.vertices.size(), 32);
+        out << "    {\"stage\": ";
+        writeString(out, stage.name);
+        out << ", \"acmr_16\": " << cache16.acmr << ", \"atvr_16\": " << cache16.atvr
+            << ", \"acmr_32\": " << cache32.acmr << ", \"atvr_32\": " << cache32.atvr;
+        if (statisticsSupported)
+        {
+            out << ", \"vertex_shader_invocations\": " << stage.vertexInvocations
+                << ", \"fragment_shader_invocations\": " << stage.fragmentInvocations;
+        }
+        if (!stage.times.empty())
+        {
+            out << ", \"ms\": ";
+            writeDistribution(out, stage.times);
+        }
+        out << "}" << (i + 1 < stages.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n  \"vertex_formats\": [\n";
+    for (size_t i = 0; i < formats.size(); i++)
+    {
+        const FormatResult& result = formats[i];
+        out << "    {\"format\": ";
+        writeString(out, Engine::Graphics::GetVertexFormatName(result.format));
+        out << ", \"vertex_bytes\": " << Engine::Graphics::GetVertexSize(result.format) << ", \"bytes\": " << result.bytes
+            << ", \"max_position_error\": " << result.positionError << ", \"max_tex_coord_error\": " << result.texCoordError
+            << ", \"max_normal_error_degrees\": " << result.normalErrorDegrees << "}"
+            << (i + 1 < formats.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}" << std::endl;
+    return 0;
+}
+
+int RunLodBenchmark(const BenchmarkOptions& options)
+{
+    // Mesh::GenerateLods' defaults
+    const size_t MAX_LODS = 4;
+    const float RATIO = 0.5f;
+    const float MAX_ERROR = 0.02f;
+
+    // Prepared as Mesh prepares every mesh before its levels are generated
+    Engine::Graphics::IndexedGeometry geometry =
+        Engine::Graphics::CreateSphereGeometry(options.meshSegments, MESH_BUMP_HEIGHT);
+    Engine::Graphics::OptimizeMesh(geometry);
+    glm::vec3 boundsMin = geometry.vertices[0].position, boundsMax = boundsMin;
+    for (const Engine::Graphics::Vertex& vertex : geometry.vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = 0.0f;
+    for (const Engine::Graphics::Vertex& vertex : geometry.vertices)
+        radius = std::max(radius, glm::length(vertex.position - center));
+
+    std::vector<GLuint> indices;
+    std::vector<Engine::Graphics::MeshLod> lods;
+    std::vector<double> times;
+    for (int run = 0; run < options.warmup + options.frames; run++)
+    {
+        indices = geometry.indices;
+        auto start = std::chrono::steady_clock::now();
+        lods = Engine::Graphics::BuildLodChain(indices, geometry.vertices, MAX_ERROR * radius, MAX_LODS, RATIO);
+        auto end = std::chrono::steady_clock::now();
+        if (run >= options.warmup)
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::ofstream file;
+    if (!openOutput(options, file))
+        return -1;
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    const float fovY = Engine::Graphics::Camera().GetZoom();
+    out << "{\n  \"vertices\": " << geometry.vertices.size() << ", \"triangles\": " << geometry.indices.size() / 3
+        << ", \"radius\": " << radius << ", \"runs\": " << options.frames << ", \"warmup\": " << options.warmup
+        << ", \"viewport_height\": " << options.height << ", \"fov_y\": " << fovY
+        << ",\n  \"generate_ms\": ";
+    writeDistribution(out, times);
+    out << ",\n  \"lods\": [\n";
+    for (size_t i = 0; i < lods.size(); i++)
+    {
+        const Engine::Graphics::MeshLod& lod = lods[i];
+        std::vector<GLuint> lodIndices(indices.begin() + lod.firstIndex, indices.begin() + lod.firstIndex + lod.indexCount);
+        Engine::Graphics::VertexCacheStats cache =
+            Engine::Graphics::AnalyzeVertexCache(lodIndices, geometry.vertices.size());
+        // From this distance (to the front of the bounding sphere) on, the level's error is under a pixel
+        out << "    {\"lod\": " << i << ", \"triangles\": " << lod.indexCount / 3
+            << ", \"triangle_ratio\": " << (double)lod.indexCount / lods[0].indexCount << ", \"error\": " << lod.error
+            << ", \"relative_error\": " << lod.error / radius
+            << ", \"selected_from\": " << Engine::Graphics::GetLodDistance(lod.error, fovY, (float)options.height)
+            << ", \"acmr\": " << cache.acmr << "}" << (i + 1 < lods.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}" << std::endl;
+    return 0;
+}
+
+int RunMeshletBenchmark(const BenchmarkOptions& options)
+{
+    // Mesh::BuildMeshlets' defaults
+    const size_t MAX_VERTICES = 64;
+    const size_t MAX_TRIANGLES = 124;
+    // Copies of the mesh on a grid around the orbit's center, some of them behind the camera at times
+    const int GRID = 7;
+    const float SPACING = 3.0f;
+    // Camera positions along the orbit
+    const int VIEWS = 8;
+
+    // Prepared as Mesh prepares every mesh before its meshlets are built
+    Engine::Graphics::IndexedGeometry geometry =
+        Engine::Graphics::CreateSphereGeometry(options.meshSegments, MESH_BUMP_HEIGHT);
+    Engine::Graphics::OptimizeMesh(geometry);
+
+    const int totalRuns = options.warmup + options.frames;
+    auto timeRuns = [&](auto&& body) {
+        std::vector<double> times;
+        for (int run = 0; run < totalRuns; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+            if (run >= options.warmup)
+                times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return times;
+    };
+
+    std::vector<GLuint> indices;
+    std::vector<Engine::Graphics::Meshlet> meshlets;
+    std::vector<double> buildTimes = timeRuns([&]() {
+        indices = geometry.indices;
+        meshlets = Engine::Graphics::BuildMeshlets(indices, 0, indices.size(), geometry.vertices, MAX_VERTICES,
+                                                   MAX_TRIANGLES);
+    });
+    size_t meshletVertices = 0, conedMeshlets = 0;
+    for (const Engine::Graphics::Meshlet& meshlet : meshlets)
+    {
+        meshletVertices += meshlet.vertexCount;
+        conedMeshlets += meshlet.coneCutoff <= 1.0f;
+    }
+
+    glm::vec3 boundsMin = geometry.vertices[0].position, boundsMax = boundsMin;
+    for (const Engine::Graphics::Vertex& vertex : geometry.vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = 0.0f;
+    for (const Engine::Graphics::Vertex& vertex : geometry.vertices)
+        radius = std::max(radius, glm::length(vertex.position - center));
+
+    std::vector<glm::mat4> models;
+    for (int x = 0; x < GRID; x++)
+    {
+        for (int z = 0; z < GRID; z++)
+            models.push_back(glm::translate(glm::mat4(1.0f), glm::vec3((x - GRID / 2) * SPACING, 0.0f, (z - GRID / 2) * SPACING)));
+    }
+
+    // Meshlet each triangle belongs to
+    std::vector<uint32_t> triangleMeshlet(indices.size() / 3);
+    for (size_t i = 0; i < meshlets.size(); i++)
+    {
+        for (GLuint t = meshlets[i].firstIndex / 3; t < (meshlets[i].firstIndex + meshlets[i].indexCount) / 3; t++)
+            triangleMeshlet[t] = (uint32_t)i;
+    }
+
+    // Per view, the triangles each way of culling submits and those that really are in view: facing the
+    // camera, not slivers (which cover no pixels) and not wholly outside any frustum plane. In view triangles of culled meshlets are counted as
+    // missed, which a conservative test never does.
+    struct ViewResult
+    {
+        size_t objects = 0;
+        size_t objectTriangles = 0;
+        size_t frustumTriangles = 0;
+        size_t frustumMeshlets = 0;
+        size_t coneTriangles = 0;
+        size_t coneMeshlets = 0;
+        size_t inViewTriangles = 0;
+        size_t missedTriangles = 0;
+        std::vector<double> cullTimes;
+    };
+    const float aspect = (float)options.width / (float)options.height;
+    std::vector<ViewResult> views(VIEWS);
+    std::vector<uint32_t> visible(meshlets.size());
+    std::vector<bool> kept(meshlets.size());
+    for (int view = 0; view < VIEWS; view++)
+    {
+        ViewResult& result = views[view];
+        Engine::Graphics::Camera camera;
+        placeCamera(camera, view, VIEWS);
+        Engine::Graphics::Frustum frustum = camera.GetFrustum(aspect, NEAR_PLANE, FAR_PLANE);
+
+        result.cullTimes = timeRuns([&]() {
+            for (const glm::mat4& model : models)
+            {
+                if (frustum.IntersectsSphere(glm::vec3(model * glm::vec4(center, 1.0f)), radius))
+                    Engine::Graphics::CullMeshlets(meshlets, model, frustum, camera.Position, visible.data());
+            }
+        });
+
+        for (const glm::mat4& model : models)
+        {
+            if (!frustum.IntersectsSphere(glm::vec3(model * glm::vec4(center, 1.0f)), radius))
+                continue;
+            result.objects++;
+            result.objectTriangles += indices.size() / 3;
+
+            size_t count =
+                Engine::Graphics::CullMeshlets(meshlets, model, frustum, camera.Position, visible.data(), false);
+            result.frustumMeshlets += count;
+            for (size_t i = 0; i < count; i++)
+                result.frustumTriangles += meshlets[visible[i]].indexCount / 3;
+
+            count = Engine::Graphics::CullMeshlets(meshlets, model, frustum, camera.Position, visible.data());
+            result.coneMeshlets += count;
+            std::fill(kept.begin(), kept.end(), false);
+            for (size_t i = 0; i < count; i++)
+            {
+                result.coneTriangles += meshlets[visible[i]].indexCount / 3;
+                kept[visible[i]] = true;
+            }
+
+            for (size_t t = 0; t < indices.size() / 3; t++)
+            {
+                glm::vec3 a = glm::vec3(model * glm::vec4(geometry.vertices[indices[t * 3]].position, 1.0f));
+                glm::vec3 b = glm::vec3(model * glm::vec4(geometry.vertices[indices[t * 3 + 1]].position, 1.0f));
+                glm::vec3 c = glm::vec3(model * glm::vec4(geometry.vertices[indices[t * 3 + 2]].position, 1.0f));
+                glm::vec3 normal = glm::cross(b - a, c - a);
+                if (glm::dot(normal, camera.Position - a) <= 0.0f
+                    || glm::length(normal)
+                           <= Engine::Graphics::MESHLET_MIN_AREA_RATIO * (glm::dot(b - a, b - a) + glm::dot(c - a, c - a)))
+                    continue;
+                bool outside = false;
+                for (const glm::vec4& plane : frustum.planes)
+                {
+                    outside = outside || (glm::dot(glm::vec3(plane), a) + plane.w < 0.0f
+                                          && glm::dot(glm::vec3(plane), b) + plane.w < 0.0f
+                                          && glm::dot(glm::vec3(plane), c) + plane.w < 0.0f);
+                }
+                if (outside)
+                    continue;
+                result.inViewTriangles++;
+                result.missedTriangles += !kept[triangleMeshlet[t]];
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (!openOutput(options, file))
+        return -1;
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    out << "{\n  \"vertices\": " << geometry.vertices.size() << ", \"triangles\": " << indices.size() / 3
+        << ", \"objects\": " << models.size() << ", \"runs\": " << options.frames << ", \"warmup\": " << options.warmup
+        << ",\n  \"meshlets\": {\"count\": " << meshlets.size() << ", \"max_vertices\": " << MAX_VERTICES
+        << ", \"max_triangles\": " << MAX_TRIANGLES
+        << ", \"average_vertices\": " << (double)meshletVertices / meshlets.size()
+        << ", \"average_triangles\": " << (double)indices.size() / 3 / meshlets.size()
+        << ", \"with_cone\": " << conedMeshlets << ", \"build_ms\": ";
+    writeDistribution(out, buildTimes);
+    out << "},\n  \"views\": [\n";
+    size_t totalObject = 0, totalFrustum = 0, totalCone = 0, totalInView = 0, totalMissed = 0;
+    for (int view = 0; view < VIEWS; view++)
+    {
+        const ViewResult& result = views[view];
+        totalObject += result.objectTriangles;
+        totalFrustum += result.frustumTriangles;
+        totalCone += result.coneTriangles;
+        totalInView += result.inViewTriangles;
+        totalMissed += result.missedTriangles;
+        out << "    {\"view\": " << view << ", \"visible_objects\": " << result.objects
+            << ", \"object_culled_triangles\": " << result.objectTriangles
+            << ", \"frustum_culled_meshlets\": " << result.frustumMeshlets
+            << ", \"frustum_culled_triangles\": " << result.frustumTriangles
+            << ", \"cone_culled_meshlets\": " << result.coneMeshlets
+            << ", \"cone_culled_triangles\": " << result.coneTriangles
+            << ", \"in_view_triangles\": " << result.inViewTriangles
+            << ", \"missed_triangles\": " << result.missedTriangles << ", \"cull_ms\": ";
+        writeDistribution(out, result.cullTimes);
+        out << "}" << (view + 1 < VIEWS ? ",\n" : "\n");
+    }
+    // Submitted triangles per triangle in view, over every view
+    out << "  ],\n  \"submitted_per_in_view\": {\"object_culled\": " << (double)totalObject / totalInView
+        << ", \"frustum_culled\": " << (double)totalFrustum / totalInView
+        << ", \"cone_culled\": " << (double)totalCone / totalInView << "}, \"missed_triangles\": " << totalMissed
+        << "\n}" << std::endl;
+
+    if (totalMissed != 0)
+        std::cerr << "Meshlet culling dropped triangles in view" << std::endl;
+    return 0;
+}
+
+int RunUniformBenchmark(const BenchmarkOptions& options)
+{
+    Engine::Graphics::OffscreenContext context;
+    if (!initContext(context))
+        return -1;
+
+    Engine::Graphics::Shader shader("../shaders/light.vert", "../shaders/light.frag");
+    shader.Activate();
+    const Engine::Graphics::Uniform model = shader.getUniform("model");
+    if (!model.valid())
+    {
+        std::cerr << "The light shader has no model uniform" << std::endl;
+        return -1;
+    }
+
+    // Two matrices set in turn, so every set differs from the one before and the shadow copy can't skip it
+    const glm::mat4 matrices[2] = {glm::mat4(1.0f), glm::translate(glm::mat4(1.0f), glm::vec3(1.0f))};
+    const int calls = options.uniformCalls;
+    const int totalRuns = options.warmup + options.frames;
+    auto timeRuns = [&](auto&& body) {
+        std::vector<double> times;
+        for (int run = 0; run < totalRuns; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+            if (run >= options.warmup)
+                times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            // Keeps the driver's queue of uploads from growing across runs
+            glFinish();
+        }
+        return times;
+    };
+
+    struct WayResult
+    {
+        const char* name;
+        std::vector<double> times;
+    };
+    std::vector<WayResult> ways;
+    // What Shader did before locations were cached: a driver lookup of the name on every set
+    ways.push_back({"get_uniform_location", timeRuns([&]() {
+                        for (int i = 0; i < calls; i++)
+                            glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, &matrices[i & 1][0][0]);
+                    })});
+    ways.push_back({"by_name", timeRuns([&]() {
+                        for (int i = 0; i < calls; i++)
+                            shader.setMat4("model", matrices[i & 1]);
+                    })});
+    ways.push_back({"cached_handle", timeRuns([&]() {
+                        for (int i = 0; i < calls; i++)
+                            shader.setMat4(model, matrices[i & 1]);
+                    })});
+    // The same value every time, which the shadow copy drops before it reaches the driver
+    shader.resetUniformStats();
+    ways.push_back({"shadow_skip", timeRuns([&]() {
+                        for (int i = 0; i < calls; i++)
+                            shader.setMat4(model, matrices[0]);
+                    })});
+    Engine::Graphics::UniformStats skipStats = shader.getUniformStats();
+
+    std::ofstream file;
+    if (!openOutput(options, file))
+        return -1;
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    out << "{\n  \"calls\": " << calls << ", \"runs\": " << options.frames << ", \"warmup\": " << options.warmup
+        << ", \"renderer\": ";
+    writeString(out, (const char*)glGetString(GL_RENDERER));
+    out << ",\n  \"ways\": [\n";
+    for (size_t i = 0; i < ways.size(); i++)
+    {
+        const WayResult& way = ways[i];
+        double meanMs = 0.0;
+        for (double time : way.times)
+            meanMs += time;
+        meanMs /= way.times.size();
+        out << "    {\"way\": ";
+        writeString(out, way.name);
+        out << ", \"calls_per_second\": " << (meanMs > 0.0 ? calls / (meanMs / 1000.0) : 0.0) << ", \"ms\": ";
+        writeDistribution(out, way.times);
+        out << "}" << (i + 1 < ways.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n  \"shadow_skip_uploads\": {\"issued\": " << skipStats.issued << ", \"skipped\": " << skipStats.skipped
+        << "}\n}" << std::endl;
+    return 0;
+}
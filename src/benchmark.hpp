@@ -0,0 +1,106 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <string>
+
+#include "scene.hpp"
+
+// Command line options of the headless benchmark:
+//   --bench                 render offscreen and report timings as JSON instead of opening a window
+//   --frames N              measured frames (default 300)
+//   --warmup N              frames rendered before measuring (default 30)
+//   --size WxH              framebuffer size (default 1280x720)
+//   --clustered             clustered lighting
+//   --instanced             instanced drawing
+//   --no-render-queue       issue per-object draws in code order instead of sorting them by state
+//   --batched               submit per-object draws as multi-draw batches
+//   --batch-path NAME       force a batch path: indirect, multi-draw or loop (default: best supported)
+//   --no-culling            draw every cube instead of only those in the view frustum
+//   --bvh-culling           cull the cubes through the bounding volume hierarchy
+//   --gpu-culling           cull the cubes in a compute shader and draw them indirectly (GL 4.3)
+//   --vertex-format NAME    vertex layout of the meshes: float, compact or quantized, which the scene stores
+//                           as compact (default float; also without --bench)
+//   --lights N              extra static point lights
+//   --cubes N               extra cubes
+//   --detail-meshes N       dense spheres drawn at a level of detail picked by their size on screen
+//   --no-meshlet-culling    draw full detail meshes whole, not only their meshlets in view and facing the camera
+//   --out FILE              write the JSON to a file instead of stdout
+//   --program-cache DIR     program binary cache directory (default shader_cache)
+//   --no-program-cache      always compile shaders from source
+//   --trace FILE            record a Chrome trace and write it on exit (also without --bench)
+//   --cull-bench            time frustum culling of random boxes on every CPU path instead of rendering
+//   --cull-objects N        boxes culled by --cull-bench (default 1000000)
+//   --bvh-bench             time building, refitting and querying a bounding volume hierarchy instead of rendering
+//   --bvh-objects N         boxes in the hierarchy of --bvh-bench (default 200000)
+//   --mesh-bench            time the mesh optimization passes on a generated mesh and compare their orders
+//   --mesh-segments N       segments around the mesh of --mesh-bench and --lod-bench, which has N * N triangles
+//                           (default 256)
+//   --lod-bench             generate levels of detail of the --mesh-bench mesh and report their size and error
+//   --uniform-bench         time setting a uniform by name, through a cached handle and with the shadow copy
+//                           skipping it instead of rendering
+//   --uniform-calls N       uniform sets per run of --uniform-bench (default 1000000)
+//   --meshlet-bench         split the --mesh-bench mesh into meshlets and report the triangles each way of
+//                           culling copies of it submits against those in view
+struct BenchmarkOptions
+{
+    bool enabled = false;
+    int frames = 300;
+    int warmup = 30;
+    int width = 1280;
+    int height = 720;
+    SceneSettings scene;
+    Engine::Graphics::VertexFormat vertexFormat = Engine::Graphics::VertexFormat::Float;
+    std::string output;
+    std::string programCache = "shader_cache";
+    std::string trace;
+    bool cullBenchmark = false;
+    int cullObjects = 1000000;
+    bool bvhBenchmark = false;
+    int bvhObjects = 200000;
+    bool meshBenchmark = false;
+    int meshSegments = 256;
+    bool lodBenchmark = false;
+    bool meshletBenchmark = false;
+    bool uniformBenchmark = false;
+    int uniformCalls = 1000000;
+};
+
+// Reads the benchmark options; prints the problem and returns false on an invalid command line
+bool ParseBenchmarkOptions(int argc, char** argv, BenchmarkOptions& options);
+
+// Renders the scene into an offscreen framebuffer along a fixed camera path and writes
+// per-frame CPU time, GPU time, draw calls and state changes as JSON. Returns the process exit code.
+int RunBenchmark(const BenchmarkOptions& options);
+
+// Culls random boxes against a fixed camera with a per-object Frustum::IntersectsAABB loop and with
+// CullAABBs on each supported path, and writes their timings as JSON. Needs no OpenGL context.
+int RunCullingBenchmark(const BenchmarkOptions& options);
+
+// Builds a BVH over random boxes, refits it while a tenth of them move, and times frustum, ray and sphere
+// queries against linear loops, writing the results as JSON. Needs no OpenGL context.
+int RunBVHBenchmark(const BenchmarkOptions& options);
+
+// Runs the mesh optimization passes on a bumpy sphere with shuffled triangles, timing each and reporting
+// the ACMR/ATVR of every order. Where pipeline statistics queries are available, also draws each order
+// from several views and reports the vertex and fragment shader invocations. Also reports the size and
+// precision of the mesh in every vertex format. Writes JSON.
+int RunMeshBenchmark(const BenchmarkOptions& options);
+
+// Times Mesh::GenerateLods' chain on the --mesh-bench mesh and reports each level's triangles, error and
+// the distance from which Mesh::SelectLod picks it at the benchmark's viewport height. Writes JSON.
+// Needs no OpenGL context.
+int RunLodBenchmark(const BenchmarkOptions& options);
+
+// Splits the --mesh-bench mesh into meshlets as Mesh::BuildMeshlets does and culls a grid of copies from
+// several views along the camera orbit: whole objects against the frustum, meshlets against the frustum,
+// and meshlets against the frustum and their normal cones (CullMeshlets). Reports the triangles each
+// submits, those really in view (facing the camera and in the frustum) and the time culling takes.
+// Writes JSON. Needs no OpenGL context.
+int RunMeshletBenchmark(const BenchmarkOptions& options);
+
+// Sets the light shader's model matrix --uniform-calls times per run: looking its location up with
+// glGetUniformLocation each time, by name through the uniform table, through a cached Uniform handle,
+// and with an unchanged value the shadow copy skips. Writes calls per second of each as JSON.
+int RunUniformBenchmark(const BenchmarkOptions& options);
+
+#endif
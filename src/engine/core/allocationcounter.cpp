@@ -0,0 +1,107 @@
+#include "allocationcounter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+static std::atomic<size_t> allocationCount(0);
+
+size_t Engine::Core::GetAllocationCount()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+static void* countedAllocate(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* countedAllocateAligned(size_t size, std::align_val_t alignment)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    // std::aligned_alloc is missing from MSVC and from macOS before 10.15
+#ifdef _WIN32
+    return _aligned_malloc(std::max<size_t>(size, 1), align);
+#else
+    // posix_memalign wants at least pointer alignment
+    void* memory = nullptr;
+    if (posix_memalign(&memory, std::max(align, sizeof(void*)), std::max<size_t>(size, 1)) != 0)
+        return nullptr;
+    return memory;
+#endif
+}
+
+// Memory from countedAllocateAligned; _aligned_malloc's blocks can't go to free()
+static void freeAligned(void* memory)
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+// Replacements of the global allocation functions; the array forms forward to these by default
+
+void* operator new(size_t size)
+{
+    void* memory = countedAllocate(size);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    void* memory = countedAllocateAligned(size, alignment);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocateAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    freeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+    freeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    freeAligned(memory);
+}
@@ -0,0 +1,15 @@
+#ifndef ENGINE_CORE_ALLOCATIONCOUNTER_HPP
+#define ENGINE_CORE_ALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+
+namespace Engine{
+namespace Core{
+
+// Number of global operator new calls so far, from any thread. The engine replaces the global
+// allocation functions with ones that bump this counter (one relaxed atomic add) before calling malloc;
+// the difference between two readings is the number of heap allocations made in between.
+size_t GetAllocationCount();
+}}
+
+#endif
@@ -0,0 +1,77 @@
+#include "framearena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+Engine::Core::FrameArena::FrameArena(size_t capacity) : current(0), peak(0)
+{
+    for (Buffer& buffer : buffers)
+    {
+        buffer.data = new unsigned char[capacity];
+        buffer.capacity = capacity;
+    }
+}
+
+Engine::Core::FrameArena::~FrameArena()
+{
+    for (Buffer& buffer : buffers)
+    {
+        delete[] buffer.data;
+        for (unsigned char* block : buffer.overflow)
+            delete[] block;
+    }
+}
+
+void Engine::Core::FrameArena::BeginFrame()
+{
+    current = (current + 1) % FRAMES_IN_FLIGHT;
+    Buffer& buffer = buffers[current];
+
+    // Fold the overflow into one buffer big enough for the whole frame
+    if (!buffer.overflow.empty())
+    {
+        for (unsigned char* block : buffer.overflow)
+            delete[] block;
+        buffer.overflow.clear();
+
+        delete[] buffer.data;
+        buffer.capacity = buffer.capacity + buffer.overflowBytes;
+        buffer.data = new unsigned char[buffer.capacity];
+        buffer.overflowBytes = 0;
+    }
+    buffer.used = 0;
+}
+
+void* Engine::Core::FrameArena::Allocate(size_t size, size_t alignment)
+{
+    Buffer& buffer = buffers[current];
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(buffer.data);
+    uintptr_t aligned = (base + buffer.used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    size_t end = aligned - base + size;
+    if (end <= buffer.capacity)
+    {
+        buffer.used = end;
+        peak = std::max(peak, buffer.used + buffer.overflowBytes);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Out of room: take a heap block for now, BeginFrame grows the buffer before it is used again
+    size_t blockSize = size + alignment;
+    unsigned char* block = new unsigned char[blockSize];
+    buffer.overflow.push_back(block);
+    buffer.overflowBytes += blockSize;
+    peak = std::max(peak, buffer.used + buffer.overflowBytes);
+
+    uintptr_t blockBase = reinterpret_cast<uintptr_t>(block);
+    return reinterpret_cast<void*>((blockBase + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+size_t Engine::Core::FrameArena::GetUsed() const
+{
+    return buffers[current].used + buffers[current].overflowBytes;
+}
+
+size_t Engine::Core::FrameArena::GetPeak() const
+{
+    return peak;
+}
@@ -0,0 +1,88 @@
+#ifndef ENGINE_CORE_FRAMEARENA_HPP
+#define ENGINE_CORE_FRAMEARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace Engine{
+namespace Core{
+
+// Linear allocator for data that only lives for one frame. Allocating bumps an offset and nothing is
+// freed individually; a frame's buffer is reset when it comes around again FRAMES_IN_FLIGHT frames
+// later, so memory handed to the driver is not overwritten while a queued frame may still read it.
+// Buffers that overflow grow on reuse, so steady-state frames make no heap allocations.
+// Not thread-safe: allocate from the render thread only.
+class FrameArena
+{
+public:
+    static const size_t FRAMES_IN_FLIGHT = 3;
+
+    explicit FrameArena(size_t capacity = 1 << 20);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Moves to the next buffer, releasing everything allocated from it FRAMES_IN_FLIGHT frames ago
+    void BeginFrame();
+
+    // Returns uninitialized memory that stays valid until the current buffer is reused
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    template<typename T>
+    T* Allocate(size_t count)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Bytes allocated in the current frame, and the most allocated in any frame
+    size_t GetUsed() const;
+    size_t GetPeak() const;
+
+private:
+    struct Buffer
+    {
+        unsigned char* data = nullptr;
+        size_t capacity = 0;
+        size_t used = 0;
+        // Blocks taken from the heap once the buffer was full, freed when the buffer is reused
+        std::vector<unsigned char*> overflow;
+        size_t overflowBytes = 0;
+    };
+
+    Buffer buffers[FRAMES_IN_FLIGHT];
+    size_t current;
+    size_t peak;
+};
+
+// STL allocator drawing from a FrameArena. Deallocation does nothing; the memory goes back with the frame,
+// so containers using it must not outlive FRAMES_IN_FLIGHT frames and should reserve up front.
+template<typename T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+
+    explicit FrameAllocator(FrameArena& arena) : arena(&arena) {}
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->Allocate<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template<typename U>
+    bool operator==(const FrameAllocator<U>& other) const { return arena == other.arena; }
+    template<typename U>
+    bool operator!=(const FrameAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template<typename U>
+    friend class FrameAllocator;
+
+    FrameArena* arena;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+}}
+
+#endif
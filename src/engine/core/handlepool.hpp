@@ -0,0 +1,133 @@
+#ifndef ENGINE_CORE_HANDLEPOOL_HPP
+#define ENGINE_CORE_HANDLEPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Engine{
+namespace Core{
+
+// Index into a HandlePool plus the generation of the slot when the handle was issued. A handle to a
+// destroyed object no longer matches its slot's generation, so stale handles resolve to nullptr
+// instead of to whatever reused the slot. Generation 0 is never issued: a default handle is null.
+template<typename T>
+struct Handle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool IsNull() const { return generation == 0; }
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Owns objects addressed by generational handles. Objects are stored densely, so iterating over them
+// touches contiguous memory; destroying one moves the last object into its place.
+// Pointers returned by Get are only valid until the next Create or Destroy; keep handles instead.
+template<typename T>
+class HandlePool
+{
+public:
+    HandlePool() = default;
+    HandlePool(const HandlePool&) = delete;
+    HandlePool& operator=(const HandlePool&) = delete;
+
+    // Takes ownership of an object and returns its handle
+    Handle<T> Create(T&& value)
+    {
+        uint32_t index;
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            index = (uint32_t)slots.size();
+            slots.push_back(Slot());
+        }
+
+        slots[index].dense = (uint32_t)values.size();
+        values.push_back(std::move(value));
+        owners.push_back(index);
+        return Handle<T>{index, slots[index].generation};
+    }
+
+    // Returns the object, or nullptr if the handle is null or its object was destroyed
+    T* Get(Handle<T> handle)
+    {
+        return Contains(handle) ? &values[slots[handle.index].dense] : nullptr;
+    }
+    const T* Get(Handle<T> handle) const
+    {
+        return Contains(handle) ? &values[slots[handle.index].dense] : nullptr;
+    }
+
+    bool Contains(Handle<T> handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation
+               && slots[handle.index].dense != FREE;
+    }
+
+    // Destroys the object; its handle and every copy of it become stale. Stale handles are ignored.
+    void Destroy(Handle<T> handle)
+    {
+        if (!Contains(handle))
+            return;
+
+        Slot& slot = slots[handle.index];
+        uint32_t last = (uint32_t)values.size() - 1;
+        if (slot.dense != last)
+        {
+            values[slot.dense] = std::move(values[last]);
+            owners[slot.dense] = owners[last];
+            slots[owners[last]].dense = slot.dense;
+        }
+        values.pop_back();
+        owners.pop_back();
+
+        slot.dense = FREE;
+        if (++slot.generation == 0)
+            slot.generation = 1;
+        freeSlots.push_back(handle.index);
+    }
+
+    // Destroys every object, invalidating all handles
+    void Clear()
+    {
+        for (uint32_t index = 0; index < slots.size(); index++)
+        {
+            if (slots[index].dense != FREE)
+                Destroy(Handle<T>{index, slots[index].generation});
+        }
+    }
+
+    size_t GetCount() const { return values.size(); }
+
+    // Live objects in storage order
+    T* begin() { return values.data(); }
+    T* end() { return values.data() + values.size(); }
+    const T* begin() const { return values.data(); }
+    const T* end() const { return values.data() + values.size(); }
+
+private:
+    static const uint32_t FREE = UINT32_MAX;
+
+    struct Slot
+    {
+        // Position of the object in values, or FREE
+        uint32_t dense = FREE;
+        uint32_t generation = 1;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    // Dense storage, and the slot owning each entry
+    std::vector<T> values;
+    std::vector<uint32_t> owners;
+};
+}}
+
+#endif
@@ -0,0 +1,108 @@
+#include "offsetallocator.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+Engine::Core::OffsetAllocator::OffsetAllocator(uint32_t capacity) : capacity(0), used(0)
+{
+    Grow(capacity);
+}
+
+uint32_t Engine::Core::OffsetAllocator::Allocate(uint32_t size)
+{
+    if (size == 0)
+        return INVALID;
+
+    // Best fit keeps the large ranges whole for large requests; the list stays short as ranges coalesce
+    auto best = freeRanges.end();
+    for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range)
+    {
+        if (range->second >= size && (best == freeRanges.end() || range->second < best->second))
+        {
+            best = range;
+            if (range->second == size)
+                break;
+        }
+    }
+    if (best == freeRanges.end())
+        return INVALID;
+
+    uint32_t offset = best->first;
+    uint32_t remaining = best->second - size;
+    freeRanges.erase(best);
+    if (remaining > 0)
+        freeRanges.emplace(offset + size, remaining);
+    used += size;
+    return offset;
+}
+
+void Engine::Core::OffsetAllocator::Free(uint32_t offset, uint32_t size)
+{
+    if (offset == INVALID || size == 0)
+        return;
+    assert(offset + size <= capacity);
+    used -= size;
+
+    auto next = freeRanges.lower_bound(offset);
+    assert(next == freeRanges.end() || next->first >= offset + size);
+    // Merge with the range right after, then with the one right before
+    if (next != freeRanges.end() && next->first == offset + size)
+    {
+        size += next->second;
+        next = freeRanges.erase(next);
+    }
+    if (next != freeRanges.begin())
+    {
+        auto previous = std::prev(next);
+        assert(previous->first + previous->second <= offset);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            return;
+        }
+    }
+    freeRanges.emplace_hint(next, offset, size);
+}
+
+void Engine::Core::OffsetAllocator::Grow(uint32_t newCapacity)
+{
+    if (newCapacity <= capacity)
+        return;
+    uint32_t added = newCapacity - capacity;
+    uint32_t offset = capacity;
+    // Free already counts the range as used
+    used += added;
+    capacity = newCapacity;
+    Free(offset, added);
+}
+
+void Engine::Core::OffsetAllocator::Reset()
+{
+    freeRanges.clear();
+    used = 0;
+    if (capacity > 0)
+        freeRanges.emplace(0, capacity);
+}
+
+uint32_t Engine::Core::OffsetAllocator::GetCapacity() const
+{
+    return capacity;
+}
+
+uint32_t Engine::Core::OffsetAllocator::GetUsed() const
+{
+    return used;
+}
+
+uint32_t Engine::Core::OffsetAllocator::GetLargestFree() const
+{
+    uint32_t largest = 0;
+    for (const auto& range : freeRanges)
+        largest = std::max(largest, range.second);
+    return largest;
+}
+
+size_t Engine::Core::OffsetAllocator::GetFreeRangeCount() const
+{
+    return freeRanges.size();
+}
@@ -0,0 +1,44 @@
+#ifndef ENGINE_CORE_OFFSETALLOCATOR_HPP
+#define ENGINE_CORE_OFFSETALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace Engine{
+namespace Core{
+
+// Hands out ranges of an externally owned buffer (e.g. elements of a GPU buffer) by offset. Free ranges
+// are kept sorted by offset, allocation takes the smallest range that fits, and freeing merges a range
+// with free neighbours so the space doesn't fragment into unusable slivers. Units are whatever the
+// caller counts in; nothing is aligned.
+class OffsetAllocator
+{
+public:
+    static const uint32_t INVALID = 0xFFFFFFFF;
+
+    explicit OffsetAllocator(uint32_t capacity = 0);
+
+    // Offset of a new range, or INVALID if no free range is large enough
+    uint32_t Allocate(uint32_t size);
+    // Returns a range given out by Allocate
+    void Free(uint32_t offset, uint32_t size);
+    // Adds free space at the end, after the buffer itself was grown
+    void Grow(uint32_t capacity);
+    // Frees everything
+    void Reset();
+
+    uint32_t GetCapacity() const;
+    uint32_t GetUsed() const;
+    uint32_t GetLargestFree() const;
+    size_t GetFreeRangeCount() const;
+
+private:
+    // Free ranges, offset to size
+    std::map<uint32_t, uint32_t> freeRanges;
+    uint32_t capacity;
+    uint32_t used;
+};
+}}
+
+#endif
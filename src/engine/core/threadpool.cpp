@@ -0,0 +1,116 @@
+#include "threadpool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+Engine::Core::ThreadPool::ThreadPool(unsigned int threadCount) : jobHead(0), jobCount(0), stopping(false)
+{
+    if (threadCount == 0)
+    {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+Engine::Core::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void Engine::Core::ThreadPool::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobCount == jobs.size())
+        {
+            // Unroll the ring into a buffer twice the size
+            std::vector<std::function<void()>> grown(std::max<size_t>(16, jobs.size() * 2));
+            for (size_t i = 0; i < jobCount; i++)
+                grown[i] = std::move(jobs[(jobHead + i) % jobs.size()]);
+            jobs.swap(grown);
+            jobHead = 0;
+        }
+        jobs[(jobHead + jobCount) % jobs.size()] = std::move(job);
+        jobCount++;
+    }
+    available.notify_one();
+}
+
+void Engine::Core::ThreadPool::ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body)
+{
+    if (count == 0)
+        return;
+
+    // One chunk per worker plus one for the calling thread
+    size_t chunkCount = std::min(count, workers.size() + 1);
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    // Shared by the chunks on this stack frame, so each job only captures a pointer and its index
+    // and fits in std::function's inline storage instead of allocating
+    struct Batch
+    {
+        const std::function<void(size_t, size_t)>* body;
+        size_t count;
+        size_t chunkSize;
+        size_t remaining;
+        std::mutex doneMutex;
+        std::condition_variable done;
+    } batch;
+    batch.body = &body;
+    batch.count = count;
+    batch.chunkSize = chunkSize;
+    batch.remaining = chunkCount - 1;
+
+    for (size_t chunk = 1; chunk < chunkCount; chunk++)
+    {
+        Batch* shared = &batch;
+        Submit([shared, chunk]() {
+            size_t begin = chunk * shared->chunkSize;
+            size_t end = std::min(shared->count, begin + shared->chunkSize);
+            if (begin < end)
+                (*shared->body)(begin, end);
+            // Decrement under the lock so the caller cannot return while we still touch its locals
+            std::lock_guard<std::mutex> lock(shared->doneMutex);
+            if (--shared->remaining == 0)
+                shared->done.notify_one();
+        });
+    }
+
+    body(0, std::min(count, chunkSize));
+
+    std::unique_lock<std::mutex> lock(batch.doneMutex);
+    batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+}
+
+unsigned int Engine::Core::ThreadPool::GetThreadCount() const
+{
+    return (unsigned int)workers.size();
+}
+
+void Engine::Core::ThreadPool::workerLoop()
+{
+    TraceRecorder::SetThreadName("Worker");
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this]() { return stopping || jobCount > 0; });
+            if (stopping && jobCount == 0)
+                return;
+            job = std::move(jobs[jobHead]);
+            jobs[jobHead] = nullptr;
+            jobHead = (jobHead + 1) % jobs.size();
+            jobCount--;
+        }
+        job();
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef ENGINE_CORE_THREADPOOL_HPP
+#define ENGINE_CORE_THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine{
+namespace Core{
+
+// Fixed set of worker threads consuming a shared job queue
+class ThreadPool
+{
+public:
+    // Starts the workers (defaults to one per hardware thread, minus the calling thread)
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queues a job to be run by a worker
+    void Submit(std::function<void()> job);
+
+    // Splits [0, count) into chunks run on the workers and the calling thread, and returns once all are done
+    void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body);
+
+    unsigned int GetThreadCount() const;
+
+private:
+    // Main loop of each worker thread
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    // Ring buffer of queued jobs; it grows when full and never shrinks, so steady use doesn't allocate
+    std::vector<std::function<void()>> jobs;
+    size_t jobHead;
+    size_t jobCount;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping;
+};
+}}
+
+#endif
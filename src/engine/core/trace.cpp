@@ -0,0 +1,209 @@
+#include "trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent
+{
+    const char* name;
+    const char* category;
+    uint64_t start;
+    uint64_t end;
+};
+
+// One event of a ring, published like a seqlock: sequence is the event's number plus one once its
+// fields are complete, and 0 while its thread overwrites them. The fields are atomics so Write can
+// read them while the thread records; relaxed accesses ordered by the sequence cost nothing on x86.
+struct TraceSlot
+{
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<const char*> category{nullptr};
+    std::atomic<uint64_t> start{0};
+    std::atomic<uint64_t> end{0};
+};
+
+// Ring of one thread's events. Only its thread writes; head counts every event ever recorded, so
+// the ring holds events [head - capacity, head).
+struct TraceBuffer
+{
+    std::unique_ptr<TraceSlot[]> slots;
+    uint64_t capacity = 0;
+    std::atomic<uint64_t> head{0};
+    std::string name;
+    unsigned int id = 0;
+};
+
+static std::atomic<bool> traceEnabled{false};
+static std::atomic<uint64_t> traceEpoch{0};
+static size_t traceCapacity = 1 << 16;
+
+// Buffers are never freed, so events of threads that have exited are still written
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> registry;
+static thread_local TraceBuffer* threadBuffer = nullptr;
+// Kept until the thread records its first event, so idle threads cost no buffer
+static thread_local const char* threadName = nullptr;
+static TraceBuffer* gpuBuffer = nullptr;
+
+static TraceBuffer* createBuffer(const char* name)
+{
+    std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->slots.reset(new TraceSlot[traceCapacity]);
+    buffer->capacity = traceCapacity;
+    buffer->id = (unsigned int)registry.size() + 1;
+    buffer->name = name != nullptr ? name : "Thread " + std::to_string(buffer->id);
+    registry.push_back(std::move(buffer));
+    return registry.back().get();
+}
+
+static void append(TraceBuffer& buffer, const char* name, const char* category, uint64_t start, uint64_t end)
+{
+    uint64_t index = buffer.head.load(std::memory_order_relaxed);
+    TraceSlot& slot = buffer.slots[index % buffer.capacity];
+    // Readers that see the old sequence after this fence also see it changed once they are done
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.category.store(category, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+    buffer.head.store(index + 1, std::memory_order_release);
+}
+
+// Copies event number index out of a ring; false if its thread has not finished it or has since
+// overwritten it
+static bool readEvent(const TraceBuffer& buffer, uint64_t index, TraceEvent& event)
+{
+    const TraceSlot& slot = buffer.slots[index % buffer.capacity];
+    if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+        return false;
+    event.name = slot.name.load(std::memory_order_relaxed);
+    event.category = slot.category.load(std::memory_order_relaxed);
+    event.start = slot.start.load(std::memory_order_relaxed);
+    event.end = slot.end.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+static void writeString(std::ostream& out, const std::string& text)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            out << ' ';
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+void Engine::Core::TraceRecorder::SetEnabled(bool enabled)
+{
+    uint64_t none = 0;
+    if (enabled)
+        traceEpoch.compare_exchange_strong(none, Now());
+    traceEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Engine::Core::TraceRecorder::IsEnabled()
+{
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+
+void Engine::Core::TraceRecorder::SetCapacity(size_t events)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    traceCapacity = events > 0 ? events : 1;
+}
+
+uint64_t Engine::Core::TraceRecorder::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Engine::Core::TraceRecorder::SetThreadName(const char* name)
+{
+    threadName = name;
+    if (threadBuffer != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        threadBuffer->name = name;
+    }
+}
+
+void Engine::Core::TraceRecorder::AddEvent(const char* name, const char* category, uint64_t start, uint64_t end)
+{
+    if (threadBuffer == nullptr)
+        threadBuffer = createBuffer(threadName);
+    append(*threadBuffer, name, category, start, end);
+}
+
+void Engine::Core::TraceRecorder::AddGpuEvent(const char* name, uint64_t start, uint64_t end)
+{
+    if (gpuBuffer == nullptr)
+        gpuBuffer = createBuffer("GPU");
+    append(*gpuBuffer, name, "gpu", start, end);
+}
+
+bool Engine::Core::TraceRecorder::Write(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    uint64_t epoch = traceEpoch.load();
+    std::vector<TraceEvent> events;
+    bool first = true;
+    // Microseconds with nanosecond precision, never in exponent notation
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::unique_ptr<TraceBuffer>& buffer : registry)
+    {
+        uint64_t end = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = end > buffer->capacity ? end - buffer->capacity : 0;
+        // The thread may keep recording while we copy; events it overwrites meanwhile are dropped
+        events.clear();
+        TraceEvent event;
+        for (uint64_t i = begin; i < end; i++)
+        {
+            if (readEvent(*buffer, i, event))
+                events.push_back(event);
+        }
+
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id
+            << ", \"args\": {\"name\": ";
+        writeString(out, buffer->name);
+        out << "}}";
+        first = false;
+
+        for (const TraceEvent& event : events)
+        {
+            // Events from before the trace started (e.g. GPU results of earlier frames) are skipped
+            if (event.start < epoch)
+                continue;
+            out << ",\n{\"name\": ";
+            writeString(out, event.name);
+            out << ", \"cat\": ";
+            writeString(out, event.category);
+            out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->id
+                << ", \"ts\": " << (event.start - epoch) / 1000.0
+                << ", \"dur\": " << (event.end > event.start ? event.end - event.start : 0) / 1000.0 << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    return (bool)out;
+}
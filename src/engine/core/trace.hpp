@@ -0,0 +1,73 @@
+#ifndef ENGINE_CORE_TRACE_HPP
+#define ENGINE_CORE_TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Engine{
+namespace Core{
+
+// Records timed events into one ring buffer per thread and writes them in the Chrome trace event
+// format (chrome://tracing, ui.perfetto.dev). Recording is lock-free: each thread only appends to its
+// own ring, which keeps the newest events once full. Event names and categories must be string
+// literals or otherwise outlive the recorder.
+class TraceRecorder
+{
+public:
+    // Starts or stops recording; the first start also sets time zero of the trace
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+    // Events kept per thread; only affects threads that have not recorded anything yet
+    static void SetCapacity(size_t events);
+
+    // Nanoseconds on the clock events are recorded with
+    static uint64_t Now();
+    // Name shown for the calling thread's track
+    static void SetThreadName(const char* name);
+
+    // Records an event that ran on the calling thread from start to end
+    static void AddEvent(const char* name, const char* category, uint64_t start, uint64_t end);
+    // Records an event on the GPU track, with times already converted to Now()'s clock.
+    // Call from the render thread only.
+    static void AddGpuEvent(const char* name, uint64_t start, uint64_t end);
+
+    // Writes every recorded event as Chrome trace JSON; returns false if the file can't be written.
+    // Events overwritten by their thread while writing are left out.
+    static bool Write(const std::string& path);
+};
+
+// Records the enclosing block as an event on the calling thread
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name, const char* category = "cpu")
+        : name(name), category(category), start(TraceRecorder::IsEnabled() ? TraceRecorder::Now() : 0) {}
+    ~TraceScope()
+    {
+        if (start != 0)
+            TraceRecorder::AddEvent(name, category, start, TraceRecorder::Now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    // 0 if recording was off when the scope began
+    uint64_t start;
+};
+}}
+
+#define ENGINE_TRACE_CONCAT_INNER(a, b) a##b
+#define ENGINE_TRACE_CONCAT(a, b) ENGINE_TRACE_CONCAT_INNER(a, b)
+
+#ifdef ENGINE_PROFILING
+// Records the rest of the enclosing block in the trace, on any thread
+#define ENGINE_TRACE_SCOPE(name) Engine::Core::TraceScope ENGINE_TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define ENGINE_TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+#include "batchrenderer.hpp"
+#include "glstate.hpp"
+#include "renderstats.hpp"
+#include <algorithm>
+
+// Texels of one model matrix in the texture buffer
+static const size_t TEXELS_PER_DRAW = 4;
+
+Engine::Graphics::BatchRenderer::BatchRenderer()
+    : commandBuffer(0), transformBuffer(0), transformTexture(0), maxDraws(0), lastPath(BatchPath::Loop)
+{
+}
+
+void Engine::Graphics::BatchRenderer::Begin()
+{
+    commands.clear();
+    transforms.clear();
+}
+
+void Engine::Graphics::BatchRenderer::Add(const GeometryRange& range, const glm::mat4& model)
+{
+    commands.push_back(DrawElementsIndirectCommand{range.indexCount, 1, range.firstIndex, range.baseVertex, 0});
+    transforms.push_back(model);
+}
+
+void Engine::Graphics::BatchRenderer::createObjects()
+{
+    glGenBuffers(1, &transformBuffer);
+    glGenTextures(1, &transformTexture);
+    GLState::BindBuffer(GL_TEXTURE_BUFFER, transformBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    // The texture keeps pointing at the buffer when its data store is respecified
+    GLState::BindTextureUnit(TRANSFORM_UNIT, GL_TEXTURE_BUFFER, transformTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, transformBuffer);
+
+    GLint maxTexels;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    maxDraws = std::max<size_t>(1, (size_t)maxTexels / TEXELS_PER_DRAW);
+
+    if (IsBatchPathSupported(BatchPath::Indirect))
+        glGenBuffers(1, &commandBuffer);
+}
+
+void Engine::Graphics::BatchRenderer::Submit(GeometryArena& geometry, Shader& shader, BatchPath path)
+{
+    if (path == BatchPath::Best || !IsBatchPathSupported(path))
+        path = GetBestBatchPath();
+    lastPath = path;
+    if (commands.empty())
+        return;
+    if (transformBuffer == 0)
+        createObjects();
+
+    shader.Activate();
+    shader.setInt("drawTransforms", TRANSFORM_UNIT);
+    Uniform drawBase = shader.getUniform("drawBase");
+    GLState::BindTextureUnit(TRANSFORM_UNIT, GL_TEXTURE_BUFFER, transformTexture);
+    geometry.Bind();
+
+    if (path == BatchPath::Indirect)
+    {
+        RenderStats::Current().bufferUploads++;
+        GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(),
+                     GL_STREAM_DRAW);
+    }
+    else if (path == BatchPath::MultiDraw)
+    {
+        counts.resize(commands.size());
+        offsets.resize(commands.size());
+        baseVertices.resize(commands.size());
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            counts[i] = (GLsizei)commands[i].count;
+            offsets[i] = (const void*)(commands[i].firstIndex * sizeof(GLuint));
+            baseVertices[i] = commands[i].baseVertex;
+        }
+    }
+
+    for (size_t first = 0; first < commands.size(); first += maxDraws)
+    {
+        size_t count = std::min(maxDraws, commands.size() - first);
+
+        // Respecifying the store each chunk lets the driver keep the previous one for draws in flight
+        RenderStats::Current().bufferUploads++;
+        GLState::BindBuffer(GL_TEXTURE_BUFFER, transformBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, count * sizeof(glm::mat4), &transforms[first], GL_STREAM_DRAW);
+
+        switch (path)
+        {
+        case BatchPath::Indirect:
+            shader.setInt(drawBase, 0);
+            RenderStats::Current().drawCalls++;
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                        (const void*)(first * sizeof(DrawElementsIndirectCommand)), (GLsizei)count, 0);
+            break;
+        case BatchPath::MultiDraw:
+            shader.setInt(drawBase, 0);
+            RenderStats::Current().drawCalls++;
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, &counts[first], GL_UNSIGNED_INT, &offsets[first],
+                                          (GLsizei)count, &baseVertices[first]);
+            break;
+        default:
+            for (size_t i = 0; i < count; i++)
+            {
+                const DrawElementsIndirectCommand& command = commands[first + i];
+                shader.setInt(drawBase, (int)i);
+                RenderStats::Current().drawCalls++;
+                glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                         (const void*)(command.firstIndex * sizeof(GLuint)), command.baseVertex);
+            }
+            break;
+        }
+    }
+}
+
+void Engine::Graphics::BatchRenderer::SubmitIndirect(GeometryArena& geometry, Shader& shader, GLuint commandBuffer,
+                                                      GLsizei commandCount, GLuint instanceBuffer)
+{
+    lastPath = BatchPath::Indirect;
+    if (commandCount == 0)
+        return;
+
+    shader.Activate();
+    geometry.SetInstanceBuffer(instanceBuffer);
+    geometry.Bind();
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    RenderStats::Current().drawCalls++;
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, commandCount, 0);
+}
+
+size_t Engine::Graphics::BatchRenderer::GetDrawCount() const
+{
+    return commands.size();
+}
+
+Engine::Graphics::BatchPath Engine::Graphics::BatchRenderer::GetLastPath() const
+{
+    return lastPath;
+}
+
+void Engine::Graphics::BatchRenderer::Delete()
+{
+    if (transformBuffer != 0)
+    {
+        GLState::ForgetBuffer(transformBuffer);
+        GLState::ForgetTexture(transformTexture);
+        glDeleteBuffers(1, &transformBuffer);
+        glDeleteTextures(1, &transformTexture);
+    }
+    if (commandBuffer != 0)
+    {
+        GLState::ForgetBuffer(commandBuffer);
+        glDeleteBuffers(1, &commandBuffer);
+    }
+    transformBuffer = transformTexture = commandBuffer = 0;
+}
+
+bool Engine::Graphics::BatchRenderer::HasDrawParameters()
+{
+    return GLEW_VERSION_4_6 || GLEW_ARB_shader_draw_parameters;
+}
+
+std::vector<std::string> Engine::Graphics::BatchRenderer::BatchDefines(std::vector<std::string> defines)
+{
+    defines.push_back("BATCHED");
+    if (HasDrawParameters())
+        defines.push_back("DRAW_PARAMETERS");
+    return defines;
+}
+
+bool Engine::Graphics::IsBatchPathSupported(BatchPath path)
+{
+    switch (path)
+    {
+    case BatchPath::Indirect:
+        return BatchRenderer::HasDrawParameters() && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+    case BatchPath::MultiDraw:
+        return BatchRenderer::HasDrawParameters();
+    default:
+        return true;
+    }
+}
+
+Engine::Graphics::BatchPath Engine::Graphics::GetBestBatchPath()
+{
+    return IsBatchPathSupported(BatchPath::Indirect)    ? BatchPath::Indirect
+           : IsBatchPathSupported(BatchPath::MultiDraw) ? BatchPath::MultiDraw
+                                                        : BatchPath::Loop;
+}
+
+const char* Engine::Graphics::GetBatchPathName(BatchPath path)
+{
+    switch (path)
+    {
+    case BatchPath::Best:
+        return GetBatchPathName(GetBestBatchPath());
+    case BatchPath::Indirect:
+        return "indirect";
+    case BatchPath::MultiDraw:
+        return "multi-draw";
+    default:
+        return "loop";
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef ENGINE_GRAPHICS_BATCHRENDERER_HPP
+#define ENGINE_GRAPHICS_BATCHRENDERER_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "geometryarena.hpp"
+#include "shader.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Ways to submit a batch. Best picks the first the driver supports:
+//   Indirect:  one glMultiDrawElementsIndirect from a command buffer (GL 4.3 and shader draw parameters)
+//   MultiDraw: one glMultiDrawElementsBaseVertex from client arrays (shader draw parameters)
+//   Loop:      one glDrawElementsBaseVertex per draw with the draw index in a uniform (any GL 3.3 driver)
+enum class BatchPath
+{
+    Best,
+    Loop,
+    MultiDraw,
+    Indirect
+};
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Draws many meshes of one GeometryArena with one shader in as few calls as the driver allows. Each
+// draw's model matrix goes into a texture buffer (four RGBA32F texels per draw), and programs built
+// with BATCHED fetch theirs with drawBase + gl_DrawIDARB (DRAW_PARAMETERS) or drawBase alone, so the
+// CPU cost per draw is appending a command and a matrix. Materials are per batch: bind textures and
+// set uniforms before Submit, and use one batch per material.
+// Batches with more draws than the texture buffer holds are submitted in chunks.
+class BatchRenderer
+{
+public:
+    // Texture unit of the per-draw matrices, after the light cluster units
+    static const GLuint TRANSFORM_UNIT = 5;
+
+    BatchRenderer();
+
+    void Begin();
+    void Add(const GeometryRange& range, const glm::mat4& model);
+    // Draws the batch; the shader must be built with BatchDefines
+    void Submit(GeometryArena& geometry, Shader& shader, BatchPath path = BatchPath::Best);
+    // Draws commands that are already on the GPU (e.g. written by GpuCuller) with one
+    // glMultiDrawElementsIndirect. Per-instance matrices come from instanceBuffer, so the shader must be
+    // an INSTANCED program and the commands' baseInstance index into that buffer. Ignores Begin/Add.
+    void SubmitIndirect(GeometryArena& geometry, Shader& shader, GLuint commandBuffer, GLsizei commandCount,
+                        GLuint instanceBuffer);
+
+    size_t GetDrawCount() const;
+    // Path the last Submit used
+    BatchPath GetLastPath() const;
+
+    // Deletes the buffers now, e.g. before the GL context is destroyed
+    void Delete();
+
+    // True if vertex shaders can read gl_DrawIDARB
+    static bool HasDrawParameters();
+    // Shader defines of the batched variant of a program with the given defines
+    static std::vector<std::string> BatchDefines(std::vector<std::string> defines = {});
+
+private:
+    void createObjects();
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<glm::mat4> transforms;
+    // Client arrays of the MultiDraw path
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+
+    GLuint commandBuffer;
+    GLuint transformBuffer;
+    GLuint transformTexture;
+    // Draws that fit in the texture buffer at once
+    size_t maxDraws;
+    BatchPath lastPath;
+};
+
+// True if the driver can run the path
+bool IsBatchPathSupported(BatchPath path);
+// Resolves Best to the path that would be used
+BatchPath GetBestBatchPath();
+const char* GetBatchPathName(BatchPath path);
+}}
+
+#endif
@@ -1,4 +1,5 @@
 #include "ebo.hpp"
+#include "../glstate.hpp"
 
 // Default constructor
 Engine::Graphics::Buffers::EBO::EBO() : ID(0)
@@ -9,7 +10,7 @@ Engine::Graphics::Buffers::EBO::EBO() : ID(0)
 Engine::Graphics::Buffers::EBO::EBO(GLuint* indices, GLsizeiptr size)
 {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
 }
 
@@ -17,24 +18,53 @@ Engine::Graphics::Buffers::EBO::EBO(GLuint* indices, GLsizeiptr size)
 Engine::Graphics::Buffers::EBO::EBO(const void* data, GLsizeiptr size)
 {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
+// Deletes the EBO if Delete was not called
+Engine::Graphics::Buffers::EBO::~EBO()
+{
+	Delete();
+}
+
+// Takes over the other EBO's ID, leaving it empty
+Engine::Graphics::Buffers::EBO::EBO(EBO&& other) noexcept : ID(other.ID)
+{
+	other.ID = 0;
+}
+
+// Deletes this EBO and takes over the other one's ID
+Engine::Graphics::Buffers::EBO& Engine::Graphics::Buffers::EBO::operator=(EBO&& other) noexcept
+{
+	if (this != &other)
+	{
+		Delete();
+		ID = other.ID;
+		other.ID = 0;
+	}
+	return *this;
+}
+
 // Binds the EBO
 void Engine::Graphics::Buffers::EBO::Bind()
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
 }
 
 // Unbinds the EBO
 void Engine::Graphics::Buffers::EBO::Unbind()
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 // Deletes the EBO
 void Engine::Graphics::Buffers::EBO::Delete()
 {
-	glDeleteBuffers(1, &ID);
+	if (ID != 0)
+	{
+		GLState::ForgetBuffer(ID);
+		glDeleteBuffers(1, &ID);
+	}
+	ID = 0;
 }
@@ -18,6 +18,13 @@ public:
 	EBO(GLuint* indices, GLsizeiptr size);
 	// Generic constructor for any index data type
 	EBO(const void* data, GLsizeiptr size);
+	// Deletes the EBO if Delete was not called
+	~EBO();
+	// Move-only: exactly one object owns the buffer
+	EBO(const EBO&) = delete;
+	EBO& operator=(const EBO&) = delete;
+	EBO(EBO&& other) noexcept;
+	EBO& operator=(EBO&& other) noexcept;
 
 	// Binds the EBO
 	void Bind();
@@ -0,0 +1,49 @@
+#include "fbo.hpp"
+
+// Constructor that generates a Framebuffer Object with an RGBA8 color and a 24-bit depth attachment
+Engine::Graphics::Buffers::FBO::FBO(GLsizei width, GLsizei height)
+{
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &ID);
+	glBindFramebuffer(GL_FRAMEBUFFER, ID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Returns true if the framebuffer can be rendered to
+bool Engine::Graphics::Buffers::FBO::IsComplete()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, ID);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return status == GL_FRAMEBUFFER_COMPLETE;
+}
+
+// Binds the FBO for drawing and reading
+void Engine::Graphics::Buffers::FBO::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, ID);
+}
+
+// Binds the default framebuffer back
+void Engine::Graphics::Buffers::FBO::Unbind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Deletes the FBO and its attachments
+void Engine::Graphics::Buffers::FBO::Delete()
+{
+	glDeleteFramebuffers(1, &ID);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+}
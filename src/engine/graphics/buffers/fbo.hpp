@@ -0,0 +1,32 @@
+#ifndef ENGINE_GRAPHICS__BUFFERS_FBO_HPP
+#define ENGINE_GRAPHICS__BUFFERS_FBO_HPP
+
+#include <GL/glew.h>
+
+namespace Engine{
+namespace Graphics{
+namespace Buffers{
+
+class FBO
+{
+public:
+	// Reference ID of the Framebuffer Object
+	GLuint ID;
+	// Renderbuffers holding the color and depth attachments
+	GLuint colorBuffer;
+	GLuint depthBuffer;
+	// Constructor that generates a Framebuffer Object with an RGBA8 color and a 24-bit depth attachment
+	FBO(GLsizei width, GLsizei height);
+
+	// Returns true if the framebuffer can be rendered to
+	bool IsComplete();
+	// Binds the FBO for drawing and reading
+	void Bind();
+	// Binds the default framebuffer back
+	void Unbind();
+	// Deletes the FBO and its attachments
+	void Delete();
+};
+}}}
+
+#endif
@@ -1,4 +1,5 @@
 #include "vao.hpp"
+#include "../glstate.hpp"
 
 // Constructor that generates a VAO ID
 Engine::Graphics::Buffers::VAO::VAO()
@@ -6,29 +7,65 @@ Engine::Graphics::Buffers::VAO::VAO()
 	glGenVertexArrays(1, &ID);
 }
 
+// Deletes the VAO if Delete was not called
+Engine::Graphics::Buffers::VAO::~VAO()
+{
+	Delete();
+}
+
+// Takes over the other VAO's ID, leaving it empty
+Engine::Graphics::Buffers::VAO::VAO(VAO&& other) noexcept : ID(other.ID)
+{
+	other.ID = 0;
+}
+
+// Deletes this VAO and takes over the other one's ID
+Engine::Graphics::Buffers::VAO& Engine::Graphics::Buffers::VAO::operator=(VAO&& other) noexcept
+{
+	if (this != &other)
+	{
+		Delete();
+		ID = other.ID;
+		other.ID = 0;
+	}
+	return *this;
+}
+
 // Links a VBO to the VAO using a certain layout
-void Engine::Graphics::Buffers::VAO::LinkAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset)
+void Engine::Graphics::Buffers::VAO::LinkAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset, GLboolean normalized)
 {
+	// The attribute captures the buffer bound now; leaving it bound is harmless as it isn't VAO state
 	VBO.Bind();
-	glVertexAttribPointer(layout, numComponents, type, GL_FALSE, stride, offset);
+	glVertexAttribPointer(layout, numComponents, type, normalized, stride, offset);
 	glEnableVertexAttribArray(layout);
-	VBO.Unbind();
+}
+
+// Links a VBO attribute that advances once per instance
+void Engine::Graphics::Buffers::VAO::LinkInstanceAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset, GLuint divisor)
+{
+	LinkAttrib(VBO, layout, numComponents, type, stride, offset);
+	glVertexAttribDivisor(layout, divisor);
 }
 
 // Binds the VAO
 void Engine::Graphics::Buffers::VAO::Bind()
 {
-	glBindVertexArray(ID);
+	GLState::BindVertexArray(ID);
 }
 
 // Unbinds the VAO
 void Engine::Graphics::Buffers::VAO::Unbind()
 {
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 }
 
 // Deletes the VAO
 void Engine::Graphics::Buffers::VAO::Delete()
 {
-	glDeleteVertexArrays(1, &ID);
+	if (ID != 0)
+	{
+		GLState::ForgetVertexArray(ID);
+		glDeleteVertexArrays(1, &ID);
+	}
+	ID = 0;
 }
@@ -15,9 +15,18 @@ public:
    GLuint ID;
    // Constructor that generates a VAO ID
    VAO();
+   // Deletes the VAO if Delete was not called
+   ~VAO();
+   // Move-only: exactly one object owns the vertex array
+   VAO(const VAO&) = delete;
+   VAO& operator=(const VAO&) = delete;
+   VAO(VAO&& other) noexcept;
+   VAO& operator=(VAO&& other) noexcept;
 
-   // Links a VBO to the VAO using a certain layout
-   void LinkAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset);
+   // Links a VBO to the VAO using a certain layout; normalized integers are read as 0-1 (or -1 to 1 if signed)
+   void LinkAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset, GLboolean normalized = GL_FALSE);
+   // Links a VBO attribute that advances once per instance (or per divisor instances) instead of per vertex
+   void LinkInstanceAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset, GLuint divisor = 1);
    // Binds the VAO
    void Bind();
    // Unbinds the VAO
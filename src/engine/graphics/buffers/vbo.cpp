@@ -1,4 +1,6 @@
 #include "vbo.hpp"
+#include "../glstate.hpp"
+#include "../renderstats.hpp"
 
 // Default constructor
 Engine::Graphics::Buffers::VBO::VBO() : ID(0)
@@ -9,7 +11,7 @@ Engine::Graphics::Buffers::VBO::VBO() : ID(0)
 Engine::Graphics::Buffers::VBO::VBO(GLfloat* vertices, GLsizeiptr size)
 {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
 	glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
 }
 
@@ -17,24 +19,69 @@ Engine::Graphics::Buffers::VBO::VBO(GLfloat* vertices, GLsizeiptr size)
 Engine::Graphics::Buffers::VBO::VBO(const void* data, GLsizeiptr size)
 {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
 	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
+// Constructor with an explicit usage hint
+Engine::Graphics::Buffers::VBO::VBO(const void* data, GLsizeiptr size, GLenum usage)
+{
+	glGenBuffers(1, &ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+}
+
+// Replaces the start of the buffer's data
+void Engine::Graphics::Buffers::VBO::Update(const void* data, GLsizeiptr size)
+{
+	RenderStats::Current().bufferUploads++;
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+}
+
+// Deletes the VBO if Delete was not called
+Engine::Graphics::Buffers::VBO::~VBO()
+{
+	Delete();
+}
+
+// Takes over the other VBO's ID, leaving it empty
+Engine::Graphics::Buffers::VBO::VBO(VBO&& other) noexcept : ID(other.ID)
+{
+	other.ID = 0;
+}
+
+// Deletes this VBO and takes over the other one's ID
+Engine::Graphics::Buffers::VBO& Engine::Graphics::Buffers::VBO::operator=(VBO&& other) noexcept
+{
+	if (this != &other)
+	{
+		Delete();
+		ID = other.ID;
+		other.ID = 0;
+	}
+	return *this;
+}
+
 // Binds the VBO
 void Engine::Graphics::Buffers::VBO::Bind()
 {
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
 }
 
 // Unbinds the VBO
 void Engine::Graphics::Buffers::VBO::Unbind()
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 // Deletes the VBO
 void Engine::Graphics::Buffers::VBO::Delete()
 {
-	glDeleteBuffers(1, &ID);
+	if (ID != 0)
+	{
+		GLState::ForgetBuffer(ID);
+		glDeleteBuffers(1, &ID);
+	}
+	ID = 0;
 }
@@ -18,6 +18,18 @@ public:
    VBO(GLfloat *vertices, GLsizeiptr size);
    // Generic constructor for any vertex data type
    VBO(const void* data, GLsizeiptr size);
+   // Constructor with an explicit usage hint (e.g. GL_STREAM_DRAW for data rewritten every frame)
+   VBO(const void* data, GLsizeiptr size, GLenum usage);
+   // Deletes the VBO if Delete was not called
+   ~VBO();
+   // Move-only: exactly one object owns the buffer
+   VBO(const VBO&) = delete;
+   VBO& operator=(const VBO&) = delete;
+   VBO(VBO&& other) noexcept;
+   VBO& operator=(VBO&& other) noexcept;
+
+   // Replaces the start of the buffer's data
+   void Update(const void* data, GLsizeiptr size);
 
    // Binds the VBO
    void Bind();
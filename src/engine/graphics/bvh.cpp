@@ -0,0 +1,516 @@
+#include "bvh.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Traversal stacks hold at most one pending sibling per level
+static const int STACK_SIZE = Engine::Graphics::BVH::MAX_DEPTH + 2;
+// Marks a stack entry whose subtree lies entirely inside the frustum
+static const uint32_t INSIDE_BIT = 1u << 31;
+static const uint32_t NO_PARENT = 0xFFFFFFFFu;
+
+enum Containment
+{
+    OUTSIDE,
+    INTERSECTING,
+    INSIDE
+};
+
+// Half the surface area of a box, which is all the heuristic needs
+static float halfArea(const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+// Same test as Frustum::IntersectsAABB, also telling boxes entirely inside every plane apart
+static Containment classify(const Engine::Graphics::Frustum& frustum, const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    Containment result = INSIDE;
+    for (const glm::vec4& plane : frustum.planes)
+    {
+        float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+        if (distance + radius < 0.0f)
+            return OUTSIDE;
+        if (distance - radius < 0.0f)
+            result = INTERSECTING;
+    }
+    return result;
+}
+
+static bool overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+{
+    return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y
+           && minA.z <= maxB.z && maxA.z >= minB.z;
+}
+
+// Slab test; returns the distance where the ray enters the box (0 if it starts inside)
+static bool intersectRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance,
+                         const glm::vec3& min, const glm::vec3& max, float& distance)
+{
+    glm::vec3 t0 = (min - origin) * inverseDirection;
+    glm::vec3 t1 = (max - origin) * inverseDirection;
+    glm::vec3 entering = glm::min(t0, t1);
+    glm::vec3 leaving = glm::max(t0, t1);
+    float enter = std::max(std::max(entering.x, entering.y), std::max(entering.z, 0.0f));
+    float exit = std::min(std::min(leaving.x, leaving.y), std::min(leaving.z, maxDistance));
+    distance = enter;
+    return enter <= exit;
+}
+
+struct Engine::Graphics::BVH::BuildEntry
+{
+    glm::vec3 min, max;
+    glm::vec3 centroid;
+    uint32_t object;
+};
+
+Engine::Graphics::BVH::BVH()
+{
+}
+
+void Engine::Graphics::BVH::Build(const std::vector<AABB>& bounds)
+{
+    Clear();
+    if (bounds.empty())
+        return;
+
+    uint32_t count = (uint32_t)bounds.size();
+    objectBounds = bounds;
+    objects.resize(count);
+    objectLeaves.resize(count);
+    std::vector<BuildEntry> entries(count);
+    for (uint32_t i = 0; i < count; i++)
+        entries[i] = BuildEntry{bounds[i].min, bounds[i].max, (bounds[i].min + bounds[i].max) * 0.5f, i};
+
+    // A binary tree over n leaves has at most 2n - 1 nodes, so the vector never reallocates while building
+    nodes.reserve(2 * (size_t)count - 1);
+    parents.reserve(2 * (size_t)count - 1);
+    nodes.push_back(BVHNode());
+    parents.push_back(NO_PARENT);
+    buildNode(0, entries.data(), 0, count, 0);
+    for (uint32_t i = 0; i < count; i++)
+        objects[i] = entries[i].object;
+    dirty.assign(nodes.size(), 0);
+}
+
+void Engine::Graphics::BVH::buildNode(uint32_t node, BuildEntry* entries, uint32_t first, uint32_t count, int depth)
+{
+    glm::vec3 min(INFINITY), max(-INFINITY);
+    glm::vec3 centroidMin(INFINITY), centroidMax(-INFINITY);
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        min = glm::min(min, entries[i].min);
+        max = glm::max(max, entries[i].max);
+        centroidMin = glm::min(centroidMin, entries[i].centroid);
+        centroidMax = glm::max(centroidMax, entries[i].centroid);
+    }
+    nodes[node].min = min;
+    nodes[node].max = max;
+
+    auto makeLeaf = [&]() {
+        nodes[node].first = first;
+        nodes[node].count = count;
+        for (uint32_t i = first; i < first + count; i++)
+            objectLeaves[entries[i].object] = node;
+    };
+
+    if (count <= 2 || depth >= MAX_DEPTH)
+    {
+        makeLeaf();
+        return;
+    }
+
+    glm::vec3 extent = centroidMax - centroidMin;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    uint32_t middle;
+    if (extent[axis] <= 0.0f)
+    {
+        // Every centroid coincides, so no plane separates them; halve the list if the leaf would be too big
+        if (count <= (uint32_t)MAX_LEAF_SIZE)
+        {
+            makeLeaf();
+            return;
+        }
+        middle = first + count / 2;
+    }
+    else
+    {
+        struct Bin
+        {
+            glm::vec3 min = glm::vec3(INFINITY);
+            glm::vec3 max = glm::vec3(-INFINITY);
+            uint32_t count = 0;
+        };
+        Bin bins[BINS];
+        float scale = BINS / extent[axis];
+        float offset = centroidMin[axis];
+        auto binOf = [&](const BuildEntry& entry) {
+            return std::min(BINS - 1, (int)((entry.centroid[axis] - offset) * scale));
+        };
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            Bin& bin = bins[binOf(entries[i])];
+            bin.min = glm::min(bin.min, entries[i].min);
+            bin.max = glm::max(bin.max, entries[i].max);
+            bin.count++;
+        }
+
+        // Cost of splitting after bin i: the area of each side times the objects it holds
+        float rightCost[BINS];
+        glm::vec3 sideMin(INFINITY), sideMax(-INFINITY);
+        uint32_t sideCount = 0;
+        for (int i = BINS - 1; i > 0; i--)
+        {
+            sideMin = glm::min(sideMin, bins[i].min);
+            sideMax = glm::max(sideMax, bins[i].max);
+            sideCount += bins[i].count;
+            rightCost[i - 1] = sideCount > 0 ? halfArea(sideMin, sideMax) * sideCount : 0.0f;
+        }
+
+        int bestSplit = -1;
+        float bestCost = INFINITY;
+        sideMin = glm::vec3(INFINITY);
+        sideMax = glm::vec3(-INFINITY);
+        sideCount = 0;
+        for (int i = 0; i < BINS - 1; i++)
+        {
+            sideMin = glm::min(sideMin, bins[i].min);
+            sideMax = glm::max(sideMax, bins[i].max);
+            sideCount += bins[i].count;
+            if (sideCount == 0 || sideCount == count)
+                continue;
+            float cost = halfArea(sideMin, sideMax) * sideCount + rightCost[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        // Testing the node's box costs about as much as testing one object
+        float area = halfArea(min, max);
+        float leafCost = area * count;
+        if (bestSplit < 0 || (count <= (uint32_t)MAX_LEAF_SIZE && area + bestCost >= leafCost))
+        {
+            makeLeaf();
+            return;
+        }
+
+        BuildEntry* split = std::partition(entries + first, entries + first + count,
+                                           [&](const BuildEntry& entry) { return binOf(entry) <= bestSplit; });
+        middle = (uint32_t)(split - entries);
+    }
+
+    uint32_t left = (uint32_t)nodes.size();
+    nodes.push_back(BVHNode());
+    nodes.push_back(BVHNode());
+    parents.push_back(node);
+    parents.push_back(node);
+    nodes[node].first = left;
+    nodes[node].count = 0;
+    buildNode(left, entries, first, middle - first, depth + 1);
+    buildNode(left + 1, entries, middle, first + count - middle, depth + 1);
+}
+
+void Engine::Graphics::BVH::Clear()
+{
+    nodes.clear();
+    parents.clear();
+    objects.clear();
+    objectBounds.clear();
+    objectLeaves.clear();
+    dirtyNodes.clear();
+    dirty.clear();
+}
+
+void Engine::Graphics::BVH::SetBounds(uint32_t object, const AABB& bounds)
+{
+    objectBounds[object] = bounds;
+
+    // Queue the leaf and its ancestors, stopping at the first one an earlier move already queued
+    uint32_t node = objectLeaves[object];
+    while (node != NO_PARENT && !dirty[node])
+    {
+        dirty[node] = 1;
+        dirtyNodes.push_back(node);
+        node = parents[node];
+    }
+}
+
+void Engine::Graphics::BVH::Refit()
+{
+    // Children always have higher indices than their parent, so descending order fits them first
+    std::sort(dirtyNodes.begin(), dirtyNodes.end(), [](uint32_t a, uint32_t b) { return a > b; });
+    for (uint32_t node : dirtyNodes)
+    {
+        fitNode(node);
+        dirty[node] = 0;
+    }
+    dirtyNodes.clear();
+}
+
+void Engine::Graphics::BVH::fitNode(uint32_t node)
+{
+    BVHNode& current = nodes[node];
+    if (current.count > 0)
+    {
+        current.min = glm::vec3(INFINITY);
+        current.max = glm::vec3(-INFINITY);
+        for (uint32_t i = current.first; i < current.first + current.count; i++)
+        {
+            current.min = glm::min(current.min, objectBounds[objects[i]].min);
+            current.max = glm::max(current.max, objectBounds[objects[i]].max);
+        }
+    }
+    else
+    {
+        const BVHNode& left = nodes[current.first];
+        const BVHNode& right = nodes[current.first + 1];
+        current.min = glm::min(left.min, right.min);
+        current.max = glm::max(left.max, right.max);
+    }
+}
+
+size_t Engine::Graphics::BVH::QueryFrustum(const Frustum& frustum, uint32_t* results) const
+{
+    if (nodes.empty())
+        return 0;
+
+    size_t count = 0;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        uint32_t entry = stack[--top];
+        const BVHNode& node = nodes[entry & ~INSIDE_BIT];
+        bool inside = (entry & INSIDE_BIT) != 0;
+        if (!inside)
+        {
+            Containment containment = classify(frustum, node.min, node.max);
+            if (containment == OUTSIDE)
+                continue;
+            inside = containment == INSIDE;
+        }
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                uint32_t object = objects[i];
+                if (inside || classify(frustum, objectBounds[object].min, objectBounds[object].max) != OUTSIDE)
+                    results[count++] = object;
+            }
+        }
+        else
+        {
+            uint32_t flag = inside ? INSIDE_BIT : 0;
+            stack[top++] = (node.first + 1) | flag;
+            stack[top++] = node.first | flag;
+        }
+    }
+    return count;
+}
+
+size_t Engine::Graphics::BVH::QuerySphere(const glm::vec3& center, float radius, uint32_t* results) const
+{
+    if (nodes.empty())
+        return 0;
+
+    size_t count = 0;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const BVHNode& node = nodes[stack[--top]];
+        if (!SphereIntersectsAABB(center, radius, node.min, node.max))
+            continue;
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                const AABB& bounds = objectBounds[objects[i]];
+                if (SphereIntersectsAABB(center, radius, bounds.min, bounds.max))
+                    results[count++] = objects[i];
+            }
+        }
+        else
+        {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+        }
+    }
+    return count;
+}
+
+size_t Engine::Graphics::BVH::QueryAABB(const AABB& query, uint32_t* results) const
+{
+    if (nodes.empty())
+        return 0;
+
+    size_t count = 0;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const BVHNode& node = nodes[stack[--top]];
+        if (!overlaps(query.min, query.max, node.min, node.max))
+            continue;
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                const AABB& bounds = objectBounds[objects[i]];
+                if (overlaps(query.min, query.max, bounds.min, bounds.max))
+                    results[count++] = objects[i];
+            }
+        }
+        else
+        {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+        }
+    }
+    return count;
+}
+
+bool Engine::Graphics::BVH::OverlapsSphere(const glm::vec3& center, float radius) const
+{
+    if (nodes.empty())
+        return false;
+
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const BVHNode& node = nodes[stack[--top]];
+        if (!SphereIntersectsAABB(center, radius, node.min, node.max))
+            continue;
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                const AABB& bounds = objectBounds[objects[i]];
+                if (SphereIntersectsAABB(center, radius, bounds.min, bounds.max))
+                    return true;
+            }
+        }
+        else
+        {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+        }
+    }
+    return false;
+}
+
+bool Engine::Graphics::BVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                                    BVHHit& hit) const
+{
+    if (nodes.empty())
+        return false;
+
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float closest = maxDistance;
+    bool found = false;
+
+    // Each entry keeps the distance where the ray enters its box, so boxes behind a closer hit are skipped
+    uint32_t stack[STACK_SIZE];
+    float entry[STACK_SIZE];
+    int top = 0;
+    float distance;
+    if (!intersectRay(origin, inverseDirection, closest, nodes[0].min, nodes[0].max, distance))
+        return false;
+    stack[top] = 0;
+    entry[top++] = distance;
+    while (top > 0)
+    {
+        top--;
+        if (entry[top] > closest)
+            continue;
+        const BVHNode& node = nodes[stack[top]];
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                const AABB& bounds = objectBounds[objects[i]];
+                if (intersectRay(origin, inverseDirection, closest, bounds.min, bounds.max, distance))
+                {
+                    closest = distance;
+                    hit.object = objects[i];
+                    hit.distance = distance;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first by pushing it last
+        const BVHNode& left = nodes[node.first];
+        const BVHNode& right = nodes[node.first + 1];
+        float leftDistance, rightDistance;
+        bool hitLeft = intersectRay(origin, inverseDirection, closest, left.min, left.max, leftDistance);
+        bool hitRight = intersectRay(origin, inverseDirection, closest, right.min, right.max, rightDistance);
+        if (hitLeft && hitRight)
+        {
+            bool leftFirst = leftDistance <= rightDistance;
+            stack[top] = leftFirst ? node.first + 1 : node.first;
+            entry[top++] = leftFirst ? rightDistance : leftDistance;
+            stack[top] = leftFirst ? node.first : node.first + 1;
+            entry[top++] = leftFirst ? leftDistance : rightDistance;
+        }
+        else if (hitLeft || hitRight)
+        {
+            stack[top] = hitLeft ? node.first : node.first + 1;
+            entry[top++] = hitLeft ? leftDistance : rightDistance;
+        }
+    }
+    return found;
+}
+
+Engine::Graphics::AABB Engine::Graphics::BVH::GetBounds() const
+{
+    AABB bounds;
+    if (!nodes.empty())
+    {
+        bounds.min = nodes[0].min;
+        bounds.max = nodes[0].max;
+    }
+    return bounds;
+}
+
+const Engine::Graphics::AABB& Engine::Graphics::BVH::GetObjectBounds(uint32_t object) const
+{
+    return objectBounds[object];
+}
+
+size_t Engine::Graphics::BVH::GetObjectCount() const
+{
+    return objectBounds.size();
+}
+
+size_t Engine::Graphics::BVH::GetNodeCount() const
+{
+    return nodes.size();
+}
+
+float Engine::Graphics::BVH::GetCost() const
+{
+    if (nodes.empty())
+        return 0.0f;
+
+    // Chance of a ray hitting a box given it hits the root is the ratio of their surface areas
+    float rootArea = halfArea(nodes[0].min, nodes[0].max);
+    if (rootArea <= 0.0f)
+        return (float)objectBounds.size();
+    float cost = 0.0f;
+    for (const BVHNode& node : nodes)
+        cost += halfArea(node.min, node.max) / rootArea * (node.count > 0 ? node.count : 1);
+    return cost;
+}
@@ -0,0 +1,106 @@
+#ifndef ENGINE_GRAPHICS_BVH_HPP
+#define ENGINE_GRAPHICS_BVH_HPP
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frustum.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Axis aligned box
+struct AABB
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+// Node of a BVH, 32 bytes. Children are allocated in pairs after their parent.
+struct BVHNode
+{
+    glm::vec3 min;
+    // Leaves: first entry of the leaf in the object list; inner nodes: index of the left child (the
+    // right one follows it)
+    uint32_t first;
+    glm::vec3 max;
+    // Objects in a leaf, 0 for inner nodes
+    uint32_t count;
+};
+
+// Closest object hit by a ray
+struct BVHHit
+{
+    uint32_t object = 0;
+    float distance = 0.0f;
+};
+
+// Bounding volume hierarchy over a fixed set of object boxes. Build splits the objects with the surface
+// area heuristic (binned along the widest axis of the centroids); moving objects afterwards only marks
+// the nodes above them, and Refit grows or shrinks just those. Refitting keeps the tree valid but not
+// optimal, so after large motions compare GetCost() with a fresh build and rebuild when it degrades.
+// Queries write object indices (as given to Build) and need room for GetObjectCount() of them.
+class BVH
+{
+public:
+    static const int BINS = 16;
+    static const int MAX_LEAF_SIZE = 8;
+    // Deeper subtrees become leaves, which bounds the traversal stack
+    static const int MAX_DEPTH = 48;
+
+    BVH();
+
+    // Rebuilds the tree over the given boxes
+    void Build(const std::vector<AABB>& bounds);
+    void Clear();
+
+    // Moves an object; takes effect in the tree on the next Refit
+    void SetBounds(uint32_t object, const AABB& bounds);
+    // Updates the nodes above the objects moved since the last refit
+    void Refit();
+
+    // Objects whose box intersects the frustum. Subtrees entirely inside are added without testing
+    // their objects.
+    size_t QueryFrustum(const Frustum& frustum, uint32_t* results) const;
+    // Objects whose box overlaps a sphere or another box
+    size_t QuerySphere(const glm::vec3& center, float radius, uint32_t* results) const;
+    size_t QueryAABB(const AABB& bounds, uint32_t* results) const;
+    // True if any object box overlaps the sphere, stopping at the first one
+    bool OverlapsSphere(const glm::vec3& center, float radius) const;
+    // Closest object box hit by a ray within maxDistance; direction need not be normalized, distances
+    // are in units of its length
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BVHHit& hit) const;
+
+    // Box around every object, zero sized when empty
+    AABB GetBounds() const;
+    const AABB& GetObjectBounds(uint32_t object) const;
+    size_t GetObjectCount() const;
+    size_t GetNodeCount() const;
+    // Surface area heuristic cost of the tree relative to its root: expected box tests per random ray
+    float GetCost() const;
+
+private:
+    // Copy of an object's box that moves with it while building, so each pass reads memory in order
+    struct BuildEntry;
+
+    void buildNode(uint32_t node, BuildEntry* entries, uint32_t first, uint32_t count, int depth);
+    // Recomputes a node's bounds from its objects or children
+    void fitNode(uint32_t node);
+
+    std::vector<BVHNode> nodes;
+    // Parent of every node, for walking up from a moved object
+    std::vector<uint32_t> parents;
+    // Object indices, each leaf owning a contiguous range
+    std::vector<uint32_t> objects;
+    std::vector<AABB> objectBounds;
+    // Leaf holding each object
+    std::vector<uint32_t> objectLeaves;
+    // Nodes whose bounds are stale, and a flag per node so each is only queued once
+    std::vector<uint32_t> dirtyNodes;
+    std::vector<uint8_t> dirty;
+};
+}}
+
+#endif
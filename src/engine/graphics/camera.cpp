@@ -1,4 +1,5 @@
 #include "camera.hpp"
+#include <cmath>
 
 // Constructor with vectors
 Engine::Graphics::Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch)
@@ -29,12 +30,32 @@ Engine::Graphics::Camera::Camera(float posX, float posY, float posZ, float upX,
 }
 
 // Returns the view matrix calculated using Euler Angles and the LookAt Matrix
-glm::mat4 Engine::Graphics::Camera::GetViewMatrix()
+glm::mat4 Engine::Graphics::Camera::GetViewMatrix() const
 {
    // The glm::LookAt function requires a position, target and up vector respectively.
    return glm::lookAt(Position, Position + Front, Up);
 }
 
+glm::mat4 Engine::Graphics::Camera::GetProjectionMatrix(float aspect, float nearPlane, float farPlane) const
+{
+   return glm::perspective(glm::radians(zoom), aspect, nearPlane, farPlane);
+}
+
+Engine::Graphics::Frustum Engine::Graphics::Camera::GetFrustum(float aspect, float nearPlane, float farPlane) const
+{
+   return Frustum::FromMatrix(GetProjectionMatrix(aspect, nearPlane, farPlane) * GetViewMatrix());
+}
+
+glm::vec3 Engine::Graphics::Camera::GetCursorRay(const glm::vec2& cursor, const glm::vec2& viewportSize, float aspect) const
+{
+   // Normalized device coordinates, y pointing up, scaled to the extent of the image plane at distance 1
+   float halfHeight = std::tan(glm::radians(zoom) * 0.5f);
+   float halfWidth = halfHeight * aspect;
+   float x = (2.0f * cursor.x / viewportSize.x - 1.0f) * halfWidth;
+   float y = (1.0f - 2.0f * cursor.y / viewportSize.y) * halfHeight;
+   return glm::normalize(Front + x * Right + y * Up);
+}
+
 // Processes input received from any keyboard-like input system
 void Engine::Graphics::Camera::ProcessKeyboard(Camera_Movement direction, float deltaTime)
 {
@@ -99,3 +120,12 @@ void Engine::Graphics::Camera::updateCameraVectors()
 float Engine::Graphics::Camera::GetZoom() const{
     return zoom;
 }
+
+// Turns the camera towards a point, keeping its position
+void Engine::Graphics::Camera::LookAt(const glm::vec3& target)
+{
+   glm::vec3 direction = glm::normalize(target - Position);
+   yaw = glm::degrees(std::atan2(direction.z, direction.x));
+   pitch = glm::clamp(glm::degrees(std::asin(direction.y)), -89.0f, 89.0f);
+   updateCameraVectors();
+}
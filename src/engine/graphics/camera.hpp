@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "frustum.hpp"
+
 namespace Engine{
 namespace Graphics{
 
@@ -41,7 +43,14 @@ public:
            float yaw, float pitch);
 
     // Returns the view matrix calculated using Euler Angles and the LookAt Matrix
-    glm::mat4 GetViewMatrix();
+    glm::mat4 GetViewMatrix() const;
+    // Returns the perspective projection for the camera's zoom (vertical field of view in degrees)
+    glm::mat4 GetProjectionMatrix(float aspect, float nearPlane, float farPlane) const;
+    // Returns the planes of the view frustum in world space
+    Frustum GetFrustum(float aspect, float nearPlane, float farPlane) const;
+    // Returns the normalized world space direction of the ray from Position through a cursor position
+    // (in pixels from the top left corner of the viewport), for a projection with the given aspect ratio
+    glm::vec3 GetCursorRay(const glm::vec2& cursor, const glm::vec2& viewportSize, float aspect) const;
 
     // Processes input received from any keyboard-like input system
     void ProcessKeyboard(Camera_Movement direction, float deltaTime);
@@ -54,6 +63,9 @@ public:
 
     float GetZoom() const;
 
+    // Turns the camera towards a point, keeping its position
+    void LookAt(const glm::vec3& target);
+
 private:
     // Calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors();
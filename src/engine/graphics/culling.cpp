@@ -0,0 +1,319 @@
+#include "culling.hpp"
+#include <cmath>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_CULL_SSE 1
+#include <immintrin.h>
+// GCC and Clang compile the AVX path for the function alone, so it exists even without -mavx and is
+// only run once the CPU reports support; other compilers need AVX enabled for the whole build
+#if defined(__GNUC__) || defined(__clang__)
+#define ENGINE_CULL_AVX 1
+#define ENGINE_CULL_AVX_TARGET __attribute__((target("avx")))
+#elif defined(__AVX__)
+#define ENGINE_CULL_AVX 1
+#define ENGINE_CULL_AVX_TARGET
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ENGINE_CULL_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Frustum planes split into one array per component; abs holds |normal| for the box radius
+struct CullPlanes
+{
+    float x[6], y[6], z[6], w[6];
+    float absX[6], absY[6], absZ[6];
+};
+
+static CullPlanes preparePlanes(const Engine::Graphics::Frustum& frustum)
+{
+    CullPlanes planes;
+    for (int i = 0; i < 6; i++)
+    {
+        planes.x[i] = frustum.planes[i].x;
+        planes.y[i] = frustum.planes[i].y;
+        planes.z[i] = frustum.planes[i].z;
+        planes.w[i] = frustum.planes[i].w;
+        planes.absX[i] = std::fabs(planes.x[i]);
+        planes.absY[i] = std::fabs(planes.y[i]);
+        planes.absZ[i] = std::fabs(planes.z[i]);
+    }
+    return planes;
+}
+
+// Appends the indices of the set bits of a lane mask without branching: every lane is written, but
+// the count only advances past visible ones
+static inline size_t appendVisible(uint32_t* visible, size_t count, uint32_t first, unsigned int mask, int lanes)
+{
+    for (int lane = 0; lane < lanes; lane++)
+    {
+        visible[count] = first + lane;
+        count += (mask >> lane) & 1;
+    }
+    return count;
+}
+
+// Lanes past the last box hold padding and are never visible
+static inline unsigned int tailMask(size_t remaining, int lanes)
+{
+    return remaining >= (size_t)lanes ? (1u << lanes) - 1 : (1u << remaining) - 1;
+}
+
+// A box is outside when its center lies further behind a plane than the box's radius along the normal:
+// dot(n, c) + w + dot(|n|, e) < 0
+static size_t cullScalar(const CullPlanes& planes, const Engine::Graphics::CullBounds& bounds, uint32_t* visible)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < bounds.GetCount(); i++)
+    {
+        bool inside = true;
+        for (int p = 0; p < 6; p++)
+        {
+            float distance = planes.x[p] * bounds.centerX[i] + planes.y[p] * bounds.centerY[i]
+                             + planes.z[p] * bounds.centerZ[i] + planes.w[p];
+            float radius = planes.absX[p] * bounds.extentX[i] + planes.absY[p] * bounds.extentY[i]
+                           + planes.absZ[p] * bounds.extentZ[i];
+            if (distance + radius < 0.0f)
+            {
+                inside = false;
+                break;
+            }
+        }
+        visible[count] = (uint32_t)i;
+        count += inside;
+    }
+    return count;
+}
+
+#ifdef ENGINE_CULL_SSE
+static size_t cullSSE(const CullPlanes& planes, const Engine::Graphics::CullBounds& bounds, uint32_t* visible)
+{
+    size_t count = 0;
+    const __m128 zero = _mm_setzero_ps();
+    for (size_t i = 0; i < bounds.GetCount(); i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+        __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+        __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+        __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+        __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+
+        __m128 outside = zero;
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(planes.x[p]), cx), _mm_mul_ps(_mm_set1_ps(planes.y[p]), cy)),
+                _mm_mul_ps(_mm_set1_ps(planes.z[p]), cz)), _mm_set1_ps(planes.w[p]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(planes.absX[p]), ex), _mm_mul_ps(_mm_set1_ps(planes.absY[p]), ey)),
+                _mm_mul_ps(_mm_set1_ps(planes.absZ[p]), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        unsigned int mask = ~(unsigned int)_mm_movemask_ps(outside) & tailMask(bounds.GetCount() - i, 4);
+        count = appendVisible(visible, count, (uint32_t)i, mask, 4);
+    }
+    return count;
+}
+#endif
+
+#ifdef ENGINE_CULL_AVX
+ENGINE_CULL_AVX_TARGET
+static size_t cullAVX(const CullPlanes& planes, const Engine::Graphics::CullBounds& bounds, uint32_t* visible)
+{
+    size_t count = 0;
+    const __m256 zero = _mm256_setzero_ps();
+    for (size_t i = 0; i < bounds.GetCount(); i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+        __m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+        __m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+        __m256 ex = _mm256_loadu_ps(&bounds.extentX[i]);
+        __m256 ey = _mm256_loadu_ps(&bounds.extentY[i]);
+        __m256 ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+
+        __m256 outside = zero;
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(planes.x[p]), cx), _mm256_mul_ps(_mm256_set1_ps(planes.y[p]), cy)),
+                _mm256_mul_ps(_mm256_set1_ps(planes.z[p]), cz)), _mm256_set1_ps(planes.w[p]));
+            __m256 radius = _mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(planes.absX[p]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.absY[p]), ey)),
+                _mm256_mul_ps(_mm256_set1_ps(planes.absZ[p]), ez));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+        }
+
+        unsigned int mask = ~(unsigned int)_mm256_movemask_ps(outside) & tailMask(bounds.GetCount() - i, 8);
+        count = appendVisible(visible, count, (uint32_t)i, mask, 8);
+    }
+    return count;
+}
+#endif
+
+#ifdef ENGINE_CULL_NEON
+static size_t cullNEON(const CullPlanes& planes, const Engine::Graphics::CullBounds& bounds, uint32_t* visible)
+{
+    size_t count = 0;
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < bounds.GetCount(); i += 4)
+    {
+        float32x4_t cx = vld1q_f32(&bounds.centerX[i]);
+        float32x4_t cy = vld1q_f32(&bounds.centerY[i]);
+        float32x4_t cz = vld1q_f32(&bounds.centerZ[i]);
+        float32x4_t ex = vld1q_f32(&bounds.extentX[i]);
+        float32x4_t ey = vld1q_f32(&bounds.extentY[i]);
+        float32x4_t ez = vld1q_f32(&bounds.extentZ[i]);
+
+        uint32x4_t outside = vdupq_n_u32(0);
+        for (int p = 0; p < 6; p++)
+        {
+            float32x4_t distance = vaddq_f32(vaddq_f32(vaddq_f32(
+                vmulq_n_f32(cx, planes.x[p]), vmulq_n_f32(cy, planes.y[p])),
+                vmulq_n_f32(cz, planes.z[p])), vdupq_n_f32(planes.w[p]));
+            float32x4_t radius = vaddq_f32(vaddq_f32(
+                vmulq_n_f32(ex, planes.absX[p]), vmulq_n_f32(ey, planes.absY[p])),
+                vmulq_n_f32(ez, planes.absZ[p]));
+            outside = vorrq_u32(outside, vcltq_f32(vaddq_f32(distance, radius), zero));
+        }
+
+        // One bit per lane, like movemask
+        unsigned int mask = (vgetq_lane_u32(outside, 0) & 1) | (vgetq_lane_u32(outside, 1) & 2)
+                            | (vgetq_lane_u32(outside, 2) & 4) | (vgetq_lane_u32(outside, 3) & 8);
+        mask = ~mask & tailMask(bounds.GetCount() - i, 4);
+        count = appendVisible(visible, count, (uint32_t)i, mask, 4);
+    }
+    return count;
+}
+#endif
+
+Engine::Graphics::CullBounds::CullBounds() : count(0)
+{
+}
+
+uint32_t Engine::Graphics::CullBounds::Add(const glm::vec3& min, const glm::vec3& max)
+{
+    // Grow a whole padding block at a time; new entries are zero sized boxes at the origin
+    if (count == centerX.size())
+    {
+        for (std::vector<float>* array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+            array->resize(count + PADDING, 0.0f);
+    }
+
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    centerX[count] = center.x;
+    centerY[count] = center.y;
+    centerZ[count] = center.z;
+    extentX[count] = extent.x;
+    extentY[count] = extent.y;
+    extentZ[count] = extent.z;
+    return (uint32_t)count++;
+}
+
+void Engine::Graphics::CullBounds::Clear()
+{
+    for (std::vector<float>* array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+        array->clear();
+    count = 0;
+}
+
+void Engine::Graphics::CullBounds::Reserve(size_t boxes)
+{
+    size_t padded = (boxes + PADDING - 1) / PADDING * PADDING;
+    for (std::vector<float>* array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+        array->reserve(padded);
+}
+
+size_t Engine::Graphics::CullBounds::GetCount() const
+{
+    return count;
+}
+
+size_t Engine::Graphics::CullBounds::GetPaddedCount() const
+{
+    return centerX.size();
+}
+
+size_t Engine::Graphics::CullAABBs(const Frustum& frustum, const CullBounds& bounds, uint32_t* visible, CullPath path)
+{
+    if (path == CullPath::Best || !IsCullPathSupported(path))
+        path = GetBestCullPath();
+
+    CullPlanes planes = preparePlanes(frustum);
+    switch (path)
+    {
+#ifdef ENGINE_CULL_AVX
+    case CullPath::AVX:
+        return cullAVX(planes, bounds, visible);
+#endif
+#ifdef ENGINE_CULL_SSE
+    case CullPath::SSE:
+        return cullSSE(planes, bounds, visible);
+#endif
+#ifdef ENGINE_CULL_NEON
+    case CullPath::NEON:
+        return cullNEON(planes, bounds, visible);
+#endif
+    default:
+        return cullScalar(planes, bounds, visible);
+    }
+}
+
+bool Engine::Graphics::IsCullPathSupported(CullPath path)
+{
+    switch (path)
+    {
+    case CullPath::Best:
+    case CullPath::Scalar:
+        return true;
+#ifdef ENGINE_CULL_SSE
+    case CullPath::SSE:
+        return true;
+#endif
+#ifdef ENGINE_CULL_AVX
+    case CullPath::AVX:
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_cpu_supports("avx");
+#else
+        return true;
+#endif
+#endif
+#ifdef ENGINE_CULL_NEON
+    case CullPath::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+Engine::Graphics::CullPath Engine::Graphics::GetBestCullPath()
+{
+    static const CullPath best = IsCullPathSupported(CullPath::AVX)    ? CullPath::AVX
+                                 : IsCullPathSupported(CullPath::SSE)  ? CullPath::SSE
+                                 : IsCullPathSupported(CullPath::NEON) ? CullPath::NEON
+                                                                       : CullPath::Scalar;
+    return best;
+}
+
+const char* Engine::Graphics::GetCullPathName(CullPath path)
+{
+    switch (path)
+    {
+    case CullPath::Best:
+        return GetCullPathName(GetBestCullPath());
+    case CullPath::SSE:
+        return "sse";
+    case CullPath::AVX:
+        return "avx";
+    case CullPath::NEON:
+        return "neon";
+    default:
+        return "scalar";
+    }
+}
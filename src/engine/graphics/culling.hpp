@@ -0,0 +1,64 @@
+#ifndef ENGINE_GRAPHICS_CULLING_HPP
+#define ENGINE_GRAPHICS_CULLING_HPP
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frustum.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Instruction sets the batch culling can use. Best picks the widest one the CPU supports.
+enum class CullPath
+{
+    Best,
+    Scalar,
+    SSE,
+    AVX,
+    NEON
+};
+
+// Axis aligned boxes stored as separate center and half extent arrays (structure of arrays), so the
+// SIMD paths load four or eight boxes per instruction. Arrays are padded with empty boxes to a
+// multiple of PADDING.
+class CullBounds
+{
+public:
+    static const size_t PADDING = 8;
+
+    CullBounds();
+
+    // Appends a box and returns its index
+    uint32_t Add(const glm::vec3& min, const glm::vec3& max);
+    void Clear();
+    // Reserves room for a number of boxes
+    void Reserve(size_t count);
+
+    size_t GetCount() const;
+    // Size of the arrays, which is also the room CullAABBs needs for its output
+    size_t GetPaddedCount() const;
+
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+private:
+    size_t count;
+};
+
+// Writes the indices of the boxes intersecting the frustum to visible, in increasing order, and returns
+// how many there are. visible must have room for bounds.GetPaddedCount() indices.
+// The test is the same conservative one as Frustum::IntersectsAABB; the paths only differ in rounding
+// for boxes touching a plane.
+size_t CullAABBs(const Frustum& frustum, const CullBounds& bounds, uint32_t* visible, CullPath path = CullPath::Best);
+
+// True if the path was compiled in and the CPU can run it
+bool IsCullPathSupported(CullPath path);
+// Resolves Best to the path that would be used
+CullPath GetBestCullPath();
+const char* GetCullPathName(CullPath path);
+}}
+
+#endif
@@ -0,0 +1,52 @@
+#include "frustum.hpp"
+
+Engine::Graphics::Frustum Engine::Graphics::Frustum::FromMatrix(const glm::mat4& viewProj)
+{
+    // glm matrices are column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+
+    // Normalize so that plane distances are in world units
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool Engine::Graphics::Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+bool Engine::Graphics::Frustum::IntersectsAABB(const glm::vec3& min, const glm::vec3& max) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        // Corner of the box furthest along the plane normal
+        glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x,
+                           plane.y >= 0.0f ? max.y : min.y,
+                           plane.z >= 0.0f ? max.z : min.z);
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Engine::Graphics::SphereIntersectsAABB(const glm::vec3& center, float radius, const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 offset = center - glm::clamp(center, min, max);
+    return glm::dot(offset, offset) <= radius * radius;
+}
@@ -0,0 +1,26 @@
+#ifndef ENGINE_GRAPHICS_FRUSTUM_HPP
+#define ENGINE_GRAPHICS_FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+
+namespace Engine{
+namespace Graphics{
+
+// View frustum as six planes (left, right, bottom, top, near, far) with normals pointing inwards
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // Extracts the planes of a view-projection matrix (Gribb/Hartmann)
+    static Frustum FromMatrix(const glm::mat4& viewProj);
+
+    // Conservative tests: may report an intersection for volumes just outside a frustum corner
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+    bool IntersectsAABB(const glm::vec3& min, const glm::vec3& max) const;
+};
+
+// Returns true if a sphere and an axis aligned box overlap
+bool SphereIntersectsAABB(const glm::vec3& center, float radius, const glm::vec3& min, const glm::vec3& max);
+}}
+
+#endif
@@ -0,0 +1,217 @@
+#include "geometryarena.hpp"
+#include "glstate.hpp"
+#include "renderstats.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+
+// Copies the start of one buffer into another through the copy targets, leaving the vertex array alone
+static void copyBuffer(GLuint from, GLuint to, GLsizeiptr size)
+{
+    Engine::Graphics::GLState::BindBuffer(GL_COPY_READ_BUFFER, from);
+    Engine::Graphics::GLState::BindBuffer(GL_COPY_WRITE_BUFFER, to);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+}
+
+// Writes part of a buffer through the copy write target, so index buffers can be filled without a vertex array
+static void writeBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    Engine::Graphics::RenderStats::Current().bufferUploads++;
+    Engine::Graphics::GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+}
+
+Engine::Graphics::GeometryArena::GeometryArena(VertexFormat format, uint32_t vertexCapacity, uint32_t indexCapacity)
+    : format(GetStorageFormat(format)), instanceCapacity(0), instanceSource(0), vertexAllocator(vertexCapacity),
+      indexAllocator(indexCapacity)
+{
+    // The index buffer binding is vertex array state, so the array must be bound when it is created
+    vao.Bind();
+    vertexBuffer = Buffers::VBO(nullptr, (GLsizeiptr)(vertexCapacity * GetVertexSize(this->format)), GL_STATIC_DRAW);
+    indexBuffer = Buffers::EBO((const void*)nullptr, (GLsizeiptr)indexCapacity * sizeof(GLuint));
+    linkVertices();
+    // Non-instanced draws still fetch instance 0, so the instance attributes always need a buffer
+    growInstances(1);
+}
+
+void Engine::Graphics::GeometryArena::linkVertices()
+{
+    vao.Bind();
+    LinkVertexFormat(vao, vertexBuffer, format);
+}
+
+void Engine::Graphics::GeometryArena::growVertices(uint32_t capacity)
+{
+    size_t vertexSize = GetVertexSize(format);
+    Buffers::VBO grown(nullptr, (GLsizeiptr)(capacity * vertexSize), GL_STATIC_DRAW);
+    copyBuffer(vertexBuffer.ID, grown.ID, (GLsizeiptr)(vertexAllocator.GetCapacity() * vertexSize));
+    vertexBuffer = std::move(grown);
+    vertexAllocator.Grow(capacity);
+    linkVertices();
+}
+
+void Engine::Graphics::GeometryArena::growIndices(uint32_t capacity)
+{
+    vao.Bind();
+    Buffers::EBO grown((const void*)nullptr, (GLsizeiptr)capacity * sizeof(GLuint));
+    copyBuffer(indexBuffer.ID, grown.ID, (GLsizeiptr)indexAllocator.GetCapacity() * sizeof(GLuint));
+    indexBuffer = std::move(grown);
+    indexAllocator.Grow(capacity);
+}
+
+void Engine::Graphics::GeometryArena::growInstances(size_t count)
+{
+    if (count <= instanceCapacity)
+        return;
+
+    // Grow geometrically so a slowly increasing instance count doesn't reallocate every frame
+    instanceCapacity = std::max(count, instanceCapacity * 2);
+    instanceBuffer = Buffers::VBO(nullptr, instanceCapacity * sizeof(glm::mat4), GL_STREAM_DRAW);
+
+    // A mat4 attribute takes four consecutive locations, one per column
+    vao.Bind();
+    for (GLuint column = 0; column < 4; column++)
+    {
+        vao.LinkInstanceAttrib(instanceBuffer, 3 + column, 4, GL_FLOAT, sizeof(glm::mat4),
+                               (void*)(column * sizeof(glm::vec4)));
+    }
+    instanceSource = instanceBuffer.ID;
+}
+
+void Engine::Graphics::GeometryArena::SetInstanceBuffer(GLuint buffer)
+{
+    if (buffer == 0)
+        buffer = instanceBuffer.ID;
+    if (buffer == instanceSource)
+        return;
+
+    // Same layout as growInstances; the divisors and enables are already set
+    vao.Bind();
+    GLState::BindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint column = 0; column < 4; column++)
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+    instanceSource = buffer;
+}
+
+Engine::Graphics::GeometryRange Engine::Graphics::GeometryArena::Allocate(const std::vector<Vertex>& vertices,
+                                                                          const std::vector<GLuint>& indices)
+{
+    std::vector<GLuint> sequential;
+    const std::vector<GLuint>* source = &indices;
+    if (indices.empty())
+    {
+        sequential.resize(vertices.size());
+        std::iota(sequential.begin(), sequential.end(), 0u);
+        source = &sequential;
+    }
+
+    GeometryRange range;
+    if (vertices.empty())
+        return range;
+    uint32_t vertexCount = (uint32_t)vertices.size();
+    uint32_t indexCount = (uint32_t)source->size();
+
+    uint32_t vertexOffset = vertexAllocator.Allocate(vertexCount);
+    if (vertexOffset == Core::OffsetAllocator::INVALID)
+    {
+        growVertices(std::max(vertexAllocator.GetCapacity() * 2, vertexAllocator.GetCapacity() + vertexCount));
+        vertexOffset = vertexAllocator.Allocate(vertexCount);
+    }
+    uint32_t indexOffset = indexAllocator.Allocate(indexCount);
+    if (indexOffset == Core::OffsetAllocator::INVALID)
+    {
+        growIndices(std::max(indexAllocator.GetCapacity() * 2, indexAllocator.GetCapacity() + indexCount));
+        indexOffset = indexAllocator.Allocate(indexCount);
+    }
+
+    // Neither format the arena stores depends on the mesh bounds
+    std::vector<unsigned char> encoded = EncodeVertices(vertices, format, glm::vec3(0.0f), glm::vec3(0.0f));
+    size_t vertexSize = GetVertexSize(format);
+    writeBuffer(vertexBuffer.ID, (GLintptr)(vertexOffset * vertexSize), (GLsizeiptr)encoded.size(), encoded.data());
+    writeBuffer(indexBuffer.ID, (GLintptr)indexOffset * sizeof(GLuint), (GLsizeiptr)indexCount * sizeof(GLuint),
+                source->data());
+
+    range.baseVertex = (GLint)vertexOffset;
+    range.vertexCount = vertexCount;
+    range.firstIndex = indexOffset;
+    range.indexCount = indexCount;
+    return range;
+}
+
+void Engine::Graphics::GeometryArena::Free(const GeometryRange& range)
+{
+    if (range.vertexCount == 0)
+        return;
+    vertexAllocator.Free((uint32_t)range.baseVertex, range.vertexCount);
+    indexAllocator.Free(range.firstIndex, range.indexCount);
+}
+
+void Engine::Graphics::GeometryArena::Bind()
+{
+    vao.Bind();
+}
+
+void Engine::Graphics::GeometryArena::Draw(const GeometryRange& range)
+{
+    RenderStats::Current().drawCalls++;
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+                             (void*)(range.firstIndex * sizeof(GLuint)), range.baseVertex);
+}
+
+void Engine::Graphics::GeometryArena::DrawInstanced(const GeometryRange& range, const glm::mat4* transforms, size_t count)
+{
+    growInstances(count);
+    SetInstanceBuffer(0);
+    // Every instanced draw of the frame shares the buffer; orphaning it lets the driver hand out fresh
+    // storage instead of waiting for the previous draw to finish reading
+    GLState::BindBuffer(GL_ARRAY_BUFFER, instanceBuffer.ID);
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    instanceBuffer.Update(transforms, count * sizeof(glm::mat4));
+
+    vao.Bind();
+    RenderStats::Current().drawCalls++;
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+                                      (void*)(range.firstIndex * sizeof(GLuint)), count, range.baseVertex);
+}
+
+Engine::Graphics::VertexFormat Engine::Graphics::GeometryArena::GetFormat() const
+{
+    return format;
+}
+
+GLuint Engine::Graphics::GeometryArena::GetVertexBuffer() const
+{
+    return vertexBuffer.ID;
+}
+
+GLuint Engine::Graphics::GeometryArena::GetIndexBuffer() const
+{
+    return indexBuffer.ID;
+}
+
+Engine::Graphics::VertexFormat Engine::Graphics::GeometryArena::GetStorageFormat(VertexFormat format)
+{
+    return format == VertexFormat::Quantized ? VertexFormat::Compact : format;
+}
+
+const Engine::Core::OffsetAllocator& Engine::Graphics::GeometryArena::GetVertexAllocator() const
+{
+    return vertexAllocator;
+}
+
+const Engine::Core::OffsetAllocator& Engine::Graphics::GeometryArena::GetIndexAllocator() const
+{
+    return indexAllocator;
+}
+
+void Engine::Graphics::GeometryArena::Delete()
+{
+    instanceBuffer.Delete();
+    indexBuffer.Delete();
+    vertexBuffer.Delete();
+    vao.Delete();
+    instanceCapacity = 0;
+    instanceSource = 0;
+    vertexAllocator = Core::OffsetAllocator();
+    indexAllocator = Core::OffsetAllocator();
+}
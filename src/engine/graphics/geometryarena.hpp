@@ -0,0 +1,88 @@
+#ifndef ENGINE_GRAPHICS_GEOMETRYARENA_HPP
+#define ENGINE_GRAPHICS_GEOMETRYARENA_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../core/offsetallocator.hpp"
+#include "buffers/ebo.hpp"
+#include "buffers/vao.hpp"
+#include "buffers/vbo.hpp"
+#include "vertex.hpp"
+#include "vertexformat.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Where a mesh lives in a GeometryArena. Indices are relative to baseVertex.
+struct GeometryRange
+{
+    GLint baseVertex = 0;
+    GLuint vertexCount = 0;
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+};
+
+// Vertices and indices of many meshes in one vertex buffer and one index buffer, drawn through a single
+// vertex array, so switching meshes needs no rebinding. Ranges are sub-allocated with an
+// OffsetAllocator per buffer; when one is full the buffer is doubled and its contents copied on the GPU.
+// The vertex array also holds the per-instance model matrices (attributes 3-6) for DrawInstanced.
+// Every mesh is stored in the arena's vertex format.
+class GeometryArena
+{
+public:
+    // Meshes are stored in GetStorageFormat(format)
+    explicit GeometryArena(VertexFormat format = VertexFormat::Float, uint32_t vertexCapacity = 1 << 16,
+                           uint32_t indexCapacity = 1 << 18);
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // Copies a mesh into the arena. Meshes without indices get a sequential list, so every range is
+    // drawn the same way.
+    GeometryRange Allocate(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+    void Free(const GeometryRange& range);
+
+    void Bind();
+    // Draw a range; the arena must be bound
+    void Draw(const GeometryRange& range);
+    void DrawInstanced(const GeometryRange& range, const glm::mat4* transforms, size_t count);
+    // Points the instance attributes at another buffer of mat4s (e.g. one written by a compute shader),
+    // or back at the arena's own with 0. Relinks only when the buffer changes.
+    void SetInstanceBuffer(GLuint buffer);
+
+    VertexFormat GetFormat() const;
+    GLuint GetVertexBuffer() const;
+    // Format an arena created with a format stores meshes in. Quantized positions are relative to each
+    // mesh's bounds, which one vertex array can't decode for every range, so they are stored as Compact.
+    static VertexFormat GetStorageFormat(VertexFormat format);
+    GLuint GetIndexBuffer() const;
+    const Core::OffsetAllocator& GetVertexAllocator() const;
+    const Core::OffsetAllocator& GetIndexAllocator() const;
+
+    // Deletes the buffers now, e.g. before the GL context is destroyed
+    void Delete();
+
+private:
+    void growVertices(uint32_t capacity);
+    void growIndices(uint32_t capacity);
+    void growInstances(size_t count);
+    void linkVertices();
+
+    VertexFormat format;
+    Buffers::VAO vao;
+    Buffers::VBO vertexBuffer;
+    Buffers::EBO indexBuffer;
+    Buffers::VBO instanceBuffer;
+    size_t instanceCapacity;
+    // Buffer the instance attributes currently read
+    GLuint instanceSource;
+    Core::OffsetAllocator vertexAllocator;
+    Core::OffsetAllocator indexAllocator;
+};
+}}
+
+#endif
@@ -0,0 +1,188 @@
+#include "glstate.hpp"
+#include "renderstats.hpp"
+
+// Cached value of a binding that may differ from the context's
+static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+static const GLenum TEXTURE_TARGETS[] = {GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BUFFER, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D};
+static const int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+static const GLenum BUFFER_TARGETS[] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_TEXTURE_BUFFER,
+                                        GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_PACK_BUFFER, GL_COPY_READ_BUFFER,
+                                        GL_COPY_WRITE_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_SHADER_STORAGE_BUFFER};
+static const int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+
+static const GLuint TEXTURE_UNITS = Engine::Graphics::GLState::TEXTURE_UNITS;
+static const GLuint BUFFER_BINDINGS = Engine::Graphics::GLState::BUFFER_BINDINGS;
+
+static GLuint currentProgram = UNKNOWN;
+static GLuint currentVertexArray = UNKNOWN;
+// Active unit as an index; UNKNOWN until the first ActiveTexture
+static GLuint activeUnit = UNKNOWN;
+static GLuint textures[TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+static GLuint buffers[BUFFER_TARGET_COUNT];
+static GLuint indexedBuffers[BUFFER_TARGET_COUNT][BUFFER_BINDINGS];
+
+// Position of a target in the tables above, or -1 if it isn't tracked
+static int textureTarget(GLenum target)
+{
+    for (int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+    {
+        if (TEXTURE_TARGETS[i] == target)
+            return i;
+    }
+    return -1;
+}
+
+static int bufferTarget(GLenum target)
+{
+    for (int i = 0; i < BUFFER_TARGET_COUNT; i++)
+    {
+        if (BUFFER_TARGETS[i] == target)
+            return i;
+    }
+    return -1;
+}
+
+// True and counted as skipped if the cached value already matches
+static bool skip(GLuint& cached, GLuint value)
+{
+    if (cached == value)
+    {
+        Engine::Graphics::RenderStats::Current().skippedBinds++;
+        return true;
+    }
+    cached = value;
+    return false;
+}
+
+void Engine::Graphics::GLState::UseProgram(GLuint program)
+{
+    if (skip(currentProgram, program))
+        return;
+    RenderStats::Current().programBinds++;
+    glUseProgram(program);
+}
+
+void Engine::Graphics::GLState::ActiveTexture(GLenum unit)
+{
+    // Switching units changes no binding, so it is neither counted nor reported as skipped
+    GLuint index = unit - GL_TEXTURE0;
+    if (activeUnit == index)
+        return;
+    activeUnit = index;
+    glActiveTexture(unit);
+}
+
+void Engine::Graphics::GLState::BindTexture(GLenum target, GLuint texture)
+{
+    int slot = textureTarget(target);
+    if (slot >= 0 && activeUnit < TEXTURE_UNITS && skip(textures[activeUnit][slot], texture))
+        return;
+    RenderStats::Current().textureBinds++;
+    glBindTexture(target, texture);
+}
+
+void Engine::Graphics::GLState::BindTextureUnit(GLuint unit, GLenum target, GLuint texture)
+{
+    int slot = textureTarget(target);
+    if (slot >= 0 && unit < TEXTURE_UNITS && skip(textures[unit][slot], texture))
+        return;
+    ActiveTexture(GL_TEXTURE0 + unit);
+    RenderStats::Current().textureBinds++;
+    glBindTexture(target, texture);
+}
+
+void Engine::Graphics::GLState::BindVertexArray(GLuint vertexArray)
+{
+    if (skip(currentVertexArray, vertexArray))
+        return;
+    buffers[bufferTarget(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    RenderStats::Current().vertexArrayBinds++;
+    glBindVertexArray(vertexArray);
+}
+
+void Engine::Graphics::GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+    int slot = bufferTarget(target);
+    if (slot >= 0 && skip(buffers[slot], buffer))
+        return;
+    RenderStats::Current().bufferBinds++;
+    glBindBuffer(target, buffer);
+}
+
+void Engine::Graphics::GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    int slot = bufferTarget(target);
+    if (slot >= 0 && index < BUFFER_BINDINGS)
+    {
+        if (skip(indexedBuffers[slot][index], buffer))
+            return;
+    }
+    if (slot >= 0)
+        buffers[slot] = buffer;
+    RenderStats::Current().bufferBinds++;
+    glBindBufferBase(target, index, buffer);
+}
+
+void Engine::Graphics::GLState::ForgetProgram(GLuint program)
+{
+    if (currentProgram == program)
+        currentProgram = UNKNOWN;
+}
+
+void Engine::Graphics::GLState::ForgetTexture(GLuint texture)
+{
+    for (GLuint unit = 0; unit < TEXTURE_UNITS; unit++)
+    {
+        for (int slot = 0; slot < TEXTURE_TARGET_COUNT; slot++)
+        {
+            if (textures[unit][slot] == texture)
+                textures[unit][slot] = UNKNOWN;
+        }
+    }
+}
+
+void Engine::Graphics::GLState::ForgetVertexArray(GLuint vertexArray)
+{
+    if (currentVertexArray == vertexArray)
+    {
+        currentVertexArray = UNKNOWN;
+        buffers[bufferTarget(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void Engine::Graphics::GLState::ForgetBuffer(GLuint buffer)
+{
+    for (int slot = 0; slot < BUFFER_TARGET_COUNT; slot++)
+    {
+        if (buffers[slot] == buffer)
+            buffers[slot] = UNKNOWN;
+        for (GLuint index = 0; index < BUFFER_BINDINGS; index++)
+        {
+            if (indexedBuffers[slot][index] == buffer)
+                indexedBuffers[slot][index] = UNKNOWN;
+        }
+    }
+}
+
+void Engine::Graphics::GLState::Invalidate()
+{
+    currentProgram = UNKNOWN;
+    currentVertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (GLuint unit = 0; unit < TEXTURE_UNITS; unit++)
+    {
+        for (int slot = 0; slot < TEXTURE_TARGET_COUNT; slot++)
+            textures[unit][slot] = UNKNOWN;
+    }
+    for (int slot = 0; slot < BUFFER_TARGET_COUNT; slot++)
+    {
+        buffers[slot] = UNKNOWN;
+        for (GLuint index = 0; index < BUFFER_BINDINGS; index++)
+            indexedBuffers[slot][index] = UNKNOWN;
+    }
+}
+
+// Every binding starts out unknown
+static const bool invalidated = (Engine::Graphics::GLState::Invalidate(), true);
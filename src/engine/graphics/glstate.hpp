@@ -0,0 +1,47 @@
+#ifndef ENGINE_GRAPHICS_GLSTATE_HPP
+#define ENGINE_GRAPHICS_GLSTATE_HPP
+
+#include <GL/glew.h>
+
+namespace Engine{
+namespace Graphics{
+
+// Shadow copy of the GL bindings the engine changes, so binding what is already bound costs nothing.
+// Every program, texture, vertex array and buffer bind of the engine wrappers goes through here; issued
+// binds are counted in RenderStats as before and skipped ones in RenderStats::skippedBinds.
+// Bindings start out unknown, so the first bind of each is always issued. Code that changes bindings
+// behind the engine's back (a UI backend that doesn't restore them, another library) must call
+// Invalidate afterwards. The element array binding belongs to the vertex array, so it becomes unknown
+// whenever the vertex array changes. GL calls are only made from the render thread.
+class GLState
+{
+public:
+    // Texture units tracked; binds on higher units are always issued
+    static const GLuint TEXTURE_UNITS = 16;
+    // Indexed binding points tracked per buffer target (uniform and shader storage blocks)
+    static const GLuint BUFFER_BINDINGS = 16;
+
+    static void UseProgram(GLuint program);
+    // unit is GL_TEXTURE0 + i, as for glActiveTexture
+    static void ActiveTexture(GLenum unit);
+    // Binds a texture on the active unit
+    static void BindTexture(GLenum target, GLuint texture);
+    // Binds a texture on unit GL_TEXTURE0 + unit, making it the active unit only if the bind is issued
+    static void BindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+    static void BindVertexArray(GLuint vertexArray);
+    static void BindBuffer(GLenum target, GLuint buffer);
+    // Also binds the buffer to the target's generic binding point, like glBindBufferBase
+    static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    // Called before deleting an object: GL unbinds deleted names, and a new object may get the name
+    static void ForgetProgram(GLuint program);
+    static void ForgetTexture(GLuint texture);
+    static void ForgetVertexArray(GLuint vertexArray);
+    static void ForgetBuffer(GLuint buffer);
+
+    // Marks every binding unknown
+    static void Invalidate();
+};
+}}
+
+#endif
@@ -0,0 +1,207 @@
+#include "gpuculler.hpp"
+#include "glstate.hpp"
+#include "renderstats.hpp"
+#include <algorithm>
+
+// Storage buffer bindings of cull.comp
+static const GLuint OBJECT_BINDING = 0;
+static const GLuint COMMAND_BINDING = 1;
+static const GLuint INSTANCE_BINDING = 2;
+
+Engine::Graphics::GpuCuller::GpuCuller(const std::string& computePath)
+    : computePath(computePath), dirty(false), objectBuffer(0), commandBuffer(0), instanceBuffer(0), frame(0),
+      visibleCount(0)
+{
+    for (size_t i = 0; i < READBACK_FRAMES; i++)
+    {
+        readbackBuffers[i] = 0;
+        readbackFences[i] = nullptr;
+    }
+}
+
+void Engine::Graphics::GpuCuller::Clear()
+{
+    commands.clear();
+    objects.clear();
+    visibleCount = 0;
+    dirty = true;
+}
+
+uint32_t Engine::Graphics::GpuCuller::AddMesh(const GeometryRange& range)
+{
+    commands.push_back(DrawElementsIndirectCommand{range.indexCount, 0, range.firstIndex, range.baseVertex, 0});
+    dirty = true;
+    return (uint32_t)(commands.size() - 1);
+}
+
+void Engine::Graphics::GpuCuller::AddObject(uint32_t mesh, const glm::mat4& model, const glm::vec3& min,
+                                            const glm::vec3& max)
+{
+    objects.push_back(GpuCullObject{model, (min + max) * 0.5f, mesh, (max - min) * 0.5f, 0.0f});
+    dirty = true;
+}
+
+void Engine::Graphics::GpuCuller::createObjects()
+{
+    program = Shader::Compute(computePath.c_str());
+    for (int i = 0; i < 6; i++)
+        planeUniforms[i] = program.getUniform("planes[" + std::to_string(i) + "]");
+    objectCountUniform = program.getUniform("objectCount");
+
+    glGenBuffers(1, &objectBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &instanceBuffer);
+    glGenBuffers((GLsizei)READBACK_FRAMES, readbackBuffers);
+}
+
+void Engine::Graphics::GpuCuller::upload()
+{
+    // Grouped by mesh, most workgroups of the cull shader reserve their survivors with one atomic
+    std::stable_sort(objects.begin(), objects.end(),
+                     [](const GpuCullObject& a, const GpuCullObject& b) { return a.command < b.command; });
+
+    // Each mesh gets a slice of the instance buffer large enough for all of its objects
+    std::vector<GLuint> counts(commands.size(), 0);
+    for (const GpuCullObject& object : objects)
+        counts[object.command]++;
+    GLuint baseInstance = 0;
+    for (size_t i = 0; i < commands.size(); i++)
+    {
+        commands[i].baseInstance = baseInstance;
+        baseInstance += counts[i];
+    }
+
+    RenderStats::Current().bufferUploads += 2;
+    GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, objects.size() * sizeof(GpuCullObject), objects.data(), GL_STATIC_DRAW);
+    GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, objects.size() * sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+
+    GLsizeiptr commandSize = commands.size() * sizeof(DrawElementsIndirectCommand);
+    GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commandSize, nullptr, GL_DYNAMIC_COPY);
+    for (size_t i = 0; i < READBACK_FRAMES; i++)
+    {
+        if (readbackFences[i])
+            glDeleteSync(readbackFences[i]);
+        readbackFences[i] = nullptr;
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffers[i]);
+        glBufferData(GL_COPY_WRITE_BUFFER, commandSize, nullptr, GL_STREAM_READ);
+    }
+    readbackCommands.resize(commands.size());
+    dirty = false;
+}
+
+void Engine::Graphics::GpuCuller::Cull(const Frustum& frustum)
+{
+    if (objectBuffer == 0)
+        createObjects();
+    if (dirty)
+        upload();
+    if (objects.empty())
+        return;
+
+    // Counts restart from zero; the template already holds everything else
+    RenderStats::Current().bufferUploads++;
+    GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand),
+                    commands.data());
+
+    program.Activate();
+    for (int i = 0; i < 6; i++)
+        program.setVec4(planeUniforms[i], frustum.planes[i]);
+    program.setInt(objectCountUniform, (int)objects.size());
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, objectBuffer);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, commandBuffer);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, instanceBuffer);
+    glDispatchCompute((GLuint)((objects.size() + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE), 1, 1);
+
+    // The draws read the commands and instance matrices, and the readback copies the counts
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    size_t slot = frame % READBACK_FRAMES;
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, commandBuffer);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffers[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        commands.size() * sizeof(DrawElementsIndirectCommand));
+    if (readbackFences[slot])
+        glDeleteSync(readbackFences[slot]);
+    readbackFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame++;
+
+    readVisibleCount();
+}
+
+void Engine::Graphics::GpuCuller::readVisibleCount()
+{
+    // The oldest copy in the ring; it is only read once the GPU is done with it, so this never waits
+    size_t slot = frame % READBACK_FRAMES;
+    GLsync fence = readbackFences[slot];
+    if (!fence || glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        return;
+    glDeleteSync(fence);
+    readbackFences[slot] = nullptr;
+
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, readbackBuffers[slot]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, readbackCommands.size() * sizeof(DrawElementsIndirectCommand),
+                       readbackCommands.data());
+    visibleCount = 0;
+    for (const DrawElementsIndirectCommand& command : readbackCommands)
+        visibleCount += command.instanceCount;
+}
+
+GLuint Engine::Graphics::GpuCuller::GetCommandBuffer() const
+{
+    return commandBuffer;
+}
+
+GLsizei Engine::Graphics::GpuCuller::GetCommandCount() const
+{
+    return objects.empty() ? 0 : (GLsizei)commands.size();
+}
+
+GLuint Engine::Graphics::GpuCuller::GetInstanceBuffer() const
+{
+    return instanceBuffer;
+}
+
+size_t Engine::Graphics::GpuCuller::GetObjectCount() const
+{
+    return objects.size();
+}
+
+size_t Engine::Graphics::GpuCuller::GetVisibleCount() const
+{
+    return visibleCount;
+}
+
+void Engine::Graphics::GpuCuller::Delete()
+{
+    for (size_t i = 0; i < READBACK_FRAMES; i++)
+    {
+        if (readbackFences[i])
+            glDeleteSync(readbackFences[i]);
+        readbackFences[i] = nullptr;
+    }
+    if (objectBuffer != 0)
+    {
+        GLuint buffers[] = {objectBuffer, commandBuffer, instanceBuffer};
+        for (GLuint buffer : buffers)
+            GLState::ForgetBuffer(buffer);
+        for (GLuint buffer : readbackBuffers)
+            GLState::ForgetBuffer(buffer);
+        glDeleteBuffers(3, buffers);
+        glDeleteBuffers((GLsizei)READBACK_FRAMES, readbackBuffers);
+    }
+    objectBuffer = commandBuffer = instanceBuffer = 0;
+    for (size_t i = 0; i < READBACK_FRAMES; i++)
+        readbackBuffers[i] = 0;
+    program.Delete();
+    dirty = true;
+}
+
+bool Engine::Graphics::GpuCuller::IsSupported()
+{
+    // cull.comp is GLSL 4.30
+    return GLEW_VERSION_4_3;
+}
@@ -0,0 +1,97 @@
+#ifndef ENGINE_GRAPHICS_GPUCULLER_HPP
+#define ENGINE_GRAPHICS_GPUCULLER_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "batchrenderer.hpp"
+#include "frustum.hpp"
+#include "geometryarena.hpp"
+#include "shader.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// One object as the cull shader reads it (std430 layout of CullObject in cull.comp)
+struct GpuCullObject
+{
+    glm::mat4 model;
+    glm::vec3 center;
+    uint32_t command;
+    glm::vec3 extent;
+    float padding;
+};
+
+// Frustum culling on the GPU. The objects and their world bounds live in a storage buffer; each Cull
+// dispatches a compute shader that tests every object against the frustum and compacts the survivors'
+// model matrices into an instance buffer, one slice per mesh, counting them in the instanceCount of
+// that mesh's indirect command. The command buffer is then drawn with BatchRenderer::SubmitIndirect
+// and an INSTANCED program, so the visible set never goes back to the CPU.
+// The visible count is read back a few frames late through a ring of buffers, so it never stalls.
+class GpuCuller
+{
+public:
+    static const GLuint WORKGROUP_SIZE = 64;
+    // Frames between a Cull and reading back its visible count
+    static const size_t READBACK_FRAMES = 3;
+
+    explicit GpuCuller(const std::string& computePath);
+
+    GpuCuller(const GpuCuller&) = delete;
+    GpuCuller& operator=(const GpuCuller&) = delete;
+
+    // Removes all meshes and objects
+    void Clear();
+    // Adds a mesh of the arena drawn by the objects; returns the mesh index for AddObject
+    uint32_t AddMesh(const GeometryRange& range);
+    void AddObject(uint32_t mesh, const glm::mat4& model, const glm::vec3& min, const glm::vec3& max);
+
+    // Culls all objects; the buffers are uploaded first if objects changed
+    void Cull(const Frustum& frustum);
+
+    // One DrawElementsIndirectCommand per mesh, with the instance counts of the last Cull
+    GLuint GetCommandBuffer() const;
+    GLsizei GetCommandCount() const;
+    // Model matrices of the visible objects, as INSTANCED programs read them
+    GLuint GetInstanceBuffer() const;
+    size_t GetObjectCount() const;
+    // Visible objects of the Cull READBACK_FRAMES ago
+    size_t GetVisibleCount() const;
+
+    // Deletes the program and buffers now, e.g. before the GL context is destroyed
+    void Delete();
+
+    // True if the driver runs compute shaders, storage buffers and indirect multi-draw (GL 4.3)
+    static bool IsSupported();
+
+private:
+    void createObjects();
+    void upload();
+    void readVisibleCount();
+
+    std::string computePath;
+    Shader program;
+    Uniform planeUniforms[6];
+    Uniform objectCountUniform;
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<GpuCullObject> objects;
+    // Where readVisibleCount reads a copy of the commands back, sized with the buffers
+    std::vector<DrawElementsIndirectCommand> readbackCommands;
+    bool dirty;
+
+    GLuint objectBuffer;
+    GLuint commandBuffer;
+    GLuint instanceBuffer;
+    GLuint readbackBuffers[READBACK_FRAMES];
+    GLsync readbackFences[READBACK_FRAMES];
+    size_t frame;
+    size_t visibleCount;
+};
+}}
+
+#endif
@@ -1,8 +1,10 @@
 #include "light.hpp"
-#include <string>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 /*
- * Abstract Light class implementation
+ * Base Light class implementation
  */
  
 Engine::Graphics::Light::Light(glm::vec3 ambient, 
@@ -51,14 +53,6 @@ glm::vec3 Engine::Graphics::Light::getSpecular() const{
         glm::vec3 specular
 ) : direction(dir), Light(ambient, diffuse, specular){}
  
-void Engine::Graphics::DirectionalLight::Apply(Shader& shader, 
-    const std::string& uniformName) const{
-    shader.setVec3((uniformName + ".direction").c_str(), direction);
-    shader.setVec3((uniformName + ".ambient").c_str(), ambient);
-    shader.setVec3((uniformName + ".diffuse").c_str(), diffuse);
-    shader.setVec3((uniformName + ".specular").c_str(), specular);
-}
-
 void Engine::Graphics::DirectionalLight::setDirection(const glm::vec3& dir){
     direction = dir;
 }
@@ -82,16 +76,6 @@ glm::vec3 Engine::Graphics::DirectionalLight::getDirection() const{
 : position(pos), constant(constant), linear(linear), quadratic(quadratic),
     Light(ambient, diffuse, specular){}
     
-void Engine::Graphics::PointLight::Apply(Shader& shader, const std::string& uniformName) const{
-    shader.setVec3((uniformName + ".position").c_str(), position);
-    shader.setVec3((uniformName + ".ambient").c_str(), ambient);
-    shader.setVec3((uniformName + ".diffuse").c_str(), diffuse);
-    shader.setVec3((uniformName + ".specular").c_str(), specular);
-    shader.setFloat((uniformName + ".constant").c_str(), constant);
-    shader.setFloat((uniformName + ".linear").c_str(), linear);
-    shader.setFloat((uniformName + ".quadratic").c_str(), quadratic);
-}
-
 void Engine::Graphics::PointLight::setPosition(const glm::vec3& pos){
     position = pos;
 }
@@ -106,6 +90,39 @@ glm::vec3 Engine::Graphics::PointLight::GetPosition() const{
     return position;
 }
 
+float Engine::Graphics::PointLight::getConstant() const{
+    return constant;
+}
+
+float Engine::Graphics::PointLight::getLinear() const{
+    return linear;
+}
+
+float Engine::Graphics::PointLight::getQuadratic() const{
+    return quadratic;
+}
+
+float Engine::Graphics::PointLight::getRadius(float threshold) const{
+    glm::vec3 color = glm::max(ambient, glm::max(diffuse, specular));
+    float intensity = std::max(color.r, std::max(color.g, color.b));
+
+    // Lights already below the threshold at their center reach nowhere (and would give no real root)
+    if(intensity <= threshold * constant){
+        return 0.f;
+    }
+
+    // Solve intensity / (constant + linear * d + quadratic * d^2) = threshold for d
+    float c = constant - intensity / threshold;
+    if(quadratic > 0.f){
+        float root = (-linear + std::sqrt(std::max(0.f, linear * linear - 4.f * quadratic * c))) / (2.f * quadratic);
+        return std::max(0.f, root);
+    }
+    if(linear > 0.f){
+        return std::max(0.f, -c / linear);
+    }
+    return std::numeric_limits<float>::infinity();
+}
+
 /*
  * FlashLight class implementation
  */
@@ -137,14 +154,6 @@ Engine::Graphics::FlashLight::FlashLight(glm::vec3 pos, glm::vec3 dir){
     specular = glm::vec3(1.0f, 1.0f, 1.0f);
 }
 
-void Engine::Graphics::FlashLight::Apply(Shader& shader, const std::string& uniformName) const{
-    PointLight::Apply(shader, uniformName);
-    
-    shader.setVec3((uniformName + ".direction").c_str(), direction);
-    shader.setFloat((uniformName + ".cutOff").c_str(), cutOff);
-    shader.setFloat((uniformName + ".outerCutOff").c_str(), outerCutOff);
-}
-
 void Engine::Graphics::FlashLight::setDirection(const glm::vec3& dir){
     direction = dir;
 }
@@ -158,4 +167,42 @@ glm::vec3 Engine::Graphics::FlashLight::getDirection() const{
     return direction;
 }
 
+float Engine::Graphics::FlashLight::getCutOff() const{
+    return cutOff;
+}
+
+float Engine::Graphics::FlashLight::getOuterCutOff() const{
+    return outerCutOff;
+}
+
+glm::vec4 Engine::Graphics::FlashLight::getBoundingSphere() const{
+    float range = getRadius();
+    float cosAngle = glm::clamp(outerCutOff, -1.f, 1.f);
+    glm::vec3 dir = glm::normalize(direction);
+
+    // Wide cones are bounded by their base disc, narrow ones by the sphere through apex and base rim
+    if(cosAngle < glm::cos(glm::radians(45.f))){
+        float sinAngle = std::sqrt(1.f - cosAngle * cosAngle);
+        return glm::vec4(position + dir * (range * cosAngle), range * sinAngle);
+    }
+    float radius = range / (2.f * cosAngle);
+    return glm::vec4(position + dir * radius, radius);
+}
+
+bool Engine::Graphics::FlashLight::intersectsSphere(const glm::vec3& center, float radius) const{
+    float range = getRadius();
+    float cosAngle = glm::clamp(outerCutOff, -1.f, 1.f);
+    float sinAngle = std::sqrt(1.f - cosAngle * cosAngle);
+
+    glm::vec3 offset = center - position;
+    float alongAxis = glm::dot(offset, glm::normalize(direction));
+    float fromAxis = std::sqrt(std::max(0.f, glm::dot(offset, offset) - alongAxis * alongAxis));
+
+    // Distance from the sphere center to the cone's side, then caps in front and behind the apex
+    bool outsideAngle = cosAngle * fromAxis - sinAngle * alongAxis > radius;
+    bool beyondRange = alongAxis > radius + range;
+    bool behindApex = alongAxis < -radius;
+    return !(outsideAngle || beyondRange || behindApex);
+}
+
 
@@ -2,14 +2,15 @@
 #define ENGINE_GRAPHICS_LIGHT_HPP
 
 #include <glm/glm.hpp>
-#include <string>
 #include "glm/fwd.hpp"
 #include "glm/trigonometric.hpp"
-#include "shader.hpp"
 
 namespace Engine{
 namespace Graphics{
 
+// Fraction of a light's intensity below which its contribution is considered invisible
+const float LIGHT_THRESHOLD = 5.0f / 256.0f;
+
 class Light{
     // Every light has an ambient, diffuse, specular component
     protected:
@@ -24,9 +25,6 @@ class Light{
         
         virtual ~Light() = default;
         
-        // Abstract method to apply light to shader for each lighting method
-        virtual void Apply(Shader& shader, const std::string& uniformName) const = 0;
-        
         // Setters
         void setAmbient(const glm::vec3& amb);
         void setDiffuse(const glm::vec3& diff);
@@ -49,8 +47,6 @@ class DirectionalLight : public Light{
                 glm::vec3 diffuse = glm::vec3(1.f, 1.f, 1.f),
                 glm::vec3 specular = glm::vec3(1.f, 1.f, 1.f));
         
-        void Apply(Shader& shader, const std::string& uniformName) const override;
-        
         void setDirection(const glm::vec3& dir);
         glm::vec3 getDirection() const;
 };
@@ -71,13 +67,18 @@ class PointLight : public Light{
                 glm::vec3 diffuse = glm::vec3(1.f, 1.f, 1.f),
                 glm::vec3 specular = glm::vec3(1.f, 1.f, 1.f));
         
-        void Apply(Shader& shader, const std::string& uniformName) const override;
-        
         // Setters
         void setPosition(const glm::vec3& pos);
         void setAttenuation(float c, float l, float q);
         
         glm::vec3 GetPosition() const;
+        float getConstant() const;
+        float getLinear() const;
+        float getQuadratic() const;
+
+        // Distance at which the attenuated intensity drops below the threshold (infinite without attenuation,
+        // 0 for lights that are below it at their center)
+        float getRadius(float threshold = LIGHT_THRESHOLD) const;
 };
 
 class FlashLight : public PointLight{
@@ -100,12 +101,17 @@ class FlashLight : public PointLight{
         
         FlashLight(glm::vec3 pos, glm::vec3 dir);
         
-        void Apply(Shader& shader, const std::string& uniformName) const override;
-        
         void setDirection(const glm::vec3& dir);
         void setCutOff(float cutO, float outerCutO);
         
         glm::vec3 getDirection() const;
+        float getCutOff() const;
+        float getOuterCutOff() const;
+
+        // Smallest sphere around the lit cone (xyz: center, w: radius)
+        glm::vec4 getBoundingSphere() const;
+        // Returns true if a sphere overlaps the lit cone
+        bool intersectsSphere(const glm::vec3& center, float radius) const;
 }; 
 
 }}
@@ -0,0 +1,116 @@
+#include "lightbuffer.hpp"
+#include "glstate.hpp"
+#include "renderstats.hpp"
+#include <algorithm>
+#include <cstring>
+
+Engine::Graphics::LightBuffer::LightBuffer() : ID(0), dirtyBegin(0), dirtyEnd(sizeof(GpuLightBlock))
+{
+    std::memset(&block, 0, sizeof(block));
+}
+
+void Engine::Graphics::LightBuffer::setDirectionalLight(const DirectionalLight& light, bool enabled)
+{
+    GpuDirLight packed = {};
+    packed.direction = light.getDirection();
+    packed.enabled = enabled;
+    packed.ambient = light.getAmbient();
+    packed.diffuse = light.getDiffuse();
+    packed.specular = light.getSpecular();
+    write(offsetof(GpuLightBlock, dirLight), &packed, sizeof(packed));
+}
+
+void Engine::Graphics::LightBuffer::setPointLight(int index, const PointLight& light, bool enabled)
+{
+    if (index < 0 || index >= MAX_POINT_LIGHTS)
+        return;
+
+    GpuPointLight packed = {};
+    packed.position = light.GetPosition();
+    packed.constant = light.getConstant();
+    packed.ambient = light.getAmbient();
+    packed.linear = light.getLinear();
+    packed.diffuse = light.getDiffuse();
+    packed.quadratic = light.getQuadratic();
+    packed.specular = light.getSpecular();
+    packed.enabled = enabled;
+    write(offsetof(GpuLightBlock, pointLights) + index * sizeof(GpuPointLight), &packed, sizeof(packed));
+}
+
+void Engine::Graphics::LightBuffer::disablePointLight(int index)
+{
+    if (index < 0 || index >= MAX_POINT_LIGHTS)
+        return;
+
+    GLint enabled = 0;
+    write(offsetof(GpuLightBlock, pointLights) + index * sizeof(GpuPointLight) + offsetof(GpuPointLight, enabled),
+          &enabled, sizeof(enabled));
+}
+
+void Engine::Graphics::LightBuffer::setFlashLight(const FlashLight& light, bool enabled)
+{
+    GpuFlashLight packed = {};
+    packed.position = light.GetPosition();
+    packed.constant = light.getConstant();
+    packed.direction = light.getDirection();
+    packed.linear = light.getLinear();
+    packed.ambient = light.getAmbient();
+    packed.quadratic = light.getQuadratic();
+    packed.diffuse = light.getDiffuse();
+    packed.cutOff = light.getCutOff();
+    packed.specular = light.getSpecular();
+    packed.outerCutOff = light.getOuterCutOff();
+    packed.enabled = enabled;
+    write(offsetof(GpuLightBlock, flashLight), &packed, sizeof(packed));
+}
+
+void Engine::Graphics::LightBuffer::write(size_t offset, const void* data, size_t size)
+{
+    unsigned char* destination = reinterpret_cast<unsigned char*>(&block) + offset;
+    if (std::memcmp(destination, data, size) == 0)
+        return;
+
+    std::memcpy(destination, data, size);
+    if (dirtyBegin >= dirtyEnd)
+    {
+        dirtyBegin = offset;
+        dirtyEnd = offset + size;
+    }
+    else
+    {
+        dirtyBegin = std::min(dirtyBegin, offset);
+        dirtyEnd = std::max(dirtyEnd, offset + size);
+    }
+}
+
+void Engine::Graphics::LightBuffer::Upload()
+{
+    if (ID == 0)
+    {
+        glGenBuffers(1, &ID);
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(GpuLightBlock), &block, GL_DYNAMIC_DRAW);
+    }
+    else if (dirtyBegin < dirtyEnd)
+    {
+        RenderStats::Current().bufferUploads++;
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, dirtyBegin, dirtyEnd - dirtyBegin,
+                        reinterpret_cast<unsigned char*>(&block) + dirtyBegin);
+    }
+    dirtyBegin = dirtyEnd = 0;
+}
+
+void Engine::Graphics::LightBuffer::Bind()
+{
+    GLState::BindBufferBase(GL_UNIFORM_BUFFER, BINDING, ID);
+}
+
+void Engine::Graphics::LightBuffer::Delete()
+{
+    GLState::ForgetBuffer(ID);
+    glDeleteBuffers(1, &ID);
+    ID = 0;
+    dirtyBegin = 0;
+    dirtyEnd = sizeof(GpuLightBlock);
+}
@@ -0,0 +1,104 @@
+#ifndef ENGINE_GRAPHICS_LIGHTBUFFER_HPP
+#define ENGINE_GRAPHICS_LIGHTBUFFER_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+
+#include "light.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// std140 mirrors of the structs in the "Lights" block of default.frag.
+// Every vec3 is followed by a scalar so that each row fills exactly 16 bytes.
+struct GpuDirLight
+{
+    glm::vec3 direction;
+    GLint enabled;
+    glm::vec3 ambient;
+    float pad0;
+    glm::vec3 diffuse;
+    float pad1;
+    glm::vec3 specular;
+    float pad2;
+};
+
+struct GpuPointLight
+{
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    GLint enabled;
+};
+
+struct GpuFlashLight
+{
+    glm::vec3 position;
+    float constant;
+    glm::vec3 direction;
+    float linear;
+    glm::vec3 ambient;
+    float quadratic;
+    glm::vec3 diffuse;
+    float cutOff;
+    glm::vec3 specular;
+    float outerCutOff;
+    GLint enabled;
+    float pad[3];
+};
+
+// Must match NR_POINT_LIGHTS in default.frag
+const int MAX_POINT_LIGHTS = 4;
+
+struct GpuLightBlock
+{
+    GpuDirLight dirLight;
+    GpuPointLight pointLights[MAX_POINT_LIGHTS];
+    GpuFlashLight flashLight;
+};
+
+static_assert(sizeof(GpuDirLight) == 64, "GpuDirLight does not match the std140 layout");
+static_assert(sizeof(GpuPointLight) == 64, "GpuPointLight does not match the std140 layout");
+static_assert(sizeof(GpuFlashLight) == 96, "GpuFlashLight does not match the std140 layout");
+
+// Uniform buffer holding every light of the scene in a single std140 block.
+// Lights are packed into a CPU copy, and only the byte range that changed since the last upload is sent to the GPU.
+class LightBuffer
+{
+public:
+    // Uniform buffer binding point the "Lights" block is attached to
+    static const GLuint BINDING = 0;
+
+    GLuint ID;
+
+    LightBuffer();
+
+    // Packs lights into the CPU copy of the block
+    void setDirectionalLight(const DirectionalLight& light, bool enabled);
+    void setPointLight(int index, const PointLight& light, bool enabled);
+    void disablePointLight(int index);
+    void setFlashLight(const FlashLight& light, bool enabled);
+
+    // Creates the buffer on first use, then uploads the dirty range with a single glBufferSubData
+    void Upload();
+    // Binds the buffer to its binding point
+    void Bind();
+    // Deletes the buffer
+    void Delete();
+
+private:
+    // Copies a packed struct into the block, extending the dirty range if its bytes changed
+    void write(size_t offset, const void* data, size_t size);
+
+    GpuLightBlock block;
+    size_t dirtyBegin;
+    size_t dirtyEnd;
+};
+}}
+
+#endif
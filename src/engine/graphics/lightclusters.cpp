@@ -0,0 +1,231 @@
+#include "lightclusters.hpp"
+#include "glstate.hpp"
+#include "renderstats.hpp"
+#include "../core/trace.hpp"
+#include <algorithm>
+#include <cmath>
+
+Engine::Graphics::LightClusters::LightClusters()
+    : lightBuffer(0), lightTexture(0), gridBuffer(0), gridTexture(0), indexBuffer(0), indexTexture(0),
+      maxTexels(0), nearPlane(0.0f), farPlane(0.0f), boundsProj(0.0f),
+      grid(CLUSTER_COUNT * 2, 0), sliceIndices(GRID_Z), sliceCandidates(GRID_Z)
+{
+}
+
+void Engine::Graphics::LightClusters::buildClusterBounds(const glm::mat4& proj, float nearP, float farP)
+{
+    if (proj == boundsProj && nearP == nearPlane && farP == farPlane && !clusterBounds.empty())
+        return;
+
+    boundsProj = proj;
+    nearPlane = nearP;
+    farPlane = farP;
+    clusterBounds.resize(CLUSTER_COUNT);
+
+    // Exponential slicing keeps clusters roughly cubic along the view direction
+    sliceNear.resize(GRID_Z + 1);
+    for (int z = 0; z <= GRID_Z; z++)
+        sliceNear[z] = nearPlane * std::pow(farPlane / nearPlane, (float)z / GRID_Z);
+
+    glm::mat4 invProj = glm::inverse(proj);
+    for (int y = 0; y < GRID_Y; y++)
+    {
+        for (int x = 0; x < GRID_X; x++)
+        {
+            // Corners of the tile on the near plane, in view space
+            glm::vec3 corners[4];
+            for (int i = 0; i < 4; i++)
+            {
+                float ndcX = -1.0f + 2.0f * (x + (i & 1)) / GRID_X;
+                float ndcY = -1.0f + 2.0f * (y + (i >> 1)) / GRID_Y;
+                glm::vec4 corner = invProj * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                corners[i] = glm::vec3(corner) / corner.w;
+            }
+
+            for (int z = 0; z < GRID_Z; z++)
+            {
+                Bounds bounds = {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+                for (float depth : {sliceNear[z], sliceNear[z + 1]})
+                {
+                    for (const glm::vec3& corner : corners)
+                    {
+                        // Slide the corner along its view ray to the slice depth
+                        glm::vec3 point = corner * (depth / -corner.z);
+                        bounds.min = glm::min(bounds.min, point);
+                        bounds.max = glm::max(bounds.max, point);
+                    }
+                }
+                clusterBounds[x + GRID_X * (y + GRID_Y * z)] = bounds;
+            }
+        }
+    }
+}
+
+void Engine::Graphics::LightClusters::Build(const LightManager& lightManager, const glm::mat4& view,
+                                            const glm::mat4& proj, float nearP, float farP,
+                                            Core::ThreadPool& pool)
+{
+    buildClusterBounds(proj, nearP, farP);
+
+    // Gather the enabled lights, their shading data and their view space bounding spheres
+    const std::vector<PointLight>& lights = lightManager.getPointLights();
+    lightData.clear();
+    viewLights.clear();
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        if (!lightManager.getUsePointLight((int)i) || !lightManager.isPointLightVisible((int)i))
+            continue;
+
+        const PointLight& light = lights[i];
+        float range = std::min(light.getRadius(), farPlane);
+        lightData.push_back(glm::vec4(light.GetPosition(), range));
+        lightData.push_back(glm::vec4(light.getAmbient(), light.getConstant()));
+        lightData.push_back(glm::vec4(light.getDiffuse(), light.getLinear()));
+        lightData.push_back(glm::vec4(light.getSpecular(), light.getQuadratic()));
+        viewLights.push_back(glm::vec4(glm::vec3(view * glm::vec4(light.GetPosition(), 1.0f)), range));
+    }
+
+    // Bin lights slice by slice; each slice writes only its own clusters and index list
+    pool.ParallelFor(GRID_Z, [this](size_t begin, size_t end) {
+        ENGINE_TRACE_SCOPE("Bin lights");
+        for (size_t z = begin; z < end; z++)
+        {
+            std::vector<GLuint>& sliceList = sliceIndices[z];
+            sliceList.clear();
+
+            // Keep only the lights overlapping the slice's depth range
+            std::vector<GLuint>& candidates = sliceCandidates[z];
+            candidates.clear();
+            for (size_t i = 0; i < viewLights.size(); i++)
+            {
+                float depth = -viewLights[i].z;
+                float range = viewLights[i].w;
+                if (depth + range >= sliceNear[z] && depth - range <= sliceNear[z + 1])
+                    candidates.push_back((GLuint)i);
+            }
+
+            for (int tile = 0; tile < GRID_X * GRID_Y; tile++)
+            {
+                int cluster = tile + GRID_X * GRID_Y * (int)z;
+                const Bounds& bounds = clusterBounds[cluster];
+                GLuint first = (GLuint)sliceList.size();
+
+                for (GLuint light : candidates)
+                {
+                    glm::vec3 center = glm::vec3(viewLights[light]);
+                    glm::vec3 closest = glm::clamp(center, bounds.min, bounds.max);
+                    glm::vec3 offset = center - closest;
+                    if (glm::dot(offset, offset) <= viewLights[light].w * viewLights[light].w)
+                        sliceList.push_back(light);
+                }
+
+                grid[cluster * 2] = first;
+                grid[cluster * 2 + 1] = (GLuint)sliceList.size() - first;
+            }
+        }
+    });
+
+    // Concatenate the slices and turn slice-local offsets into global ones
+    if (maxTexels == 0)
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+
+    indices.clear();
+    for (int z = 0; z < GRID_Z; z++)
+    {
+        GLuint base = (GLuint)indices.size();
+        size_t room = (size_t)maxTexels - std::min((size_t)maxTexels, indices.size());
+        size_t taken = std::min(room, sliceIndices[z].size());
+        indices.insert(indices.end(), sliceIndices[z].begin(), sliceIndices[z].begin() + taken);
+
+        for (int tile = 0; tile < GRID_X * GRID_Y; tile++)
+        {
+            int cluster = tile + GRID_X * GRID_Y * z;
+            GLuint first = grid[cluster * 2];
+            GLuint count = grid[cluster * 2 + 1];
+            // Clusters past the texture buffer limit lose their lights rather than reading out of range
+            count = first >= taken ? 0 : std::min<GLuint>(count, (GLuint)taken - first);
+            grid[cluster * 2] = base + first;
+            grid[cluster * 2 + 1] = count;
+        }
+    }
+}
+
+void Engine::Graphics::LightClusters::Upload()
+{
+    bool created = lightBuffer == 0;
+    if (created)
+    {
+        glGenBuffers(1, &lightBuffer);
+        glGenBuffers(1, &gridBuffer);
+        glGenBuffers(1, &indexBuffer);
+        glGenTextures(1, &lightTexture);
+        glGenTextures(1, &gridTexture);
+        glGenTextures(1, &indexTexture);
+    }
+
+    RenderStats::Current().bufferUploads += 3;
+
+    // Buffers are respecified every frame since their sizes change; empty lists still get one element
+    GLState::BindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(1, lightData.size()) * sizeof(glm::vec4),
+                 lightData.empty() ? nullptr : lightData.data(), GL_STREAM_DRAW);
+    GLState::BindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, grid.size() * sizeof(GLuint), grid.data(), GL_STREAM_DRAW);
+    GLState::BindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(1, indices.size()) * sizeof(GLuint),
+                 indices.empty() ? nullptr : indices.data(), GL_STREAM_DRAW);
+
+    // Textures keep pointing at their buffer when its data store is respecified
+    if (created)
+    {
+        GLState::BindTextureUnit(LIGHT_UNIT, GL_TEXTURE_BUFFER, lightTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightBuffer);
+        GLState::BindTextureUnit(GRID_UNIT, GL_TEXTURE_BUFFER, gridTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, gridBuffer);
+        GLState::BindTextureUnit(INDEX_UNIT, GL_TEXTURE_BUFFER, indexTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indexBuffer);
+    }
+}
+
+void Engine::Graphics::LightClusters::Bind(Shader& shader, const glm::vec2& viewportSize)
+{
+    GLState::BindTextureUnit(LIGHT_UNIT, GL_TEXTURE_BUFFER, lightTexture);
+    GLState::BindTextureUnit(GRID_UNIT, GL_TEXTURE_BUFFER, gridTexture);
+    GLState::BindTextureUnit(INDEX_UNIT, GL_TEXTURE_BUFFER, indexTexture);
+
+    shader.setInt("clusterLights", LIGHT_UNIT);
+    shader.setInt("clusterGrid", GRID_UNIT);
+    shader.setInt("clusterIndices", INDEX_UNIT);
+    shader.setVec3("clusterDims", glm::vec3(GRID_X, GRID_Y, GRID_Z));
+    shader.setVec2("clusterTileSize", viewportSize / glm::vec2(GRID_X, GRID_Y));
+    shader.setFloat("clusterNear", nearPlane);
+    shader.setFloat("clusterDepthScale", GRID_Z / std::log(farPlane / nearPlane));
+}
+
+void Engine::Graphics::LightClusters::Delete()
+{
+    GLState::ForgetBuffer(lightBuffer);
+    GLState::ForgetBuffer(gridBuffer);
+    GLState::ForgetBuffer(indexBuffer);
+    GLState::ForgetTexture(lightTexture);
+    GLState::ForgetTexture(gridTexture);
+    GLState::ForgetTexture(indexTexture);
+    glDeleteBuffers(1, &lightBuffer);
+    glDeleteBuffers(1, &gridBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteTextures(1, &lightTexture);
+    glDeleteTextures(1, &gridTexture);
+    glDeleteTextures(1, &indexTexture);
+    lightBuffer = gridBuffer = indexBuffer = 0;
+    lightTexture = gridTexture = indexTexture = 0;
+}
+
+size_t Engine::Graphics::LightClusters::GetLightCount() const
+{
+    return viewLights.size();
+}
+
+size_t Engine::Graphics::LightClusters::GetIndexCount() const
+{
+    return indices.size();
+}
@@ -0,0 +1,81 @@
+#ifndef ENGINE_GRAPHICS_LIGHTCLUSTERS_HPP
+#define ENGINE_GRAPHICS_LIGHTCLUSTERS_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "../core/threadpool.hpp"
+#include "lightmanager.hpp"
+#include "shader.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Clustered forward lighting: point lights are binned into a 3D grid of view frustum cells (froxels),
+// and a shader compiled with CLUSTERED_LIGHTING only shades the lights listed for the fragment's cell.
+class LightClusters
+{
+public:
+    // Froxel grid resolution (screen tiles in x/y, exponential depth slices in z)
+    static const int GRID_X = 16;
+    static const int GRID_Y = 9;
+    static const int GRID_Z = 24;
+    static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    // Texture units the cluster texture buffers are bound to
+    static const GLuint LIGHT_UNIT = 2;
+    static const GLuint GRID_UNIT = 3;
+    static const GLuint INDEX_UNIT = 4;
+
+    LightClusters();
+
+    // Bins the enabled point lights of a light manager into the grid of the given view and projection
+    void Build(const LightManager& lightManager, const glm::mat4& view, const glm::mat4& proj,
+               float nearPlane, float farPlane, Core::ThreadPool& pool);
+    // Uploads light data, per-cluster ranges and the light index list to their texture buffers
+    void Upload();
+    // Binds the texture buffers and sets the cluster uniforms of a CLUSTERED_LIGHTING shader
+    void Bind(Shader& shader, const glm::vec2& viewportSize);
+    // Deletes the buffers and textures
+    void Delete();
+
+    // Number of lights binned by the last Build, and light references over all clusters
+    size_t GetLightCount() const;
+    size_t GetIndexCount() const;
+
+private:
+    struct Bounds
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // Recomputes the view space bounds of every cluster when the projection changes
+    void buildClusterBounds(const glm::mat4& proj, float nearPlane, float farPlane);
+
+    GLuint lightBuffer, lightTexture;
+    GLuint gridBuffer, gridTexture;
+    GLuint indexBuffer, indexTexture;
+    GLint maxTexels;
+
+    float nearPlane, farPlane;
+    glm::mat4 boundsProj;
+    std::vector<Bounds> clusterBounds;
+    std::vector<float> sliceNear;
+
+    // Four RGBA texels per light: position/range, ambient/constant, diffuse/linear, specular/quadratic
+    std::vector<glm::vec4> lightData;
+    // View space position and range of each binned light
+    std::vector<glm::vec4> viewLights;
+    // (first index, light count) for every cluster
+    std::vector<GLuint> grid;
+    std::vector<GLuint> indices;
+    // Light indices produced by each depth slice, merged into indices after the parallel pass
+    std::vector<std::vector<GLuint>> sliceIndices;
+    // Lights overlapping each depth slice, kept between frames so binning doesn't allocate
+    std::vector<std::vector<GLuint>> sliceCandidates;
+};
+}}
+
+#endif
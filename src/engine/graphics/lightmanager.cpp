@@ -1,10 +1,11 @@
 #include "lightmanager.hpp"
 #include "light.hpp"
-#include <MacTypes.h>
+#include "profiler.hpp"
 #include <cstddef>
 #include <string>
 
-Engine::Graphics::LightManager::LightManager()  : hasDirectionalLight(false), useDirLight(false), useFlashLight(false){}
+Engine::Graphics::LightManager::LightManager()  : hasDirectionalLight(false), useDirLight(false), useFlashLight(false),
+    flashLightVisible(true), culledPointLights(0){}
 
 void Engine::Graphics::LightManager::setDirectionalLight(
     const DirectionalLight& light){
@@ -16,10 +17,14 @@ void Engine::Graphics::LightManager::setDirectionalLight(
 void Engine::Graphics::LightManager::addPointLight(const PointLight& light){
     pointLights.push_back(light);
     usePointLight.push_back(true);
+    pointLightVisible.push_back(true);
 }
 
 void Engine::Graphics::LightManager::clearPointLights(){
     pointLights.clear();
+    usePointLight.clear();
+    pointLightVisible.clear();
+    culledPointLights = 0;
 }
 
 void Engine::Graphics::LightManager::updatePointLight(int index,
@@ -32,19 +37,45 @@ void Engine::Graphics::LightManager::setFlashLight(const FlashLight& light){
     useFlashLight = true;
 }
 
-void Engine::Graphics::LightManager::applyAll(Shader& shader) const{
-    if(hasDirectionalLight){
-        dirLight.Apply(shader, "dirlight");
-        shader.setBool("useDirLight", useDirLight);
-    }
+void Engine::Graphics::LightManager::cullLights(const Frustum& frustum, const BVH& objects){
+    culledPointLights = 0;
     for(size_t i = 0; i < pointLights.size(); i++){
-        std::string uniformName = "pointLights[" + std::to_string(i) + "]";
-        std::string boolName = "usePointLight[" + std::to_string(i) + "]";
-        pointLights[i].Apply(shader, uniformName);
-        shader.setBool(boolName, usePointLight[i]);
+        glm::vec3 center = pointLights[i].GetPosition();
+        float radius = pointLights[i].getRadius();
+        bool visible = frustum.IntersectsSphere(center, radius) && objects.OverlapsSphere(center, radius);
+        pointLightVisible[i] = visible;
+        if(!visible && usePointLight[i]){
+            culledPointLights++;
+        }
+    }
+
+    // The cone's bounding sphere against the frustum, the exact cone against a sphere around the objects
+    glm::vec4 sphere = flashLight.getBoundingSphere();
+    AABB bounds = objects.GetBounds();
+    glm::vec3 boundsCenter = (bounds.min + bounds.max) * 0.5f;
+    float boundsRadius = glm::length(bounds.max - boundsCenter);
+    flashLightVisible = frustum.IntersectsSphere(glm::vec3(sphere), sphere.w) &&
+        flashLight.intersectsSphere(boundsCenter, boundsRadius);
+}
+
+void Engine::Graphics::LightManager::applyAll(){
+    ENGINE_PROFILE_SCOPE("LightManager::applyAll");
+    lightBuffer.setDirectionalLight(dirLight, hasDirectionalLight && useDirLight);
+    for(int i = 0; i < MAX_POINT_LIGHTS; i++){
+        if(i < (int)pointLights.size()){
+            lightBuffer.setPointLight(i, pointLights[i], usePointLight[i] && pointLightVisible[i]);
+        } else {
+            lightBuffer.disablePointLight(i);
+        }
     }
-    flashLight.Apply(shader, "flashLight");
-    shader.setBool("useFlashLight", useFlashLight);
+    lightBuffer.setFlashLight(flashLight, useFlashLight && flashLightVisible);
+
+    lightBuffer.Upload();
+    lightBuffer.Bind();
+}
+
+void Engine::Graphics::LightManager::deleteBuffer(){
+    lightBuffer.Delete();
 }
 
 Engine::Graphics::DirectionalLight Engine::Graphics::LightManager::getDirectionalLight() const{
@@ -59,6 +90,10 @@ Engine::Graphics::PointLight Engine::Graphics::LightManager::getPointLight(int i
     return pointLights[index];
 }
 
+const std::vector<Engine::Graphics::PointLight>& Engine::Graphics::LightManager::getPointLights() const{
+    return pointLights;
+}
+
 void Engine::Graphics::LightManager::setUseDirLight(bool value){
     useDirLight = value;
 }
@@ -81,4 +116,26 @@ bool Engine::Graphics::LightManager::getUsePointLight(int index) const{
 
 bool Engine::Graphics::LightManager::getUseFlashLight() const{
     return useFlashLight;
-}
\ No newline at end of file
+}
+
+bool Engine::Graphics::LightManager::isPointLightVisible(int index) const{
+    return pointLightVisible[index];
+}
+
+bool Engine::Graphics::LightManager::isFlashLightVisible() const{
+    return flashLightVisible;
+}
+
+int Engine::Graphics::LightManager::getVisiblePointLightCount() const{
+    int visible = 0;
+    for(size_t i = 0; i < pointLights.size(); i++){
+        if(usePointLight[i] && pointLightVisible[i]){
+            visible++;
+        }
+    }
+    return visible;
+}
+
+int Engine::Graphics::LightManager::getCulledPointLightCount() const{
+    return culledPointLights;
+}
@@ -1,7 +1,11 @@
 #ifndef ENGINE_GRAPHICS_LIGHTMANAGER_HPP
 #define ENGINE_GRAPHICS_LIGHTMANAGER_HPP
 
+#include "bvh.hpp"
+#include "frustum.hpp"
 #include "light.hpp"
+#include "lightbuffer.hpp"
+#include <vector>
 
 namespace Engine{
 namespace Graphics{
@@ -17,6 +21,13 @@ class LightManager{
         bool useDirLight;
         std::vector<unsigned char> usePointLight;
         bool useFlashLight;
+
+        // Results of the last culling pass
+        std::vector<unsigned char> pointLightVisible;
+        bool flashLightVisible;
+        int culledPointLights;
+
+        LightBuffer lightBuffer;
     public:
         LightManager();
 
@@ -33,8 +44,14 @@ class LightManager{
         void setFlashLight(const FlashLight& light);
         FlashLight& setFlashLight(){ return flashLight;}
         
-        // Apply all lights
-        void applyAll(Shader& shader) const;
+        // Culls lights whose influence volume misses the view frustum or every lit object in the hierarchy.
+        // Culled lights stay disabled in applyAll until the next pass.
+        void cullLights(const Frustum& frustum, const BVH& objects);
+
+        // Packs all lights into the light uniform buffer, uploads what changed and binds it
+        void applyAll();
+        // Deletes the light uniform buffer
+        void deleteBuffer();
 
         // Setters
         void setUsePointLight(int index, bool value);
@@ -50,11 +67,18 @@ class LightManager{
         DirectionalLight getDirectionalLight() const;
         int getPointLightCount() const;
         PointLight getPointLight(int index) const;
+        const std::vector<PointLight>& getPointLights() const;
         FlashLight getFlashLight() const;
         
         bool getUsePointLight(int index) const;
         bool getUseDirLight() const;
         bool getUseFlashLight() const;
+
+        // Culling results, for profiling
+        bool isPointLightVisible(int index) const;
+        bool isFlashLightVisible() const;
+        int getVisiblePointLightCount() const;
+        int getCulledPointLightCount() const;
 };
 
 }}
@@ -1,113 +1,417 @@
 #include "mesh.hpp"
 #include "buffers/ebo.hpp"
+#include "meshprocessing.hpp"
+#include "renderstats.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <utility>
 #include <vector>
 
 Engine::Graphics::Mesh::Mesh(const std::vector<Vertex>& vertices,
-    const std::vector<GLuint> indices, Texture* tex)
-    : vertices(vertices), indices(indices), texture(tex){
-        hasIndices = !indices.empty();
+    const std::vector<GLuint> indices, TexturePool* textures, TextureHandle tex, GeometryArena* geometry,
+    VertexFormat format)
+    : instanceCapacity(0), format(geometry != nullptr ? geometry->GetFormat() : format), textures(textures), texture(tex),
+      geometry(geometry){
+        IndexedGeometry welded = WeldVertices(vertices, indices);
+        OptimizeMesh(welded);
+        this->vertices = std::move(welded.vertices);
+        this->indices = std::move(welded.indices);
+        lods.resize(1);
+        lods[0].indexCount = (GLuint)this->indices.size();
+        indexType = GetIndexType(this->vertices.size());
         setupMesh();
 }
 
-Engine::Graphics::Mesh::~Mesh(){
+Engine::Graphics::Mesh::Mesh(Mesh&& other) noexcept
+    : vao(std::move(other.vao)), vbo(std::move(other.vbo)), ebo(std::move(other.ebo)),
+      instanceVbo(std::move(other.instanceVbo)), instanceCapacity(other.instanceCapacity),
+      vertices(std::move(other.vertices)), indices(std::move(other.indices)), lods(std::move(other.lods)),
+      meshlets(std::move(other.meshlets)), meshletCounts(std::move(other.meshletCounts)),
+      meshletOffsets(std::move(other.meshletOffsets)), meshletBaseVertices(std::move(other.meshletBaseVertices)),
+      indexType(other.indexType), format(other.format), bounds(other.bounds), textures(other.textures),
+      texture(other.texture), geometry(other.geometry), range(other.range){
+    // The arena range now belongs to this mesh alone
+    other.instanceCapacity = 0;
+    other.geometry = nullptr;
+    other.range = GeometryRange();
+}
+
+Engine::Graphics::Mesh& Engine::Graphics::Mesh::operator=(Mesh&& other) noexcept{
+    if(this != &other){
+        Delete();
+        vao = std::move(other.vao);
+        vbo = std::move(other.vbo);
+        ebo = std::move(other.ebo);
+        instanceVbo = std::move(other.instanceVbo);
+        instanceCapacity = other.instanceCapacity;
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
+        lods = std::move(other.lods);
+        meshlets = std::move(other.meshlets);
+        meshletCounts = std::move(other.meshletCounts);
+        meshletOffsets = std::move(other.meshletOffsets);
+        meshletBaseVertices = std::move(other.meshletBaseVertices);
+        indexType = other.indexType;
+        format = other.format;
+        bounds = other.bounds;
+        textures = other.textures;
+        texture = other.texture;
+        geometry = other.geometry;
+        range = other.range;
+        other.instanceCapacity = 0;
+        other.geometry = nullptr;
+        other.range = GeometryRange();
+    }
+    return *this;
+}
+
+void Engine::Graphics::Mesh::Delete(){
+    if(geometry != nullptr){
+        geometry->Free(range);
+        geometry = nullptr;
+        range = GeometryRange();
+    }
     vbo.Delete();
     ebo.Delete();
+    instanceVbo.Delete();
     vao.Delete();
 }
 
 
 void Engine::Graphics::Mesh::setupMesh(){
+    if(!vertices.empty()){
+        bounds.min = bounds.max = vertices[0].position;
+        for(const Vertex& vertex : vertices){
+            bounds.min = glm::min(bounds.min, vertex.position);
+            bounds.max = glm::max(bounds.max, vertex.position);
+        }
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        for(const Vertex& vertex : vertices){
+            bounds.radius = std::max(bounds.radius, glm::length(vertex.position - bounds.center));
+        }
+    }
+
+    if(geometry != nullptr){
+        range = geometry->Allocate(vertices, indices);
+        return;
+    }
+
     vao.Bind();
-    vbo = VBO(vertices.data(), vertices.size() * sizeof(Vertex));
-    if(hasIndices){
+    std::vector<unsigned char> encoded = EncodeVertices(vertices, format, bounds.min, bounds.max);
+    vbo = VBO(encoded.data(), encoded.size());
+    uploadIndices();
+    LinkVertexFormat(vao, vbo, format);
+
+    vao.Unbind();
+}
+
+void Engine::Graphics::Mesh::uploadIndices(){
+    if(indexType == GL_UNSIGNED_SHORT){
+        std::vector<uint16_t> narrow = NarrowIndices(indices);
+        ebo = EBO((const void*)narrow.data(), narrow.size() * sizeof(uint16_t));
+    }
+    else{
         ebo = EBO(indices.data(), indices.size() * sizeof(GLuint));
     }
-    // Position
-    vao.LinkAttrib(vbo, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)0);
-    // Texture Coordinates
-    vao.LinkAttrib(vbo, 1, 2, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
-    // Normal
-    vao.LinkAttrib(vbo, 2, 3, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+}
 
+void Engine::Graphics::Mesh::GenerateLods(size_t maxLods, float ratio, float maxError){
+    indices.resize(lods[0].indexCount);
+    lods = BuildLodChain(indices, vertices, maxError * bounds.radius, maxLods, ratio);
+    replaceIndices();
+}
+
+void Engine::Graphics::Mesh::replaceIndices(){
+    if(geometry != nullptr){
+        geometry->Free(range);
+        range = geometry->Allocate(vertices, indices);
+        return;
+    }
+    vao.Bind();
+    uploadIndices();
     vao.Unbind();
 }
 
-void Engine::Graphics::Mesh::Draw(Shader& shader){
+void Engine::Graphics::Mesh::BuildMeshlets(size_t maxVertices, size_t maxTriangles){
+    // Only the full detail level is reordered, so the other levels' runs stay where they are
+    meshlets = Engine::Graphics::BuildMeshlets(indices, lods[0].firstIndex, lods[0].indexCount, vertices,
+        maxVertices, maxTriangles);
+    replaceIndices();
+}
+
+const std::vector<Engine::Graphics::Meshlet>& Engine::Graphics::Mesh::GetMeshlets() const{
+    return meshlets;
+}
+
+Engine::Graphics::GeometryRange Engine::Graphics::Mesh::GetMeshletRange(size_t meshlet) const{
+    GeometryRange meshletRange = range;
+    meshletRange.firstIndex += meshlets[meshlet].firstIndex;
+    meshletRange.indexCount = meshlets[meshlet].indexCount;
+    return meshletRange;
+}
+
+void Engine::Graphics::Mesh::DrawMeshlets(Shader& shader, const uint32_t* visible, size_t count){
+    if(count == 0){
+        return;
+    }
+
     shader.Activate();
 
-    if(texture != nullptr){
-        texture->Bind();
+    SetDecodeUniforms(shader);
+
+    BindTexture();
+
+    BindVertexArray();
+
+    DrawMeshletsBound(visible, count);
+}
+
+void Engine::Graphics::Mesh::DrawMeshletsBound(const uint32_t* visible, size_t count){
+    meshletCounts.clear();
+    meshletOffsets.clear();
+    // Meshlets follow each other in the index list, so visible neighbours are drawn as one run
+    GLuint runEnd = 0;
+    for(size_t i = 0; i < count; i++){
+        const Meshlet& meshlet = meshlets[visible[i]];
+        if(!meshletCounts.empty() && meshlet.firstIndex == runEnd){
+            meshletCounts.back() += meshlet.indexCount;
+        }
+        else{
+            GLuint firstIndex = geometry != nullptr ? range.firstIndex + meshlet.firstIndex : meshlet.firstIndex;
+            meshletCounts.push_back(meshlet.indexCount);
+            meshletOffsets.push_back((const void*)(firstIndex
+                * (geometry != nullptr ? sizeof(GLuint) : GetIndexSize(indexType))));
+        }
+        runEnd = meshlet.firstIndex + meshlet.indexCount;
+    }
+    if(meshletCounts.empty()){
+        return;
+    }
+
+    RenderStats::Current().drawCalls++;
+    if(geometry != nullptr){
+        meshletBaseVertices.assign(meshletCounts.size(), range.baseVertex);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, meshletCounts.data(), GL_UNSIGNED_INT, meshletOffsets.data(),
+            (GLsizei)meshletCounts.size(), meshletBaseVertices.data());
+        return;
+    }
+    glMultiDrawElements(GL_TRIANGLES, meshletCounts.data(), indexType, meshletOffsets.data(),
+        (GLsizei)meshletCounts.size());
+}
+
+size_t Engine::Graphics::Mesh::GetLodCount() const{
+    return lods.size();
+}
+
+const Engine::Graphics::MeshLod& Engine::Graphics::Mesh::GetLod(size_t lod) const{
+    return lods[lod];
+}
+
+size_t Engine::Graphics::Mesh::SelectLod(const Camera& camera, const glm::mat4& model, float viewportHeight,
+    float pixelError) const{
+    // Errors grow with the largest scale of the model matrix, and are nearest at the front of the bounding sphere
+    float scale = std::sqrt(std::max(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+        glm::dot(glm::vec3(model[1]), glm::vec3(model[1]))), glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))));
+    glm::vec3 center = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+    float distance = glm::length(center - camera.Position) - bounds.radius * scale;
+
+    size_t selected = 0;
+    while(selected + 1 < lods.size()
+        && GetProjectedError(lods[selected + 1].error * scale, distance, camera.GetZoom(), viewportHeight) <= pixelError){
+        selected++;
     }
+    return selected;
+}
+
+void Engine::Graphics::Mesh::BindTexture(){
+    Texture* tex = GetTexture();
+    if(tex != nullptr){
+        tex->Bind(0);
+    }
+}
 
+void Engine::Graphics::Mesh::BindVertexArray(){
+    if(geometry != nullptr){
+        geometry->Bind();
+        return;
+    }
     vao.Bind();
+}
 
-    if(hasIndices){
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+void Engine::Graphics::Mesh::SetDecodeUniforms(Shader& shader) const{
+    if(format == VertexFormat::Quantized){
+        shader.setVec3("positionOffset", bounds.min);
+        shader.setVec3("positionScale", bounds.max - bounds.min);
     }
-    else{
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+}
+
+void Engine::Graphics::Mesh::DrawBound(size_t lod){
+    if(geometry != nullptr){
+        geometry->Draw(GetRange(lod));
+        return;
     }
+    RenderStats::Current().drawCalls++;
+    glDrawElements(GL_TRIANGLES, lods[lod].indexCount, indexType,
+        (void*)(lods[lod].firstIndex * GetIndexSize(indexType)));
+}
 
+void Engine::Graphics::Mesh::Draw(Shader& shader, size_t lod){
+    shader.Activate();
+
+    SetDecodeUniforms(shader);
+
+    BindTexture();
+
+    BindVertexArray();
+
+    DrawBound(lod);
+}
+
+void Engine::Graphics::Mesh::setupInstances(size_t count){
+    if(count <= instanceCapacity){
+        return;
+    }
+
+    // Grow geometrically so a slowly increasing instance count doesn't reallocate every frame
+    instanceCapacity = std::max(count, instanceCapacity * 2);
+    instanceVbo = VBO(nullptr, instanceCapacity * sizeof(glm::mat4), GL_STREAM_DRAW);
+
+    // A mat4 attribute takes four consecutive locations, one per column
+    vao.Bind();
+    for(GLuint column = 0; column < 4; column++){
+        vao.LinkInstanceAttrib(instanceVbo, 3 + column, 4, GL_FLOAT, sizeof(glm::mat4),
+            (void*)(column * sizeof(glm::vec4)));
+    }
     vao.Unbind();
 }
 
-void Engine::Graphics::Mesh::SetTexture(Texture* tex){
+void Engine::Graphics::Mesh::DrawInstanced(Shader& shader, const std::vector<glm::mat4>& transforms, size_t lod){
+    DrawInstanced(shader, transforms.data(), transforms.size(), lod);
+}
+
+void Engine::Graphics::Mesh::DrawInstanced(Shader& shader, const glm::mat4* transforms, size_t count, size_t lod){
+    if(count == 0){
+        return;
+    }
+
+    if(geometry != nullptr){
+        shader.Activate();
+        BindTexture();
+        geometry->DrawInstanced(GetRange(lod), transforms, count);
+        return;
+    }
+
+    setupInstances(count);
+    instanceVbo.Update(transforms, count * sizeof(glm::mat4));
+
+    shader.Activate();
+
+    SetDecodeUniforms(shader);
+
+    BindTexture();
+
+    vao.Bind();
+
+    RenderStats::Current().drawCalls++;
+    glDrawElementsInstanced(GL_TRIANGLES, lods[lod].indexCount, indexType,
+        (void*)(lods[lod].firstIndex * GetIndexSize(indexType)), count);
+}
+
+const Engine::Graphics::MeshBounds& Engine::Graphics::Mesh::GetBounds() const{
+    return bounds;
+}
+
+size_t Engine::Graphics::Mesh::GetVertexCount() const{
+    return vertices.size();
+}
+
+size_t Engine::Graphics::Mesh::GetIndexCount(size_t lod) const{
+    return lods[lod].indexCount;
+}
+
+Engine::Graphics::VertexFormat Engine::Graphics::Mesh::GetFormat() const{
+    return format;
+}
+
+void Engine::Graphics::Mesh::SetTexture(TexturePool* textures, TextureHandle tex){
+    this->textures = textures;
     texture = tex;
 }
 
-Engine::Graphics::Mesh Engine::Graphics::Mesh::CreateCube(float size, Texture* tex) {
+Engine::Graphics::GeometryArena* Engine::Graphics::Mesh::GetGeometry() const{
+    return geometry;
+}
+
+Engine::Graphics::GeometryRange Engine::Graphics::Mesh::GetRange(size_t lod) const{
+    GeometryRange lodRange = range;
+    lodRange.firstIndex += lods[lod].firstIndex;
+    lodRange.indexCount = lods[lod].indexCount;
+    return lodRange;
+}
+
+Engine::Graphics::Texture* Engine::Graphics::Mesh::GetTexture() const{
+    return textures != nullptr ? textures->Get(texture) : nullptr;
+}
+
+Engine::Graphics::Mesh Engine::Graphics::Mesh::CreateCube(float size, TexturePool* textures, TextureHandle tex,
+    GeometryArena* geometry, VertexFormat format) {
     float halfSize = size / 2.0f;
 
+    // Four corners per face, since the faces don't share normals
     std::vector<Vertex> vertices;
 
     // Front face
     vertices.push_back({{-halfSize, -halfSize,  halfSize}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}});
     vertices.push_back({{ halfSize, -halfSize,  halfSize}, {1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}});
     vertices.push_back({{ halfSize,  halfSize,  halfSize}, {1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}});
-    vertices.push_back({{ halfSize,  halfSize,  halfSize}, {1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}});
     vertices.push_back({{-halfSize,  halfSize,  halfSize}, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}});
-    vertices.push_back({{-halfSize, -halfSize,  halfSize}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}});
 
     // Back face
     vertices.push_back({{-halfSize, -halfSize, -halfSize}, {1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}});
     vertices.push_back({{-halfSize,  halfSize, -halfSize}, {1.0f, 1.0f}, {0.0f, 0.0f, -1.0f}});
     vertices.push_back({{ halfSize,  halfSize, -halfSize}, {0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}});
-    vertices.push_back({{ halfSize,  halfSize, -halfSize}, {0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}});
     vertices.push_back({{ halfSize, -halfSize, -halfSize}, {0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}});
-    vertices.push_back({{-halfSize, -halfSize, -halfSize}, {1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}});
 
     // Left face
     vertices.push_back({{-halfSize,  halfSize,  halfSize}, {1.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}});
     vertices.push_back({{-halfSize,  halfSize, -halfSize}, {0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}});
     vertices.push_back({{-halfSize, -halfSize, -halfSize}, {0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}});
-    vertices.push_back({{-halfSize, -halfSize, -halfSize}, {0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}});
     vertices.push_back({{-halfSize, -halfSize,  halfSize}, {1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}});
-    vertices.push_back({{-halfSize,  halfSize,  halfSize}, {1.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}});
 
     // Right face
     vertices.push_back({{ halfSize,  halfSize,  halfSize}, {0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}});
     vertices.push_back({{ halfSize, -halfSize, -halfSize}, {1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}});
     vertices.push_back({{ halfSize,  halfSize, -halfSize}, {1.0f, 1.0f}, {1.0f, 0.0f, 0.0f}});
-    vertices.push_back({{ halfSize, -halfSize, -halfSize}, {1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}});
-    vertices.push_back({{ halfSize,  halfSize,  halfSize}, {0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}});
     vertices.push_back({{ halfSize, -halfSize,  halfSize}, {0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}});
 
     // Bottom face
     vertices.push_back({{-halfSize, -halfSize, -halfSize}, {0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}});
     vertices.push_back({{ halfSize, -halfSize, -halfSize}, {1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}});
     vertices.push_back({{ halfSize, -halfSize,  halfSize}, {1.0f, 1.0f}, {0.0f, -1.0f, 0.0f}});
-    vertices.push_back({{ halfSize, -halfSize,  halfSize}, {1.0f, 1.0f}, {0.0f, -1.0f, 0.0f}});
     vertices.push_back({{-halfSize, -halfSize,  halfSize}, {0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}});
-    vertices.push_back({{-halfSize, -halfSize, -halfSize}, {0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}});
 
     // Top face
     vertices.push_back({{-halfSize,  halfSize, -halfSize}, {0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}});
     vertices.push_back({{-halfSize,  halfSize,  halfSize}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}});
     vertices.push_back({{ halfSize,  halfSize,  halfSize}, {1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}});
-    vertices.push_back({{ halfSize,  halfSize,  halfSize}, {1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}});
     vertices.push_back({{ halfSize,  halfSize, -halfSize}, {1.0f, 1.0f}, {0.0f, 1.0f, 0.0f}});
-    vertices.push_back({{-halfSize,  halfSize, -halfSize}, {0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}});
 
-    return Mesh(vertices, {}, tex);  // No indices needed - using triangles directly
+    // Two triangles per face (the right face is split along the other diagonal)
+    std::vector<GLuint> indices = {
+        0, 1, 2, 2, 3, 0,
+        4, 5, 6, 6, 7, 4,
+        8, 9, 10, 10, 11, 8,
+        12, 13, 14, 13, 12, 15,
+        16, 17, 18, 18, 19, 16,
+        20, 21, 22, 22, 23, 20
+    };
+
+    return Mesh(vertices, indices, textures, tex, geometry, format);
+}
+
+Engine::Graphics::Mesh Engine::Graphics::Mesh::CreateSphere(int segments, float bumpHeight, TexturePool* textures,
+    TextureHandle tex, GeometryArena* geometry, VertexFormat format) {
+    IndexedGeometry sphere = CreateSphereGeometry(segments, bumpHeight);
+    return Mesh(sphere.vertices, sphere.indices, textures, tex, geometry, format);
 }
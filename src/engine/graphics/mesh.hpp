@@ -4,8 +4,14 @@
 #include "buffers/ebo.hpp"
 #include "buffers/vbo.hpp"
 #include "buffers/vao.hpp"
+#include "camera.hpp"
+#include "geometryarena.hpp"
+#include "meshlets.hpp"
+#include "meshlod.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
+#include "vertex.hpp"
+#include "vertexformat.hpp"
 #include <glm/glm.hpp>
 #include <GL/glew.h>
 #include <vector>
@@ -15,17 +21,13 @@ using namespace Engine::Graphics::Buffers;
 namespace Engine{
 namespace Graphics{
 
-// Struct for vertex data containing {position [x, y, z], texture mapping [0, 1], normal vector for lighting) [x, y, z]}
-struct Vertex {
-    glm::vec3 position;
-    glm::vec2 texCoords;
-    glm::vec3 normal;
-
-    Vertex(glm::vec3 pos, glm::vec2 tex, glm::vec3 norm)
-        : position(pos), texCoords(tex), normal(norm) {}
-
-    Vertex()
-        : position(0.0f), texCoords(0.0f), normal(0.0f, 0.0f, 1.0f) {}
+// Bounds of a mesh's vertex positions in model space
+struct MeshBounds {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+    // Sphere around the box center enclosing every vertex
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
 };
 
 class Mesh{
@@ -33,20 +35,102 @@ class Mesh{
         VAO vao;
         VBO vbo;
         EBO ebo;
+        // Per-instance model matrices for DrawInstanced, created on first use
+        VBO instanceVbo;
+        size_t instanceCapacity;
 
+        // Welded and optimized on construction, so every mesh is drawn indexed. The index lists of all
+        // levels of detail follow each other, the full detail one first.
         std::vector<Vertex> vertices;
         std::vector<GLuint> indices;
-        bool hasIndices;
-        Texture* texture;
+        std::vector<MeshLod> lods;
+        // Clusters of the full detail level, if built
+        std::vector<Meshlet> meshlets;
+        // Client arrays of DrawMeshlets
+        std::vector<GLsizei> meshletCounts;
+        std::vector<const void*> meshletOffsets;
+        std::vector<GLint> meshletBaseVertices;
+        // Type of the mesh's own index buffer: 16 bits whenever the vertex count allows
+        GLenum indexType;
+        // Layout of the vertices on the GPU (the arena's, if the mesh lives in one)
+        VertexFormat format;
+        MeshBounds bounds;
+        // Looked up at draw time, so a released texture is skipped instead of bound by a stale ID
+        TexturePool* textures;
+        TextureHandle texture;
+        // Shared buffers holding the mesh instead of its own, if any
+        GeometryArena* geometry;
+        GeometryRange range;
 
-        void setupMesh(); // Handles buffer binding (VAO, VBO, EBO (if applicable))
+        void setupMesh(); // Handles buffer binding (VAO, VBO, EBO (if applicable)) and computes the bounds
+        void uploadIndices(); // Fills the mesh's own index buffer; the vertex array must be bound
+        void replaceIndices(); // Stores the changed index list again, in the arena or the mesh's own buffer
+        void setupInstances(size_t count); // Grows the instance buffer and links it to attributes 3-6
 
     public:
-        Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint> indices = {}, Texture* tex = nullptr);
-        void Draw(Shader& shader);
-        void SetTexture(Texture* tex);
-        static Mesh CreateCube(float size = 1.0f, Texture* tex = nullptr);
-        ~Mesh();
+        // Duplicate vertices are welded, the triangles indexed (WeldVertices) and reordered for the vertex
+        // cache, overdraw and vertex fetch (OptimizeMesh). With a geometry arena the mesh is stored there
+        // and drawn through the arena's vertex array, in the arena's format; otherwise the vertices are
+        // uploaded in the given format.
+        Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint> indices = {},
+            TexturePool* textures = nullptr, TextureHandle tex = {}, GeometryArena* geometry = nullptr,
+            VertexFormat format = VertexFormat::Float);
+        // Move-only. The moved-from mesh is left without buffers or arena range, so Delete on it
+        // releases nothing; assigning over a mesh deletes what it held first.
+        Mesh(Mesh&& other) noexcept;
+        Mesh& operator=(Mesh&& other) noexcept;
+        void Draw(Shader& shader, size_t lod = 0);
+        // Draws one copy per model matrix in a single draw call (the shader must be built with INSTANCED)
+        void DrawInstanced(Shader& shader, const std::vector<glm::mat4>& transforms, size_t lod = 0);
+        void DrawInstanced(Shader& shader, const glm::mat4* transforms, size_t count, size_t lod = 0);
+        // Pieces of Draw for callers that track the bound state themselves (e.g. RenderQueue): binding
+        // what changed, then DrawBound for every mesh with the shader active. Draws leave the vertex
+        // array bound; GLState skips rebinding it for the next draw of the same mesh.
+        void BindTexture(); // Binds the texture on unit 0 (the diffuse map) if it is still alive
+        void BindVertexArray();
+        // Sets positionOffset and positionScale of the active shader for Quantized meshes; does nothing
+        // for other formats. Draw and DrawInstanced call it themselves.
+        void SetDecodeUniforms(Shader& shader) const;
+        void DrawBound(size_t lod = 0);
+        // Simplifies the mesh into up to maxLods levels of detail (BuildLodChain), each with about ratio
+        // times the triangles of the one before, and replaces the index buffer (or arena range) with
+        // all of them. maxError is relative to the bounding sphere radius. Ranges taken with GetRange
+        // before are no longer valid.
+        void GenerateLods(size_t maxLods = 4, float ratio = 0.5f, float maxError = 0.02f);
+        size_t GetLodCount() const;
+        const MeshLod& GetLod(size_t lod) const;
+        // Coarsest level whose error projects to at most pixelError pixels on a viewport of the given
+        // height, for the mesh drawn with a model matrix seen from the camera
+        size_t SelectLod(const Camera& camera, const glm::mat4& model, float viewportHeight,
+            float pixelError = 1.0f) const;
+        // Splits the full detail level into meshlets (BuildMeshlets) and replaces the index buffer (or
+        // arena range) with the reordered triangles. Ranges taken with GetRange before are no longer valid.
+        void BuildMeshlets(size_t maxVertices = 64, size_t maxTriangles = 124);
+        const std::vector<Meshlet>& GetMeshlets() const;
+        // Range of a meshlet in the arena, e.g. to batch the ones CullMeshlets keeps with BatchRenderer
+        GeometryRange GetMeshletRange(size_t meshlet) const;
+        // Draws the listed meshlets with one multi-draw call, runs of consecutive ones merged
+        void DrawMeshlets(Shader& shader, const uint32_t* visible, size_t count);
+        // The draw of DrawMeshlets alone, like DrawBound
+        void DrawMeshletsBound(const uint32_t* visible, size_t count);
+        void SetTexture(TexturePool* textures, TextureHandle tex);
+        // The texture if it is still alive, nullptr otherwise
+        Texture* GetTexture() const;
+        const MeshBounds& GetBounds() const;
+        size_t GetVertexCount() const;
+        size_t GetIndexCount(size_t lod = 0) const;
+        VertexFormat GetFormat() const;
+        // The arena holding the mesh, nullptr if it has its own buffers
+        GeometryArena* GetGeometry() const;
+        // Range of a level of detail in the arena
+        GeometryRange GetRange(size_t lod = 0) const;
+        static Mesh CreateCube(float size = 1.0f, TexturePool* textures = nullptr, TextureHandle tex = {},
+            GeometryArena* geometry = nullptr, VertexFormat format = VertexFormat::Float);
+        // Sphere of radius 1 with segments * segments triangles (CreateSphereGeometry)
+        static Mesh CreateSphere(int segments = 64, float bumpHeight = 0.0f, TexturePool* textures = nullptr,
+            TextureHandle tex = {}, GeometryArena* geometry = nullptr, VertexFormat format = VertexFormat::Float);
+        // Deletes the buffers (or frees the arena range) now, e.g. before the GL context is destroyed
+        void Delete();
 };
 }}
 
@@ -0,0 +1,215 @@
+#include "meshlets.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Clusters whose normals spread further than about 84 degrees from their average get no cone: it
+// would only cull them from a sliver of directions
+static const float MIN_CONE_SPREAD_COSINE = 0.1f;
+// Marks a cone no camera passes
+static const float NO_CONE_CUTOFF = 2.0f;
+
+// Zero for triangles with (next to) no area, whose normals are rounding noise; they cover no pixels
+// and are left out of the cones
+static glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    glm::vec3 normal = glm::cross(b - a, c - a);
+    float length = glm::length(normal);
+    if (length <= Engine::Graphics::MESHLET_MIN_AREA_RATIO * (glm::dot(b - a, b - a) + glm::dot(c - a, c - a)))
+        return glm::vec3(0.0f);
+    return normal / length;
+}
+
+// Sphere and normal cone of the triangles indices[meshlet.firstIndex, + indexCount)
+static void computeBounds(Engine::Graphics::Meshlet& meshlet, const std::vector<GLuint>& indices,
+                          const std::vector<Engine::Graphics::Vertex>& vertices)
+{
+    const GLuint* first = &indices[meshlet.firstIndex];
+    glm::vec3 boundsMin = vertices[first[0]].position, boundsMax = boundsMin;
+    for (GLuint i = 0; i < meshlet.indexCount; i++)
+    {
+        boundsMin = glm::min(boundsMin, vertices[first[i]].position);
+        boundsMax = glm::max(boundsMax, vertices[first[i]].position);
+    }
+    meshlet.center = (boundsMin + boundsMax) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (GLuint i = 0; i < meshlet.indexCount; i++)
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[first[i]].position - meshlet.center));
+
+    // The axis is the average facing; the cutoff follows from the normal furthest from it
+    glm::vec3 axis(0.0f);
+    for (GLuint i = 0; i < meshlet.indexCount; i += 3)
+        axis += triangleNormal(vertices[first[i]].position, vertices[first[i + 1]].position, vertices[first[i + 2]].position);
+    float axisLength = glm::length(axis);
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneAxis = glm::vec3(0.0f);
+    meshlet.coneCutoff = NO_CONE_CUTOFF;
+    if (axisLength == 0.0f)
+        return;
+    axis /= axisLength;
+
+    float minDot = 1.0f;
+    for (GLuint i = 0; i < meshlet.indexCount; i += 3)
+    {
+        glm::vec3 normal =
+            triangleNormal(vertices[first[i]].position, vertices[first[i + 1]].position, vertices[first[i + 2]].position);
+        if (normal != glm::vec3(0.0f))
+            minDot = std::min(minDot, glm::dot(normal, axis));
+    }
+    if (minDot <= MIN_CONE_SPREAD_COSINE)
+        return;
+
+    // The apex is moved back along the axis until it is behind every triangle's plane, so a camera
+    // inside the cone from there sees the backs of all of them (the cone of Wihlidal's cluster culling)
+    float maxT = 0.0f;
+    for (GLuint i = 0; i < meshlet.indexCount; i += 3)
+    {
+        const glm::vec3& corner = vertices[first[i]].position;
+        glm::vec3 normal = triangleNormal(corner, vertices[first[i + 1]].position, vertices[first[i + 2]].position);
+        if (normal == glm::vec3(0.0f))
+            continue;
+        maxT = std::max(maxT, glm::dot(meshlet.center - corner, normal) / glm::dot(axis, normal));
+    }
+    meshlet.coneApex = meshlet.center - axis * maxT;
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+std::vector<Engine::Graphics::Meshlet> Engine::Graphics::BuildMeshlets(std::vector<GLuint>& indices, size_t firstIndex,
+                                                                       size_t indexCount, const std::vector<Vertex>& vertices,
+                                                                       size_t maxVertices, size_t maxTriangles)
+{
+    std::vector<Meshlet> meshlets;
+    const size_t triangleCount = indexCount / 3;
+    const size_t vertexCount = vertices.size();
+    if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0)
+        return meshlets;
+    const GLuint* source = &indices[firstIndex];
+
+    // Triangles around each vertex
+    std::vector<GLuint> triangleStarts(vertexCount + 1, 0), vertexTriangles(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        triangleStarts[source[i] + 1]++;
+    for (size_t i = 0; i < vertexCount; i++)
+        triangleStarts[i + 1] += triangleStarts[i];
+    {
+        std::vector<GLuint> fill(triangleStarts.begin(), triangleStarts.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            vertexTriangles[fill[source[i]]++] = (GLuint)(i / 3);
+    }
+    std::vector<glm::vec3> centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        centroids[t] = (vertices[source[t * 3]].position + vertices[source[t * 3 + 1]].position
+                        + vertices[source[t * 3 + 2]].position) / 3.0f;
+
+    std::vector<GLuint> result;
+    result.reserve(triangleCount * 3);
+    std::vector<bool> emitted(triangleCount, false);
+    // Meshlet each vertex was last added to, plus one
+    std::vector<GLuint> vertexMeshlet(vertexCount, 0);
+    std::vector<GLuint> candidates;
+    size_t seed = 0;
+    while (true)
+    {
+        while (seed < triangleCount && emitted[seed])
+            seed++;
+        if (seed == triangleCount)
+            break;
+
+        Meshlet meshlet;
+        meshlet.firstIndex = (GLuint)(firstIndex + result.size());
+        const GLuint stamp = (GLuint)meshlets.size() + 1;
+        glm::vec3 centroidSum(0.0f);
+        size_t triangles = 0;
+        candidates.clear();
+        candidates.push_back((GLuint)seed);
+        while (triangles < maxTriangles)
+        {
+            // The candidate adding the fewest new vertices, then the one nearest the meshlet's center, which
+            // keeps it round and so its bounds tight
+            glm::vec3 centroid = triangles > 0 ? centroidSum / (float)triangles : centroids[seed];
+            bool found = false;
+            size_t best = 0;
+            int bestNew = 4;
+            float bestDistance = 0.0f;
+            size_t write = 0;
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                GLuint t = candidates[i];
+                if (emitted[t])
+                    continue;
+                candidates[write] = t;
+                int added = (vertexMeshlet[source[t * 3]] != stamp) + (vertexMeshlet[source[t * 3 + 1]] != stamp)
+                            + (vertexMeshlet[source[t * 3 + 2]] != stamp);
+                glm::vec3 offset = centroids[t] - centroid;
+                float distance = glm::dot(offset, offset);
+                if (meshlet.vertexCount + added <= maxVertices
+                    && (added < bestNew || (added == bestNew && distance < bestDistance)))
+                {
+                    found = true;
+                    best = write;
+                    bestNew = added;
+                    bestDistance = distance;
+                }
+                write++;
+            }
+            candidates.resize(write);
+            // Nothing left that touches the meshlet and fits, so it is closed rather than scattered
+            if (!found)
+                break;
+
+            GLuint t = candidates[best];
+            emitted[t] = true;
+            triangles++;
+            centroidSum += centroids[t];
+            for (int corner = 0; corner < 3; corner++)
+            {
+                GLuint vertex = source[t * 3 + corner];
+                result.push_back(vertex);
+                if (vertexMeshlet[vertex] == stamp)
+                    continue;
+                vertexMeshlet[vertex] = stamp;
+                meshlet.vertexCount++;
+                for (GLuint n = triangleStarts[vertex]; n < triangleStarts[vertex + 1]; n++)
+                {
+                    if (!emitted[vertexTriangles[n]])
+                        candidates.push_back(vertexTriangles[n]);
+                }
+            }
+        }
+        meshlet.indexCount = (GLuint)(firstIndex + result.size()) - meshlet.firstIndex;
+        meshlets.push_back(meshlet);
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin() + firstIndex);
+    for (Meshlet& meshlet : meshlets)
+        computeBounds(meshlet, indices, vertices);
+    return meshlets;
+}
+
+size_t Engine::Graphics::CullMeshlets(const std::vector<Meshlet>& meshlets, const glm::mat4& model, const Frustum& frustum,
+                                      const glm::vec3& cameraPosition, uint32_t* visible, bool backfaceCulling)
+{
+    float scale = std::sqrt(std::max(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+                                              glm::dot(glm::vec3(model[1]), glm::vec3(model[1]))),
+                                     glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))));
+    const glm::mat3 rotation(model);
+    size_t count = 0;
+    for (size_t i = 0; i < meshlets.size(); i++)
+    {
+        const Meshlet& meshlet = meshlets[i];
+        glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.center, 1.0f));
+        if (!frustum.IntersectsSphere(center, meshlet.radius * scale))
+            continue;
+        if (backfaceCulling && meshlet.coneCutoff <= 1.0f)
+        {
+            glm::vec3 apex = glm::vec3(model * glm::vec4(meshlet.coneApex, 1.0f));
+            glm::vec3 axis = rotation * meshlet.coneAxis / scale;
+            glm::vec3 view = apex - cameraPosition;
+            float distance = glm::length(view);
+            if (distance > 0.0f && glm::dot(view, axis) >= meshlet.coneCutoff * distance)
+                continue;
+        }
+        visible[count++] = (uint32_t)i;
+    }
+    return count;
+}
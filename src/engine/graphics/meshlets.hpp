@@ -0,0 +1,55 @@
+#ifndef ENGINE_GRAPHICS_MESHLETS_HPP
+#define ENGINE_GRAPHICS_MESHLETS_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frustum.hpp"
+#include "vertex.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// A small cluster of a mesh's triangles, stored as one run of its index list, with the bounds used to
+// skip it when it can't be seen
+struct Meshlet
+{
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+    GLuint vertexCount = 0;
+    // Sphere around every vertex
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    // Every triangle faces away (counter-clockwise being the front) from cameras with
+    // dot(normalize(coneApex - camera), coneAxis) >= coneCutoff. Clusters whose normals spread too far
+    // get a cutoff above 1, which no camera passes.
+    glm::vec3 coneApex = glm::vec3(0.0f);
+    glm::vec3 coneAxis = glm::vec3(0.0f);
+    float coneCutoff = 2.0f;
+};
+
+// Triangles whose doubled area is below this share of their two edges' squared lengths are slivers
+// without a reliable facing, and are ignored by the normal cones
+const float MESHLET_MIN_AREA_RATIO = 1e-6f;
+
+// Reorders the triangles of indices[firstIndex, firstIndex + indexCount) into meshlets of at most
+// maxVertices distinct vertices and maxTriangles triangles, and computes their bounds. Each meshlet is
+// grown from a seed triangle by the neighbour that adds the fewest new vertices, the one nearest its
+// center among equals, so it stays round and its sphere and cone tight; seeds are taken in the list's
+// order, which keeps much of a vertex cache optimized order. Returns the meshlets in index order.
+std::vector<Meshlet> BuildMeshlets(std::vector<GLuint>& indices, size_t firstIndex, size_t indexCount,
+                                   const std::vector<Vertex>& vertices, size_t maxVertices = 64,
+                                   size_t maxTriangles = 124);
+
+// Writes the indices of the meshlets of a mesh drawn with a model matrix that may be visible: inside
+// the frustum and, with backfaceCulling, not facing away from the camera by their normal cones.
+// Returns their count. Cone culling drops back faces, so it is only for meshes whose backs are never
+// seen (closed ones, or open ones drawn with face culling). The model matrix may only scale uniformly.
+size_t CullMeshlets(const std::vector<Meshlet>& meshlets, const glm::mat4& model, const Frustum& frustum,
+                    const glm::vec3& cameraPosition, uint32_t* visible, bool backfaceCulling = true);
+}}
+
+#endif
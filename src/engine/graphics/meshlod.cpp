@@ -0,0 +1,313 @@
+#include "meshlod.hpp"
+#include "meshprocessing.hpp"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Rejects a collapse that turns a neighbouring triangle's normal by more than about 75 degrees
+static const float MAX_NORMAL_TURN_COSINE = 0.25f;
+// Levels that keep more than this share of the previous level's triangles aren't worth storing
+static const float MIN_LOD_REDUCTION = 0.9f;
+
+// Sum of squared distances to a set of planes, each weighted by the area of its triangle. Doubles, as
+// the terms of distant planes cancel out.
+struct Quadric
+{
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+
+    void AddPlane(const glm::dvec3& normal, double distance, double area)
+    {
+        a00 += area * normal.x * normal.x;
+        a01 += area * normal.x * normal.y;
+        a02 += area * normal.x * normal.z;
+        a11 += area * normal.y * normal.y;
+        a12 += area * normal.y * normal.z;
+        a22 += area * normal.z * normal.z;
+        b0 += area * normal.x * distance;
+        b1 += area * normal.y * distance;
+        b2 += area * normal.z * distance;
+        c += area * distance * distance;
+        weight += area;
+    }
+
+    void Add(const Quadric& other)
+    {
+        a00 += other.a00;
+        a01 += other.a01;
+        a02 += other.a02;
+        a11 += other.a11;
+        a12 += other.a12;
+        a22 += other.a22;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    // Mean squared distance of a point to the planes
+    double Evaluate(const glm::vec3& point) const
+    {
+        if (weight <= 0.0)
+            return 0.0;
+        double x = point.x, y = point.y, z = point.z;
+        double value = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                       + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(value, 0.0) / weight;
+    }
+};
+
+struct Collapse
+{
+    GLuint from;
+    GLuint to;
+    double cost;
+};
+
+// Error of moving both ends of an edge to the target: the sum of their quadrics (Q_from + Q_to, as
+// Garland and Heckbert define it), so planes around the end that stays count as well
+static double collapseCost(const Quadric& from, const Quadric& to, const glm::vec3& target)
+{
+    Quadric edge = from;
+    edge.Add(to);
+    return edge.Evaluate(target);
+}
+
+static glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    return glm::cross(b - a, c - a);
+}
+
+std::vector<GLuint> Engine::Graphics::SimplifyMesh(const std::vector<GLuint>& indices, const std::vector<Vertex>& vertices,
+                                                   size_t targetIndexCount, float maxError, float* error)
+{
+    const size_t vertexCount = vertices.size();
+    std::vector<GLuint> result = indices;
+    double reachedError = 0.0;
+
+    // Vertices at the same position share an id, so seams can be found and the surface's edges
+    // counted regardless of the attributes on either side
+    std::vector<GLuint> byPosition(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+        byPosition[i] = (GLuint)i;
+    auto positionLess = [&vertices](GLuint a, GLuint b) {
+        const glm::vec3& p = vertices[a].position;
+        const glm::vec3& q = vertices[b].position;
+        return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+    };
+    std::sort(byPosition.begin(), byPosition.end(), positionLess);
+    std::vector<GLuint> positionId(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t start = 0, end; start < vertexCount; start = end)
+    {
+        end = start + 1;
+        while (end < vertexCount && vertices[byPosition[end]].position == vertices[byPosition[start]].position)
+            end++;
+        for (size_t i = start; i < end; i++)
+        {
+            positionId[byPosition[i]] = byPosition[start];
+            // Several vertices at one position are a seam in the texture coordinates or normals
+            locked[byPosition[i]] = end - start > 1;
+        }
+    }
+
+    // Edges used by one triangle are open borders and edges used by more are non-manifold; both keep
+    // their vertices in place
+    std::vector<uint64_t> edges;
+    edges.reserve(result.size());
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (int corner = 0; corner < 3; corner++)
+        {
+            GLuint a = positionId[result[i + corner]], b = positionId[result[i + (corner + 1) % 3]];
+            if (a != b)
+                edges.push_back((uint64_t)std::min(a, b) << 32 | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<bool> positionLocked(vertexCount, false);
+    for (size_t start = 0, end; start < edges.size(); start = end)
+    {
+        end = start + 1;
+        while (end < edges.size() && edges[end] == edges[start])
+            end++;
+        if (end - start != 2)
+        {
+            positionLocked[(GLuint)(edges[start] >> 32)] = true;
+            positionLocked[(GLuint)(edges[start] & 0xFFFFFFFF)] = true;
+        }
+    }
+    for (size_t i = 0; i < vertexCount; i++)
+        locked[i] = locked[i] || positionLocked[positionId[i]];
+
+    // Each triangle's plane goes into the quadrics of its three corners' positions
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        glm::dvec3 a = vertices[result[i]].position, b = vertices[result[i + 1]].position,
+                   c = vertices[result[i + 2]].position;
+        glm::dvec3 normal = glm::cross(b - a, c - a);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+        normal /= length;
+        double distance = -glm::dot(normal, a);
+        for (int corner = 0; corner < 3; corner++)
+            quadrics[positionId[result[i + corner]]].AddPlane(normal, distance, length * 0.5);
+    }
+
+    const double maxCost = (double)maxError * maxError;
+    std::vector<GLuint> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<GLuint> triangleStarts(vertexCount + 1), vertexTriangles;
+    std::vector<Collapse> collapses;
+    while (result.size() > targetIndexCount)
+    {
+        // Triangles around each vertex
+        std::fill(triangleStarts.begin(), triangleStarts.end(), 0);
+        for (GLuint index : result)
+            triangleStarts[index + 1]++;
+        for (size_t i = 0; i < vertexCount; i++)
+            triangleStarts[i + 1] += triangleStarts[i];
+        vertexTriangles.resize(result.size());
+        {
+            std::vector<GLuint> fill(triangleStarts.begin(), triangleStarts.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+                vertexTriangles[fill[result[i]]++] = (GLuint)(i / 3);
+        }
+
+        // Every edge can collapse from an unlocked end onto the other; cheapest first
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                GLuint from = result[i + corner], to = result[i + (corner + 1) % 3];
+                const Quadric& fromQuadric = quadrics[positionId[from]];
+                const Quadric& toQuadric = quadrics[positionId[to]];
+                if (!locked[from])
+                    collapses.push_back(Collapse{from, to, collapseCost(fromQuadric, toQuadric, vertices[to].position)});
+                if (!locked[to])
+                    collapses.push_back(Collapse{to, from, collapseCost(toQuadric, fromQuadric, vertices[from].position)});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // Collapses are applied until the target is reached, each only if none of the triangles it
+        // changes was changed earlier in the pass, so the checks below see the current surface
+        for (size_t i = 0; i < vertexCount; i++)
+            remap[i] = (GLuint)i;
+        std::fill(touched.begin(), touched.end(), false);
+        size_t remainingIndices = result.size();
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (remainingIndices <= targetIndexCount || collapse.cost > maxCost)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // The triangles that keep their area must not fold over
+            const glm::vec3& target = vertices[collapse.to].position;
+            bool flips = false;
+            size_t removed = 0;
+            for (GLuint t = triangleStarts[collapse.from]; t < triangleStarts[collapse.from + 1] && !flips; t++)
+            {
+                const GLuint* triangle = &result[vertexTriangles[t] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    removed++;
+                    continue;
+                }
+                glm::vec3 corners[3], moved[3];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    corners[corner] = vertices[triangle[corner]].position;
+                    moved[corner] = triangle[corner] == collapse.from ? target : corners[corner];
+                }
+                glm::vec3 before = triangleNormal(corners[0], corners[1], corners[2]);
+                glm::vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+                flips = glm::dot(before, after) <= MAX_NORMAL_TURN_COSINE * glm::length(before) * glm::length(after);
+            }
+            if (flips)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[positionId[collapse.to]].Add(quadrics[positionId[collapse.from]]);
+            for (GLuint t = triangleStarts[collapse.from]; t < triangleStarts[collapse.from + 1]; t++)
+            {
+                const GLuint* triangle = &result[vertexTriangles[t] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+            reachedError = std::max(reachedError, collapse.cost);
+            remainingIndices -= removed * 3;
+            applied++;
+        }
+        if (applied == 0)
+            break;
+
+        // Moves the collapsed vertices and drops the triangles that lost their area
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            GLuint a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (error != nullptr)
+        *error = (float)std::sqrt(reachedError);
+    return result;
+}
+
+std::vector<Engine::Graphics::MeshLod> Engine::Graphics::BuildLodChain(std::vector<GLuint>& indices,
+                                                                       const std::vector<Vertex>& vertices, float maxError,
+                                                                       size_t maxLods, float ratio)
+{
+    std::vector<MeshLod> lods(1);
+    lods[0].indexCount = (GLuint)indices.size();
+    // Simplifying the full detail list each time measures every level's error against the real surface
+    const std::vector<GLuint> source = indices;
+    while (lods.size() < maxLods)
+    {
+        const MeshLod& previous = lods.back();
+        size_t target = (size_t)(previous.indexCount / 3 * ratio) * 3;
+        if (target == 0)
+            break;
+        float error = 0.0f;
+        std::vector<GLuint> lod = SimplifyMesh(source, vertices, target, maxError, &error);
+        if (lod.empty() || lod.size() > previous.indexCount * MIN_LOD_REDUCTION)
+            break;
+
+        lod = OptimizeVertexCache(lod, vertices.size());
+        MeshLod level;
+        level.firstIndex = (GLuint)indices.size();
+        level.indexCount = (GLuint)lod.size();
+        level.error = std::max(error, previous.error);
+        indices.insert(indices.end(), lod.begin(), lod.end());
+        lods.push_back(level);
+    }
+    return lods;
+}
+
+float Engine::Graphics::GetProjectedError(float error, float distance, float fovY, float viewportHeight)
+{
+    if (distance <= 0.0f)
+        return error > 0.0f ? INFINITY : 0.0f;
+    return error / (2.0f * distance * std::tan(glm::radians(fovY) * 0.5f)) * viewportHeight;
+}
+
+float Engine::Graphics::GetLodDistance(float error, float fovY, float viewportHeight, float pixelError)
+{
+    return error * viewportHeight / (2.0f * pixelError * std::tan(glm::radians(fovY) * 0.5f));
+}
@@ -0,0 +1,43 @@
+#ifndef ENGINE_GRAPHICS_MESHLOD_HPP
+#define ENGINE_GRAPHICS_MESHLOD_HPP
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+#include "vertex.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// One level of detail: a run of a mesh's index list, and how far (in model units) its surface may be
+// from the full detail one
+struct MeshLod
+{
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+    float error = 0.0f;
+};
+
+// Removes triangles by collapsing edges in order of their quadric error (Garland and Heckbert) until
+// at most targetIndexCount indices remain or every collapse would move the surface further than
+// maxError. Each collapse moves a vertex onto a neighbour, so the vertices left keep their own
+// attributes; vertices on texture or normal seams and on open borders are never moved, which keeps
+// those edges where they are. The vertices are not touched. Writes the error reached to error.
+std::vector<GLuint> SimplifyMesh(const std::vector<GLuint>& indices, const std::vector<Vertex>& vertices,
+                                 size_t targetIndexCount, float maxError, float* error = nullptr);
+
+// Appends coarser versions of the index list (each with about ratio times the triangles of the one
+// before, simplified from the full detail list) until maxLods levels exist, the error would exceed
+// maxError (in model units) or simplification stops making progress. Every level is optimized for the
+// vertex cache. Returns the levels, the full detail one first.
+std::vector<MeshLod> BuildLodChain(std::vector<GLuint>& indices, const std::vector<Vertex>& vertices, float maxError,
+                                   size_t maxLods = 4, float ratio = 0.5f);
+
+// Height in pixels an error at a distance covers, for a vertical field of view in degrees
+float GetProjectedError(float error, float distance, float fovY, float viewportHeight);
+// Distance beyond which an error covers less than pixelError pixels
+float GetLodDistance(float error, float fovY, float viewportHeight, float pixelError = 1.0f);
+}}
+
+#endif
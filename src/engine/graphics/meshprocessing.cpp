@@ -0,0 +1,395 @@
+#include "meshprocessing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+static const uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+// Cache modelled when scoring vertices in OptimizeVertexCache (an LRU, as in Forsyth's paper)
+static const size_t SCORING_CACHE_SIZE = 32;
+// Remaining triangle counts with a precomputed valence score; higher counts use the last entry
+static const size_t SCORED_VALENCES = 64;
+// FIFO size OptimizeOverdraw measures its clusters with, a common hardware size
+static const size_t OVERDRAW_CACHE_SIZE = 16;
+
+// FIFO post-transform cache: a vertex is cached while fewer than size misses happened since its own
+class FifoCache
+{
+public:
+    FifoCache(size_t vertexCount, size_t size)
+        : stamps(vertexCount, 0), size((uint32_t)size), time((uint32_t)size + 1)
+    {
+    }
+
+    // Returns true on a miss, which shades the vertex and pushes it in
+    bool Access(GLuint vertex)
+    {
+        if (time - stamps[vertex] < size)
+            return false;
+        stamps[vertex] = time++;
+        return true;
+    }
+
+    void Clear()
+    {
+        time += size;
+    }
+
+private:
+    std::vector<uint32_t> stamps;
+    uint32_t size;
+    uint32_t time;
+};
+
+// Equal as floats, so +0 and -0 weld while NaN never does
+static bool sameVertex(const Engine::Graphics::Vertex& a, const Engine::Graphics::Vertex& b)
+{
+    return a.position == b.position && a.texCoords == b.texCoords && a.normal == b.normal;
+}
+
+static uint32_t hashVertex(const Engine::Graphics::Vertex& vertex)
+{
+    // Adding zero turns -0 into +0, keeping the hash consistent with sameVertex
+    const float values[8] = {vertex.position.x + 0.0f, vertex.position.y + 0.0f, vertex.position.z + 0.0f,
+                             vertex.texCoords.x + 0.0f, vertex.texCoords.y + 0.0f,
+                             vertex.normal.x + 0.0f,    vertex.normal.y + 0.0f,   vertex.normal.z + 0.0f};
+    uint32_t hash = 2166136261u;
+    for (float value : values)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        hash = (hash ^ bits) * 16777619u;
+    }
+    // FNV over whole words leaves the low bits weak, and those pick the slot
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+Engine::Graphics::IndexedGeometry Engine::Graphics::WeldVertices(const std::vector<Vertex>& vertices,
+                                                                 const std::vector<GLuint>& indices)
+{
+    IndexedGeometry result;
+    if (vertices.empty())
+        return result;
+
+    // Power of two at least twice the vertex count keeps probe sequences short
+    size_t slotCount = 16;
+    while (slotCount < vertices.size() * 2)
+        slotCount *= 2;
+    std::vector<uint32_t> slots(slotCount, EMPTY_SLOT);
+
+    // Welded index of each source vertex, so indexed input hashes every vertex once
+    std::vector<GLuint> remap(vertices.size(), EMPTY_SLOT);
+    size_t indexCount = indices.empty() ? vertices.size() : indices.size();
+    result.indices.reserve(indexCount);
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        GLuint source = indices.empty() ? (GLuint)i : indices[i];
+        if (remap[source] == EMPTY_SLOT)
+        {
+            const Vertex& vertex = vertices[source];
+            size_t slot = hashVertex(vertex) & (slotCount - 1);
+            while (slots[slot] != EMPTY_SLOT && !sameVertex(result.vertices[slots[slot]], vertex))
+                slot = (slot + 1) & (slotCount - 1);
+
+            if (slots[slot] == EMPTY_SLOT)
+            {
+                slots[slot] = (uint32_t)result.vertices.size();
+                result.vertices.push_back(vertex);
+            }
+            remap[source] = slots[slot];
+        }
+        result.indices.push_back(remap[source]);
+    }
+    return result;
+}
+
+Engine::Graphics::IndexedGeometry Engine::Graphics::CreateSphereGeometry(int segments, float bumpHeight)
+{
+    const int rings = segments / 2;
+    auto point = [&](int segment, int ring) {
+        float theta = glm::two_pi<float>() * segment / segments;
+        float phi = glm::pi<float>() * ring / rings;
+        glm::vec3 direction(glm::sin(phi) * glm::cos(theta), glm::cos(phi), glm::sin(phi) * glm::sin(theta));
+        float radius = 1.0f + bumpHeight * glm::sin(6.0f * theta) * glm::sin(6.0f * phi);
+        return Vertex(direction * radius, glm::vec2((float)segment / segments, (float)ring / rings), direction);
+    };
+    std::vector<Vertex> triangles;
+    triangles.reserve((size_t)segments * rings * 6);
+    for (int ring = 0; ring < rings; ring++)
+    {
+        for (int segment = 0; segment < segments; segment++)
+        {
+            Vertex a = point(segment, ring), b = point(segment + 1, ring);
+            Vertex c = point(segment, ring + 1), d = point(segment + 1, ring + 1);
+            triangles.insert(triangles.end(), {a, b, c, c, b, d});
+        }
+    }
+    return WeldVertices(triangles);
+}
+
+Engine::Graphics::VertexCacheStats Engine::Graphics::AnalyzeVertexCache(const std::vector<GLuint>& indices,
+                                                                       size_t vertexCount, size_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.size() < 3 || vertexCount == 0)
+        return stats;
+
+    FifoCache cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (GLuint index : indices)
+        misses += cache.Access(index);
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = (float)misses / (float)vertexCount;
+    return stats;
+}
+
+std::vector<GLuint> Engine::Graphics::OptimizeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return indices;
+
+    // Forsyth's scores: cache position rewards reuse of recent vertices, valence finishes off vertices
+    // with few triangles left so they don't linger as stragglers
+    float cacheScores[SCORING_CACHE_SIZE];
+    for (size_t position = 0; position < SCORING_CACHE_SIZE; position++)
+    {
+        // The last triangle's vertices get a fixed score, so its neighbours aren't always preferred
+        cacheScores[position] = position < 3 ? 0.75f
+            : std::pow(1.0f - (float)(position - 3) / (float)(SCORING_CACHE_SIZE - 3), 1.5f);
+    }
+    float valenceScores[SCORED_VALENCES];
+    for (size_t valence = 1; valence < SCORED_VALENCES; valence++)
+        valenceScores[valence] = 2.0f / std::sqrt((float)valence);
+    valenceScores[0] = 0.0f;
+    auto vertexScore = [&](int position, uint32_t remaining) {
+        if (remaining == 0)
+            return -1.0f;
+        float score = valenceScores[std::min<size_t>(remaining, SCORED_VALENCES - 1)];
+        return position >= 0 ? score + cacheScores[position] : score;
+    };
+
+    // Triangles of each vertex; the first remaining[v] entries are the ones not emitted yet
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (GLuint index : indices)
+        remaining[index]++;
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> filled(vertexCount, 0);
+    for (size_t i = 0; i < indices.size(); i++)
+        adjacency[offsets[indices[i]] + filled[indices[i]]++] = (uint32_t)(i / 3);
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> triangleScores(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]]
+                          + vertexScores[indices[t * 3 + 2]];
+    }
+    std::vector<unsigned char> emitted(triangleCount, 0);
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    std::vector<GLuint> cache, grown;
+    cache.reserve(SCORING_CACHE_SIZE + 3);
+    grown.reserve(SCORING_CACHE_SIZE + 3);
+
+    size_t best = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+    // Next candidate when no cached vertex has triangles left; everything before it is emitted
+    size_t restart = 0;
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        if (best == SIZE_MAX)
+        {
+            while (emitted[restart])
+                restart++;
+            best = restart;
+        }
+
+        const GLuint* triangle = &indices[best * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[best] = 1;
+
+        grown.clear();
+        for (int corner = 0; corner < 3; corner++)
+        {
+            GLuint vertex = triangle[corner];
+            // Drop the triangle from the vertex's remaining ones
+            uint32_t* list = &adjacency[offsets[vertex]];
+            uint32_t* found = std::find(list, list + remaining[vertex], (uint32_t)best);
+            std::swap(*found, list[remaining[vertex] - 1]);
+            remaining[vertex]--;
+
+            if (std::find(grown.begin(), grown.end(), vertex) == grown.end())
+                grown.push_back(vertex);
+        }
+        // The triangle's vertices move to the front of the cache, everything else shifts back
+        for (GLuint vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                grown.push_back(vertex);
+        }
+
+        for (size_t i = 0; i < grown.size(); i++)
+        {
+            GLuint vertex = grown[i];
+            cachePositions[vertex] = i < SCORING_CACHE_SIZE ? (int)i : -1;
+            vertexScores[vertex] = vertexScore(cachePositions[vertex], remaining[vertex]);
+        }
+
+        // Only triangles of vertices whose score changed can become the best
+        best = SIZE_MAX;
+        float bestScore = -1.0f;
+        for (GLuint vertex : grown)
+        {
+            const uint32_t* list = &adjacency[offsets[vertex]];
+            for (uint32_t i = 0; i < remaining[vertex]; i++)
+            {
+                uint32_t t = list[i];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]]
+                            + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+
+        if (grown.size() > SCORING_CACHE_SIZE)
+            grown.resize(SCORING_CACHE_SIZE);
+        std::swap(cache, grown);
+    }
+    return result;
+}
+
+std::vector<GLuint> Engine::Graphics::OptimizeOverdraw(const std::vector<GLuint>& indices,
+                                                       const std::vector<Vertex>& vertices, float threshold)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return indices;
+
+    // Hard boundaries: triangles missing all three vertices start cold anyway, so cutting there is free
+    std::vector<unsigned char> hardStart(triangleCount, 0);
+    FifoCache cache(vertices.size(), OVERDRAW_CACHE_SIZE);
+    size_t totalMisses = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        size_t misses = cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+        hardStart[t] = misses == 3;
+        totalMisses += misses;
+    }
+    float targetAcmr = (float)totalMisses / (float)triangleCount * threshold;
+
+    // Soft boundaries: a cluster may end once its ACMR, counted from a cold cache, is within the target
+    std::vector<size_t> clusterStarts;
+    size_t clusterMisses = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (t == 0 || hardStart[t] || (float)clusterMisses <= targetAcmr * (float)(t - clusterStarts.back()))
+        {
+            clusterStarts.push_back(t);
+            cache.Clear();
+            clusterMisses = 0;
+        }
+        clusterMisses += cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+    }
+    clusterStarts.push_back(triangleCount);
+
+    // Area weighted centroid and normal of every cluster and of the whole mesh
+    size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f)), normals(clusterCount, glm::vec3(0.0f));
+    std::vector<float> areas(clusterCount, 0.0f);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+        {
+            const glm::vec3& a = vertices[indices[t * 3]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 normal = glm::cross(b - a, p - a);
+            float area = glm::length(normal);
+            centroids[c] += (a + b + p) * (area / 3.0f);
+            normals[c] += normal;
+            areas[c] += area;
+        }
+        meshCentroid += centroids[c];
+        meshArea += areas[c];
+        if (areas[c] > 0.0f)
+            centroids[c] /= areas[c];
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    std::vector<float> keys(clusterCount, 0.0f);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float length = glm::length(normals[c]);
+        if (length > 0.0f)
+            keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c] / length);
+    }
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    for (size_t c : order)
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    return result;
+}
+
+void Engine::Graphics::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    std::vector<GLuint> remap(vertices.size(), EMPTY_SLOT);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for (GLuint& index : indices)
+    {
+        if (remap[index] == EMPTY_SLOT)
+        {
+            remap[index] = (GLuint)reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices = std::move(reordered);
+}
+
+void Engine::Graphics::OptimizeMesh(IndexedGeometry& geometry)
+{
+    geometry.indices = OptimizeVertexCache(geometry.indices, geometry.vertices.size());
+    geometry.indices = OptimizeOverdraw(geometry.indices, geometry.vertices);
+    OptimizeVertexFetch(geometry.vertices, geometry.indices);
+}
+
+GLenum Engine::Graphics::GetIndexType(size_t vertexCount)
+{
+    return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t Engine::Graphics::GetIndexSize(GLenum indexType)
+{
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+}
+
+std::vector<uint16_t> Engine::Graphics::NarrowIndices(const std::vector<GLuint>& indices)
+{
+    return std::vector<uint16_t>(indices.begin(), indices.end());
+}
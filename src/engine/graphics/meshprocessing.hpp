@@ -0,0 +1,63 @@
+#ifndef ENGINE_GRAPHICS_MESHPROCESSING_HPP
+#define ENGINE_GRAPHICS_MESHPROCESSING_HPP
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vertex.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Triangle list with every distinct vertex stored once
+struct IndexedGeometry
+{
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+};
+
+// Merges vertices whose position, texture coordinates and normal are all equal, so each is transformed
+// once and can be reused from the post-transform cache. Vertices are found through an open addressing
+// hash table and kept in order of first use. Without indices the vertices are read as a triangle list.
+IndexedGeometry WeldVertices(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices = {});
+
+// Welded sphere around the origin with segments around it and segments / 2 rings (segments * segments
+// triangles). Its radius of 1 ripples by up to bumpHeight, giving simplification curvature to keep.
+IndexedGeometry CreateSphereGeometry(int segments, float bumpHeight = 0.0f);
+
+// Post-transform cache behaviour of a triangle list, simulated as a FIFO of recently shaded vertices
+struct VertexCacheStats
+{
+    // Average cache miss ratio: vertices shaded per triangle (3 without any reuse, 0.5 at best)
+    float acmr = 0.0f;
+    // Average transform to vertex ratio: vertices shaded per distinct vertex (1 is optimal)
+    float atvr = 0.0f;
+};
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, size_t cacheSize = 16);
+
+// Reorders triangles so vertices are reused while still in the post-transform cache (Forsyth's linear
+// speed algorithm). Triangles keep their winding and first vertex.
+std::vector<GLuint> OptimizeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount);
+// Reorders a cache-optimized list to reduce overdraw: the list is cut into clusters where the cache
+// would restart anyway, or where a cut keeps the ACMR within threshold times the input's, and the
+// clusters are sorted so those facing away from the mesh center, which tend to occlude the rest, are
+// drawn first.
+std::vector<GLuint> OptimizeOverdraw(const std::vector<GLuint>& indices, const std::vector<Vertex>& vertices,
+                                     float threshold = 1.05f);
+// Renumbers vertices in order of first use, so vertex fetch walks the buffer forwards
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+// Runs the three passes above in order
+void OptimizeMesh(IndexedGeometry& geometry);
+
+// Smallest index type that addresses a number of vertices: GL_UNSIGNED_SHORT up to 65536, else GL_UNSIGNED_INT
+GLenum GetIndexType(size_t vertexCount);
+// Bytes per index of GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+size_t GetIndexSize(GLenum indexType);
+// Copies indices into 16 bits; every index must be below 65536
+std::vector<uint16_t> NarrowIndices(const std::vector<GLuint>& indices);
+}}
+
+#endif
@@ -0,0 +1,113 @@
+#include "offscreencontext.hpp"
+#include <GLFW/glfw3.h>
+
+#ifdef ENGINE_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+Engine::Graphics::OffscreenContext::OffscreenContext(int major, int minor)
+    : display(nullptr), context(nullptr), window(nullptr), backend("none")
+{
+    if (createEGL(major, minor))
+        backend = "egl-surfaceless";
+    else if (createGLFW(major, minor))
+        backend = "glfw-hidden";
+}
+
+bool Engine::Graphics::OffscreenContext::createEGL(int major, int minor)
+{
+#ifdef ENGINE_HAS_EGL
+    // Prefer Mesa's surfaceless platform, which needs neither X11 nor Wayland
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != nullptr)
+        eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (eglDisplay == EGL_NO_DISPLAY)
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint eglMajor, eglMinor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor))
+        return false;
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        eglTerminate(eglDisplay);
+        return false;
+    }
+
+    // EGL_KHR_no_config_context lets the context be created without any surface configuration
+    const EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext eglContext = eglCreateContext(eglDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+    {
+        if (eglContext != EGL_NO_CONTEXT)
+            eglDestroyContext(eglDisplay, eglContext);
+        eglTerminate(eglDisplay);
+        return false;
+    }
+
+    display = eglDisplay;
+    context = eglContext;
+    return true;
+#else
+    (void)major;
+    (void)minor;
+    return false;
+#endif
+}
+
+bool Engine::Graphics::OffscreenContext::createGLFW(int major, int minor)
+{
+    if (!glfwInit())
+        return false;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    window = glfwCreateWindow(64, 64, "OpenGL", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    return true;
+}
+
+bool Engine::Graphics::OffscreenContext::IsValid() const
+{
+    return context != nullptr || window != nullptr;
+}
+
+const char* Engine::Graphics::OffscreenContext::GetBackend() const
+{
+    return backend;
+}
+
+void Engine::Graphics::OffscreenContext::Delete()
+{
+#ifdef ENGINE_HAS_EGL
+    if (context != nullptr)
+    {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+    }
+#endif
+    if (window != nullptr)
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    display = context = nullptr;
+    window = nullptr;
+    backend = "none";
+}
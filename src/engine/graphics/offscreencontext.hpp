@@ -0,0 +1,37 @@
+#ifndef ENGINE_GRAPHICS_OFFSCREENCONTEXT_HPP
+#define ENGINE_GRAPHICS_OFFSCREENCONTEXT_HPP
+
+struct GLFWwindow;
+
+namespace Engine{
+namespace Graphics{
+
+// OpenGL core profile context without a visible window, for benchmarks and CI.
+// Uses an EGL surfaceless context when built with ENGINE_HAS_EGL (works on Mesa llvmpipe without
+// a display server), otherwise an invisible GLFW window. Render into an FBO, there is no default framebuffer.
+class OffscreenContext
+{
+public:
+    // Creates the context and makes it current on the calling thread
+    OffscreenContext(int major = 3, int minor = 3);
+
+    // Returns true if a context was created
+    bool IsValid() const;
+    // Name of the backend that created the context ("egl-surfaceless", "glfw-hidden" or "none")
+    const char* GetBackend() const;
+    // Releases and destroys the context
+    void Delete();
+
+private:
+    bool createEGL(int major, int minor);
+    bool createGLFW(int major, int minor);
+
+    // EGLDisplay and EGLContext, kept opaque so EGL headers stay out of this header
+    void* display;
+    void* context;
+    GLFWwindow* window;
+    const char* backend;
+};
+}}
+
+#endif
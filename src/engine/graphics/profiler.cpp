@@ -0,0 +1,262 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+
+typedef std::chrono::steady_clock ProfileClock;
+
+// Queries 0 and 1 time the whole frame, each GPU scope takes the next two
+static const int QUERIES_PER_FRAME = 2 + 2 * Engine::Graphics::Profiler::MAX_SAMPLES;
+
+struct FrameSlot
+{
+    Engine::Graphics::ProfileFrame frame;
+    GLuint queries[QUERIES_PER_FRAME];
+    int usedQueries = 0;
+    // Offset from GPU timestamps to the trace clock, when the frame is traced
+    bool traced = false;
+    int64_t gpuToTrace = 0;
+    // Recorded and waiting for its GPU results
+    bool pending = false;
+};
+
+static bool profilerEnabled = false;
+static bool frameActive = false;
+static bool queriesCreated = false;
+static uint64_t frameNumber = 0;
+static uint64_t droppedFrames = 0;
+static ProfileClock::time_point frameStart;
+
+static FrameSlot slots[Engine::Graphics::Profiler::FRAME_LATENCY];
+static FrameSlot* currentSlot = nullptr;
+static int openScopes[Engine::Graphics::Profiler::MAX_DEPTH];
+static int openCount = 0;
+
+static Engine::Graphics::ProfileFrame lastFrame;
+static float cpuHistory[Engine::Graphics::Profiler::HISTORY];
+static float gpuHistory[Engine::Graphics::Profiler::HISTORY];
+static int historyNext = 0;
+static int historyCount = 0;
+
+static float millisecondsSinceFrameStart(ProfileClock::time_point time)
+{
+    return std::chrono::duration<float, std::milli>(time - frameStart).count();
+}
+
+// Reads back a frame recorded FRAME_LATENCY frames ago, or drops it if the GPU hasn't caught up
+static void collect(FrameSlot& slot)
+{
+    slot.pending = false;
+
+    // The frame's last query resolves after all the others
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        droppedFrames++;
+        return;
+    }
+
+    GLuint64 frameBegin = 0, frameEnd = 0;
+    glGetQueryObjectui64v(slot.queries[0], GL_QUERY_RESULT, &frameBegin);
+    glGetQueryObjectui64v(slot.queries[1], GL_QUERY_RESULT, &frameEnd);
+    slot.frame.gpuTime = (frameEnd - frameBegin) / 1e6f;
+
+    for (Engine::Graphics::ProfileSample& sample : slot.frame.samples)
+    {
+        if (sample.query < 0)
+            continue;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(slot.queries[sample.query], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(slot.queries[sample.query + 1], GL_QUERY_RESULT, &end);
+        sample.gpuStart = (GLint64)(begin - frameBegin) / 1e6f;
+        sample.gpuTime = (GLint64)(end - begin) / 1e6f;
+        if (slot.traced)
+            Engine::Core::TraceRecorder::AddGpuEvent(sample.name, begin + slot.gpuToTrace, end + slot.gpuToTrace);
+    }
+    if (slot.traced)
+        Engine::Core::TraceRecorder::AddGpuEvent("Frame", frameBegin + slot.gpuToTrace, frameEnd + slot.gpuToTrace);
+
+    // Copy into storage that keeps its capacity, so steady frames don't allocate
+    lastFrame.samples.assign(slot.frame.samples.begin(), slot.frame.samples.end());
+    lastFrame.cpuTime = slot.frame.cpuTime;
+    lastFrame.gpuTime = slot.frame.gpuTime;
+    lastFrame.number = slot.frame.number;
+
+    cpuHistory[historyNext] = lastFrame.cpuTime;
+    gpuHistory[historyNext] = lastFrame.gpuTime;
+    historyNext = (historyNext + 1) % Engine::Graphics::Profiler::HISTORY;
+    historyCount = std::min(historyCount + 1, Engine::Graphics::Profiler::HISTORY);
+}
+
+void Engine::Graphics::Profiler::SetEnabled(bool enabled)
+{
+    profilerEnabled = enabled;
+}
+
+bool Engine::Graphics::Profiler::IsEnabled()
+{
+    return profilerEnabled;
+}
+
+void Engine::Graphics::Profiler::BeginFrame()
+{
+    frameActive = false;
+    if (!profilerEnabled)
+        return;
+
+    if (!queriesCreated)
+    {
+        for (FrameSlot& slot : slots)
+        {
+            glGenQueries(QUERIES_PER_FRAME, slot.queries);
+            slot.frame.samples.reserve(MAX_SAMPLES);
+        }
+        lastFrame.samples.reserve(MAX_SAMPLES);
+        queriesCreated = true;
+    }
+
+    FrameSlot& slot = slots[frameNumber % FRAME_LATENCY];
+    if (slot.pending)
+        collect(slot);
+
+    slot.frame.samples.clear();
+    slot.frame.number = frameNumber;
+    slot.usedQueries = 2;
+    currentSlot = &slot;
+    openCount = 0;
+    frameActive = true;
+
+    // The current GPU time (not waiting for queued work) against the trace clock aligns the GPU track
+    slot.traced = Engine::Core::TraceRecorder::IsEnabled();
+    if (slot.traced)
+    {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        slot.gpuToTrace = (int64_t)Engine::Core::TraceRecorder::Now() - gpuNow;
+    }
+
+    glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+    frameStart = ProfileClock::now();
+}
+
+void Engine::Graphics::Profiler::EndFrame()
+{
+    if (!frameActive)
+        return;
+
+    currentSlot->frame.cpuTime = millisecondsSinceFrameStart(ProfileClock::now());
+    glQueryCounter(currentSlot->queries[1], GL_TIMESTAMP);
+    currentSlot->pending = true;
+    currentSlot = nullptr;
+    frameActive = false;
+    frameNumber++;
+}
+
+int Engine::Graphics::Profiler::BeginScope(const char* name, bool gpu)
+{
+    if (!frameActive || openCount == MAX_DEPTH || currentSlot->frame.samples.size() == MAX_SAMPLES)
+        return -1;
+
+    ProfileSample sample;
+    sample.name = name;
+    sample.depth = openCount;
+    sample.cpuStart = millisecondsSinceFrameStart(ProfileClock::now());
+    sample.cpuTime = 0.0f;
+    sample.gpuStart = -1.0f;
+    sample.gpuTime = -1.0f;
+    sample.query = -1;
+    if (gpu)
+    {
+        sample.query = currentSlot->usedQueries;
+        currentSlot->usedQueries += 2;
+        glQueryCounter(currentSlot->queries[sample.query], GL_TIMESTAMP);
+    }
+
+    int index = (int)currentSlot->frame.samples.size();
+    currentSlot->frame.samples.push_back(sample);
+    openScopes[openCount++] = index;
+    return index;
+}
+
+void Engine::Graphics::Profiler::EndScope(int index)
+{
+    if (index < 0 || !frameActive || (size_t)index >= currentSlot->frame.samples.size())
+        return;
+
+    ProfileSample& sample = currentSlot->frame.samples[index];
+    sample.cpuTime = millisecondsSinceFrameStart(ProfileClock::now()) - sample.cpuStart;
+    if (sample.query >= 0)
+        glQueryCounter(currentSlot->queries[sample.query + 1], GL_TIMESTAMP);
+
+    // Scopes close in reverse order; anything still open inside this one is closed with it
+    while (openCount > 0 && openScopes[openCount - 1] >= index)
+        openCount--;
+}
+
+const Engine::Graphics::ProfileFrame& Engine::Graphics::Profiler::GetLastFrame()
+{
+    return lastFrame;
+}
+
+const float* Engine::Graphics::Profiler::GetCpuHistory()
+{
+    return cpuHistory;
+}
+
+const float* Engine::Graphics::Profiler::GetGpuHistory()
+{
+    return gpuHistory;
+}
+
+int Engine::Graphics::Profiler::GetHistoryOffset()
+{
+    return historyCount < HISTORY ? 0 : historyNext;
+}
+
+int Engine::Graphics::Profiler::GetHistoryCount()
+{
+    return historyCount;
+}
+
+Engine::Graphics::ProfileSummary Engine::Graphics::Profiler::Summarize(const float* history)
+{
+    ProfileSummary summary;
+    if (historyCount == 0)
+        return summary;
+
+    // Before the history wraps the values start at index 0, so the first historyCount are the valid ones
+    float sorted[HISTORY];
+    std::copy(history, history + historyCount, sorted);
+    std::sort(sorted, sorted + historyCount);
+
+    float sum = 0.0f;
+    for (int i = 0; i < historyCount; i++)
+        sum += sorted[i];
+    auto percentile = [&](float p) { return sorted[std::min(historyCount - 1, (int)(p * historyCount))]; };
+
+    summary.mean = sum / historyCount;
+    summary.p50 = percentile(0.50f);
+    summary.p95 = percentile(0.95f);
+    summary.p99 = percentile(0.99f);
+    summary.max = sorted[historyCount - 1];
+    return summary;
+}
+
+uint64_t Engine::Graphics::Profiler::GetDroppedFrames()
+{
+    return droppedFrames;
+}
+
+void Engine::Graphics::Profiler::Delete()
+{
+    if (queriesCreated)
+    {
+        for (FrameSlot& slot : slots)
+        {
+            glDeleteQueries(QUERIES_PER_FRAME, slot.queries);
+            slot.pending = false;
+        }
+        queriesCreated = false;
+    }
+    frameActive = false;
+}
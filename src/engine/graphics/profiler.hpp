@@ -0,0 +1,117 @@
+#ifndef ENGINE_GRAPHICS_PROFILER_HPP
+#define ENGINE_GRAPHICS_PROFILER_HPP
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../core/trace.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// One timed scope of a frame. Times are in milliseconds since the frame began; the GPU ones are
+// negative if the scope had no GPU timer.
+struct ProfileSample
+{
+    const char* name;
+    int depth;
+    float cpuStart, cpuTime;
+    float gpuStart, gpuTime;
+    // First of the two timestamp queries of the scope, -1 for CPU only scopes
+    int query;
+};
+
+// All scopes of one frame in the order they began, parents before their children
+struct ProfileFrame
+{
+    std::vector<ProfileSample> samples;
+    float cpuTime = 0.0f;
+    float gpuTime = 0.0f;
+    uint64_t number = 0;
+};
+
+// Distribution of the frame times in the history
+struct ProfileSummary
+{
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+// Hierarchical frame profiler. CPU scopes read a steady clock; GPU scopes record GL_TIMESTAMP queries
+// at their start and end, which (unlike GL_TIME_ELAPSED queries) may nest. Every frame has its own set
+// of queries in a ring of FRAME_LATENCY frames, and a frame's results are only read back when its slot
+// comes around again, so the profiler never waits for the GPU; a frame whose queries are still pending
+// then is dropped. While the TraceRecorder is on, scopes are also recorded as trace events, and GPU
+// times are added to its GPU track once read back. Use through the ENGINE_PROFILE_SCOPE macros, which
+// compile out unless ENGINE_PROFILING is defined. Render thread only.
+class Profiler
+{
+public:
+    static const int FRAME_LATENCY = 4;
+    static const int MAX_SAMPLES = 256;
+    static const int MAX_DEPTH = 32;
+    static const int HISTORY = 240;
+
+    // Profiling is off until enabled; disabled frames record nothing
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    // Brackets one frame; scopes outside a frame are ignored
+    static void BeginFrame();
+    static void EndFrame();
+
+    // Opens a scope and returns its index for EndScope (-1 if nothing is recorded)
+    static int BeginScope(const char* name, bool gpu);
+    static void EndScope(int index);
+
+    // Latest frame whose results have been read back
+    static const ProfileFrame& GetLastFrame();
+    // Frame times of the last HISTORY frames read back, oldest first starting at GetHistoryOffset()
+    static const float* GetCpuHistory();
+    static const float* GetGpuHistory();
+    static int GetHistoryOffset();
+    static int GetHistoryCount();
+    static ProfileSummary Summarize(const float* history);
+    // Frames dropped because their GPU results were not ready in time
+    static uint64_t GetDroppedFrames();
+
+    // Deletes the timer queries
+    static void Delete();
+};
+
+// Times the enclosing block
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name, bool gpu = false) : trace(name), index(Profiler::BeginScope(name, gpu)) {}
+    ~ProfileScope() { Profiler::EndScope(index); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    // Declared first so the trace event encloses the profiler's timing
+    Core::TraceScope trace;
+    int index;
+};
+}}
+
+#define ENGINE_PROFILE_CONCAT_INNER(a, b) a##b
+#define ENGINE_PROFILE_CONCAT(a, b) ENGINE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENGINE_PROFILING
+// Times the rest of the enclosing block on the CPU
+#define ENGINE_PROFILE_SCOPE(name) Engine::Graphics::ProfileScope ENGINE_PROFILE_CONCAT(profileScope, __LINE__)(name)
+// Times the rest of the enclosing block on the CPU and the GPU
+#define ENGINE_PROFILE_GPU_SCOPE(name) Engine::Graphics::ProfileScope ENGINE_PROFILE_CONCAT(profileScope, __LINE__)(name, true)
+#else
+#define ENGINE_PROFILE_SCOPE(name) ((void)0)
+#define ENGINE_PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,168 @@
+#include "programcache.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <vector>
+
+// File layout: magic, key, binary format, binary length, binary
+static const char CACHE_MAGIC[8] = {'G', 'L', 'P', 'R', 'O', 'G', '0', '1'};
+
+static std::string cacheDirectory;
+static unsigned int cacheHits = 0;
+static unsigned int cacheMisses = 0;
+
+// 64-bit FNV-1a over several strings, each followed by a separator so ("ab", "c") != ("a", "bc")
+static uint64_t hashStrings(uint64_t hash, std::initializer_list<const std::string*> strings)
+{
+    for (const std::string* text : strings)
+    {
+        for (unsigned char c : *text)
+            hash = (hash ^ c) * 0x100000001b3ull;
+        hash = (hash ^ 0xff) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static std::string glString(GLenum name)
+{
+    const GLubyte* value = glGetString(name);
+    return value != nullptr ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+}
+
+void Engine::Graphics::ProgramCache::SetDirectory(const std::string& directory)
+{
+    cacheDirectory = directory;
+    if (!cacheDirectory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(cacheDirectory, error);
+    }
+}
+
+const std::string& Engine::Graphics::ProgramCache::GetDirectory()
+{
+    return cacheDirectory;
+}
+
+bool Engine::Graphics::ProgramCache::IsEnabled()
+{
+    if (cacheDirectory.empty() || !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+        return false;
+
+    // Some drivers expose the entry points without any binary format
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+std::string Engine::Graphics::ProgramCache::Key(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    std::string vendor = glString(GL_VENDOR);
+    std::string renderer = glString(GL_RENDERER);
+    std::string version = glString(GL_VERSION);
+
+    // Two hashes with different seeds: the first names the file, both are checked on load
+    uint64_t hashes[2] = {
+        hashStrings(0xcbf29ce484222325ull, {&vertexSource, &fragmentSource, &vendor, &renderer, &version}),
+        hashStrings(0x84222325cbf29ce4ull, {&vertexSource, &fragmentSource, &vendor, &renderer, &version})
+    };
+
+    char key[34];
+    std::snprintf(key, sizeof(key), "%016llx-%016llx", (unsigned long long)hashes[0], (unsigned long long)hashes[1]);
+    return key;
+}
+
+std::string Engine::Graphics::ProgramCache::path(const std::string& key)
+{
+    return cacheDirectory + "/" + key.substr(0, 16) + ".bin";
+}
+
+GLuint Engine::Graphics::ProgramCache::Load(const std::string& key)
+{
+    std::ifstream file(path(key), std::ios::binary);
+    std::vector<char> contents;
+    if (file)
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    // Header: magic, key, format, length
+    size_t headerSize = sizeof(CACHE_MAGIC) + key.size() + 2 * sizeof(uint32_t);
+    uint32_t format = 0, length = 0;
+    bool valid = contents.size() >= headerSize
+                 && std::memcmp(contents.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0
+                 && std::memcmp(contents.data() + sizeof(CACHE_MAGIC), key.data(), key.size()) == 0;
+    if (valid)
+    {
+        std::memcpy(&format, contents.data() + sizeof(CACHE_MAGIC) + key.size(), sizeof(format));
+        std::memcpy(&length, contents.data() + sizeof(CACHE_MAGIC) + key.size() + sizeof(format), sizeof(length));
+        valid = contents.size() == headerSize + length;
+    }
+    if (!valid)
+    {
+        cacheMisses++;
+        return 0;
+    }
+
+    // The driver may still reject a binary, e.g. after an update that kept the version string
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, contents.data() + headerSize, length);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        glDeleteProgram(program);
+        cacheMisses++;
+        return 0;
+    }
+
+    cacheHits++;
+    return program;
+}
+
+void Engine::Graphics::ProgramCache::Store(const std::string& key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    // Write to a temporary file and rename it, so a crash never leaves a truncated entry behind
+    std::string target = path(key);
+    std::string temporary = target + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        uint32_t format32 = format;
+        uint32_t length32 = (uint32_t)length;
+        file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        file.write(key.data(), key.size());
+        file.write(reinterpret_cast<const char*>(&format32), sizeof(format32));
+        file.write(reinterpret_cast<const char*>(&length32), sizeof(length32));
+        file.write(binary.data(), length);
+        if (!file)
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error)
+        std::filesystem::remove(temporary, error);
+}
+
+unsigned int Engine::Graphics::ProgramCache::GetHits()
+{
+    return cacheHits;
+}
+
+unsigned int Engine::Graphics::ProgramCache::GetMisses()
+{
+    return cacheMisses;
+}
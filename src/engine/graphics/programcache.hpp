@@ -0,0 +1,39 @@
+#ifndef ENGINE_GRAPHICS_PROGRAMCACHE_HPP
+#define ENGINE_GRAPHICS_PROGRAMCACHE_HPP
+
+#include <GL/glew.h>
+#include <string>
+
+namespace Engine{
+namespace Graphics{
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary), so shader variants
+// are only compiled from source the first time they are used on a given driver.
+// Entries are keyed by a hash of the final sources (defines included) and the GL vendor, renderer
+// and version strings; a binary the driver rejects is treated as a miss and overwritten.
+class ProgramCache
+{
+public:
+    // Enables the cache in a directory, created if missing. An empty path disables it (the default).
+    static void SetDirectory(const std::string& directory);
+    static const std::string& GetDirectory();
+    // True if a directory is set and the driver supports at least one program binary format
+    static bool IsEnabled();
+
+    // Cache key of a program built from the given sources on the current driver
+    static std::string Key(const std::string& vertexSource, const std::string& fragmentSource);
+    // Creates a linked program from a cached binary, or returns 0 if there is no usable entry
+    static GLuint Load(const std::string& key);
+    // Stores the binary of a linked program (created with GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+    static void Store(const std::string& key, GLuint program);
+
+    // Loads served from the cache and programs compiled from source since startup
+    static unsigned int GetHits();
+    static unsigned int GetMisses();
+
+private:
+    static std::string path(const std::string& key);
+};
+}}
+
+#endif
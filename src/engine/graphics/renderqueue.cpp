@@ -0,0 +1,130 @@
+#include "renderqueue.hpp"
+#include <algorithm>
+
+static const int PASS_SHIFT = 60;
+static const int SHADER_SHIFT = 52;
+static const int TEXTURE_SHIFT = 40;
+static const int MESH_SHIFT = 28;
+static const int DEPTH_SHIFT = 4;
+static const uint32_t SHADER_MASK = 0xFF;
+static const uint32_t TEXTURE_MASK = 0xFFF;
+static const uint32_t MESH_MASK = 0xFFF;
+static const uint32_t DEPTH_MAX = 0xFFFFFF;
+
+// Number of an object within the frame, assigning the next one on first use. Frames use a handful of
+// shaders and meshes, so a linear search starting at the last match beats hashing.
+static uint32_t numberOf(std::vector<const void*>& seen, const void* object)
+{
+    if (!seen.empty() && seen.back() == object)
+        return (uint32_t)seen.size() - 1;
+    for (size_t i = 0; i < seen.size(); i++)
+    {
+        if (seen[i] == object)
+            return (uint32_t)i;
+    }
+    seen.push_back(object);
+    return (uint32_t)seen.size() - 1;
+}
+
+Engine::Graphics::RenderQueue::RenderQueue() : view(1.0f), farPlane(1.0f)
+{
+}
+
+void Engine::Graphics::RenderQueue::Begin(const glm::mat4& view, float farPlane)
+{
+    this->view = view;
+    this->farPlane = farPlane;
+    commands.clear();
+    entries.clear();
+    shaders.clear();
+    textures.clear();
+    meshes.clear();
+}
+
+void Engine::Graphics::RenderQueue::Push(RenderPass pass, const DrawCommand& command)
+{
+    // The translation column places the mesh origin; view space looks down -z
+    glm::vec3 position(command.model[3]);
+    float distance = -(view[0][2] * position.x + view[1][2] * position.y + view[2][2] * position.z + view[3][2]);
+    float depth = glm::clamp(distance / farPlane, 0.0f, 1.0f);
+    uint64_t depthBits = (uint64_t)(depth * DEPTH_MAX);
+    if (pass == RenderPass::Transparent)
+        depthBits = DEPTH_MAX - depthBits;
+
+    uint64_t key = (uint64_t)pass << PASS_SHIFT
+                   | (uint64_t)(numberOf(shaders, command.shader) & SHADER_MASK) << SHADER_SHIFT
+                   | (uint64_t)(numberOf(textures, command.mesh->GetTexture()) & TEXTURE_MASK) << TEXTURE_SHIFT
+                   | (uint64_t)(numberOf(meshes, command.mesh) & MESH_MASK) << MESH_SHIFT
+                   | depthBits << DEPTH_SHIFT;
+
+    entries.push_back(SortEntry{key, (uint32_t)commands.size()});
+    commands.push_back(command);
+}
+
+void Engine::Graphics::RenderQueue::Sort()
+{
+    sorted.resize(entries.size());
+    // One counting pass per byte, stable, so each pass keeps the order of the less significant ones.
+    // Bytes where every key agrees (e.g. the pass when there is only one) are skipped.
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {};
+        for (const SortEntry& entry : entries)
+            counts[(entry.key >> shift) & 0xFF]++;
+        if (entries.empty() || counts[(entries[0].key >> shift) & 0xFF] == entries.size())
+            continue;
+
+        size_t offsets[256];
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            offsets[digit] = offset;
+            offset += counts[digit];
+        }
+        for (const SortEntry& entry : entries)
+            sorted[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+        entries.swap(sorted);
+    }
+}
+
+void Engine::Graphics::RenderQueue::Submit()
+{
+    Shader* shader = nullptr;
+    Texture* texture = nullptr;
+    Mesh* mesh = nullptr;
+    for (const SortEntry& entry : entries)
+    {
+        const DrawCommand& command = commands[entry.command];
+        bool shaderChanged = command.shader != shader;
+        if (shaderChanged)
+        {
+            shader = command.shader;
+            shader->Activate();
+        }
+        // Quantized meshes decode their positions with uniforms of the program
+        if (shaderChanged || command.mesh != mesh)
+            command.mesh->SetDecodeUniforms(*shader);
+        if (command.mesh != mesh)
+        {
+            mesh = command.mesh;
+            Texture* meshTexture = mesh->GetTexture();
+            if (meshTexture != nullptr && meshTexture != texture)
+            {
+                texture = meshTexture;
+                // The diffuse map's unit, whichever unit was left active
+                texture->Bind(0);
+            }
+            mesh->BindVertexArray();
+        }
+        shader->setMat4(command.modelUniform, command.model);
+        if (command.meshlets != nullptr)
+            mesh->DrawMeshletsBound(command.meshlets, command.meshletCount);
+        else
+            mesh->DrawBound(command.lod);
+    }
+}
+
+size_t Engine::Graphics::RenderQueue::GetCommandCount() const
+{
+    return commands.size();
+}
@@ -0,0 +1,84 @@
+#ifndef ENGINE_GRAPHICS_RENDERQUEUE_HPP
+#define ENGINE_GRAPHICS_RENDERQUEUE_HPP
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Passes in submission order. Opaque draws go front to back so early depth testing rejects hidden
+// fragments, transparent ones back to front so they blend correctly.
+enum class RenderPass : uint8_t
+{
+    Opaque = 0,
+    Transparent = 1
+};
+
+// One draw of a mesh with a model matrix
+struct DrawCommand
+{
+    Shader* shader;
+    Uniform modelUniform;
+    Mesh* mesh;
+    glm::mat4 model;
+    // Level of detail to draw (e.g. from Mesh::SelectLod)
+    uint32_t lod = 0;
+    // Meshlets of the full detail level to draw instead of a level, if any (e.g. from CullMeshlets); the
+    // list must stay alive until Submit
+    const uint32_t* meshlets = nullptr;
+    uint32_t meshletCount = 0;
+};
+
+// Collects the draws of a frame and submits them grouped by state instead of in code order. Every draw
+// gets a 64-bit key, from the most significant bits down:
+//   pass (4) | shader (8) | texture (12) | mesh (12) | depth (24) | unused (4)
+// so sorting the keys groups draws by shader, then texture, then mesh, and orders each group by depth.
+// Shaders, textures and meshes are numbered in order of first use each frame; past 255 shaders or 4095
+// textures or meshes the numbers wrap, which only costs extra state changes. Submit binds a shader,
+// texture or vertex array only when it differs from the previous draw's. Storage keeps its capacity
+// across frames, so steady frames don't allocate.
+class RenderQueue
+{
+public:
+    RenderQueue();
+
+    // Starts a frame; depth is the view space distance, clamped to farPlane
+    void Begin(const glm::mat4& view, float farPlane);
+    void Push(RenderPass pass, const DrawCommand& command);
+    // Orders the commands by key with a least significant digit radix sort
+    void Sort();
+    // Draws the commands in sorted order; the uniforms other than the model matrix must already be set
+    void Submit();
+
+    size_t GetCommandCount() const;
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t command;
+    };
+
+    glm::mat4 view;
+    float farPlane;
+
+    std::vector<DrawCommand> commands;
+    std::vector<SortEntry> entries;
+    // Scratch buffer of the radix sort
+    std::vector<SortEntry> sorted;
+
+    // Objects seen this frame, indexed by their number in the key
+    std::vector<const void*> shaders;
+    std::vector<const void*> textures;
+    std::vector<const void*> meshes;
+};
+}}
+
+#endif
@@ -0,0 +1,23 @@
+#include "renderstats.hpp"
+
+static Engine::Graphics::RenderStats currentStats;
+
+unsigned int Engine::Graphics::RenderStats::StateChanges() const
+{
+    return programBinds + textureBinds + vertexArrayBinds + bufferBinds + bufferUploads + uniformUploads;
+}
+
+unsigned int Engine::Graphics::RenderStats::Binds() const
+{
+    return programBinds + textureBinds + vertexArrayBinds + bufferBinds;
+}
+
+Engine::Graphics::RenderStats& Engine::Graphics::RenderStats::Current()
+{
+    return currentStats;
+}
+
+void Engine::Graphics::RenderStats::Reset()
+{
+    currentStats = RenderStats();
+}
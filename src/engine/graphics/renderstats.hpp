@@ -0,0 +1,32 @@
+#ifndef ENGINE_GRAPHICS_RENDERSTATS_HPP
+#define ENGINE_GRAPHICS_RENDERSTATS_HPP
+
+namespace Engine{
+namespace Graphics{
+
+// Draw calls and GL state changes issued by the engine wrappers since the last Reset
+struct RenderStats
+{
+    unsigned int drawCalls = 0;
+    unsigned int programBinds = 0;
+    unsigned int textureBinds = 0;
+    unsigned int vertexArrayBinds = 0;
+    unsigned int bufferBinds = 0;
+    unsigned int bufferUploads = 0;
+    unsigned int uniformUploads = 0;
+    // Binds GLState dropped because the object was already bound; not GL calls, so not state changes
+    unsigned int skippedBinds = 0;
+
+    // Sum of every counter except draw calls and skipped binds
+    unsigned int StateChanges() const;
+    // Program, texture, vertex array and buffer binds issued
+    unsigned int Binds() const;
+
+    // Counters of the frame being recorded (GL calls are only made from the render thread)
+    static RenderStats& Current();
+    // Starts a new frame
+    static void Reset();
+};
+}}
+
+#endif
@@ -1,9 +1,13 @@
 #include "shader.hpp"
+#include "glstate.hpp"
+#include "programcache.hpp"
+#include "renderstats.hpp"
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-Engine::Graphics::Shader::Shader(const char* vertexPath, const char* fragmentPath)
+Engine::Graphics::Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines)
 {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -31,107 +35,336 @@ Engine::Graphics::Shader::Shader(const char* vertexPath, const char* fragmentPat
         fShaderFile.close();
 
         // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        vertexCode = injectDefines(vShaderStream.str(), defines);
+        fragmentCode = injectDefines(fShaderStream.str(), defines);
     }
     catch (std::ifstream::failure& e)
     {
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
     }
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    // 2. reuse the binary of an earlier run when the sources and the driver are unchanged, or compile
+    const Stage stages[2] = {{GL_VERTEX_SHADER, "VERTEX", &vertexCode},
+                             {GL_FRAGMENT_SHADER, "FRAGMENT", &fragmentCode}};
+    buildProgram(stages, 2);
+}
 
-    // 2. compile shaders
-    unsigned int vertex, fragment;
+Engine::Graphics::Shader::Shader()
+    : ID(0)
+{
+}
 
-    // vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
+Engine::Graphics::Shader Engine::Graphics::Shader::Compute(const char* computePath, const std::vector<std::string>& defines)
+{
+    Shader shader;
+    std::string computeCode = injectDefines(readSource(computePath), defines);
 
-    // fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+    const Stage stage = {GL_COMPUTE_SHADER, "COMPUTE", &computeCode};
+    shader.buildProgram(&stage, 1);
+    return shader;
+}
+
+void Engine::Graphics::Shader::buildProgram(const Stage* stages, size_t count)
+{
+    // Keyed by the vertex and fragment sources; a compute program has no fragment stage, so its key
+    // can't match a vertex/fragment pair
+    std::string cacheKey;
+    ID = 0;
+    if (ProgramCache::IsEnabled())
+    {
+        cacheKey = ProgramCache::Key(*stages[0].source, count > 1 ? *stages[1].source : std::string());
+        ID = ProgramCache::Load(cacheKey);
+    }
+    if (ID != 0)
+    {
+        cacheUniforms();
+        return;
+    }
+
+    std::vector<GLuint> shaders(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const char* code = stages[i].source->c_str();
+        shaders[i] = glCreateShader(stages[i].type);
+        glShaderSource(shaders[i], 1, &code, NULL);
+        glCompileShader(shaders[i]);
+        checkCompileErrors(shaders[i], stages[i].name);
+    }
 
-    // shader Program
     ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    for (size_t i = 0; i < count; i++)
+        glAttachShader(ID, shaders[i]);
+    if (!cacheKey.empty())
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
+    cacheUniforms();
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    if (!cacheKey.empty() && linked)
+        ProgramCache::Store(cacheKey, ID);
+
+    // The stages are linked into the program now and no longer necessary
+    for (size_t i = 0; i < count; i++)
+        glDeleteShader(shaders[i]);
+}
+
+std::string Engine::Graphics::Shader::readSource(const char* path)
+{
+    std::ifstream file;
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try
+    {
+        file.open(path);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        file.close();
+        return stream.str();
+    }
+    catch (std::ifstream::failure& e)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+    }
+    return std::string();
+}
+
+std::string Engine::Graphics::Shader::injectDefines(const std::string& source, const std::vector<std::string>& defines)
+{
+    if (defines.empty())
+        return source;
 
-    // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    std::string block;
+    for (const std::string& define : defines)
+        block += "#define " + define + "\n";
+
+    // #version has to stay the first statement, so defines go right after it
+    size_t version = source.find("#version");
+    if (version == std::string::npos)
+        return block + source;
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return source + "\n" + block;
+    return source.substr(0, lineEnd + 1) + block + source.substr(lineEnd + 1);
 }
 
 void Engine::Graphics::Shader::use() const
 {
-    glUseProgram(ID);
+    GLState::UseProgram(ID);
 }
 
-void Engine::Graphics::Shader::setBool(const std::string &name, bool value) const
+void Engine::Graphics::Shader::setBool(std::string_view name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    setBool(getUniform(name), value);
 }
 
-void Engine::Graphics::Shader::setInt(const std::string &name, int value) const
+void Engine::Graphics::Shader::setInt(std::string_view name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    setInt(getUniform(name), value);
 }
 
-void Engine::Graphics::Shader::setFloat(const std::string &name, float value) const
+void Engine::Graphics::Shader::setFloat(std::string_view name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    setFloat(getUniform(name), value);
 }
 
-void Engine::Graphics::Shader::setVec2(const std::string &name, const glm::vec2 &value) const
+void Engine::Graphics::Shader::setVec2(std::string_view name, const glm::vec2 &value) const
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec2(getUniform(name), value);
 }
 
-void Engine::Graphics::Shader::setVec2(const std::string &name, float x, float y) const
+void Engine::Graphics::Shader::setVec2(std::string_view name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    setVec2(getUniform(name), glm::vec2(x, y));
 }
 
-void Engine::Graphics::Shader::setVec3(const std::string &name, const glm::vec3 &value) const
+void Engine::Graphics::Shader::setVec3(std::string_view name, const glm::vec3 &value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec3(getUniform(name), value);
 }
 
-void Engine::Graphics::Shader::setVec3(const std::string &name, float x, float y, float z) const
+void Engine::Graphics::Shader::setVec3(std::string_view name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    setVec3(getUniform(name), glm::vec3(x, y, z));
 }
 
-void Engine::Graphics::Shader::setVec4(const std::string &name, const glm::vec4 &value) const
+void Engine::Graphics::Shader::setVec4(std::string_view name, const glm::vec4 &value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec4(getUniform(name), value);
 }
 
-void Engine::Graphics::Shader::setVec4(const std::string &name, float x, float y, float z, float w) const
+void Engine::Graphics::Shader::setVec4(std::string_view name, float x, float y, float z, float w) const
 {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    setVec4(getUniform(name), glm::vec4(x, y, z, w));
 }
 
-void Engine::Graphics::Shader::setMat2(const std::string &name, const glm::mat2 &mat) const
+void Engine::Graphics::Shader::setMat2(std::string_view name, const glm::mat2 &mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat2(getUniform(name), mat);
 }
 
-void Engine::Graphics::Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
+void Engine::Graphics::Shader::setMat3(std::string_view name, const glm::mat3 &mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat3(getUniform(name), mat);
 }
 
-void Engine::Graphics::Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
+void Engine::Graphics::Shader::setMat4(std::string_view name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat4(getUniform(name), mat);
+}
+
+Engine::Graphics::Uniform Engine::Graphics::Shader::getUniform(std::string_view name) const
+{
+    const Uniform* uniform = uniforms.find(name);
+    return uniform ? *uniform : Uniform();
+}
+
+void Engine::Graphics::Shader::setBool(Uniform uniform, bool value) const
+{
+    int intValue = (int)value;
+    if (!updateShadow(uniform, &intValue, sizeof(intValue)))
+        return;
+    glUniform1i(uniform.location, intValue);
+}
+
+void Engine::Graphics::Shader::setInt(Uniform uniform, int value) const
+{
+    if (!updateShadow(uniform, &value, sizeof(value)))
+        return;
+    glUniform1i(uniform.location, value);
+}
+
+void Engine::Graphics::Shader::setFloat(Uniform uniform, float value) const
+{
+    if (!updateShadow(uniform, &value, sizeof(value)))
+        return;
+    glUniform1f(uniform.location, value);
+}
+
+void Engine::Graphics::Shader::setVec2(Uniform uniform, const glm::vec2 &value) const
+{
+    if (!updateShadow(uniform, &value[0], sizeof(value)))
+        return;
+    glUniform2fv(uniform.location, 1, &value[0]);
+}
+
+void Engine::Graphics::Shader::setVec3(Uniform uniform, const glm::vec3 &value) const
+{
+    if (!updateShadow(uniform, &value[0], sizeof(value)))
+        return;
+    glUniform3fv(uniform.location, 1, &value[0]);
+}
+
+void Engine::Graphics::Shader::setVec4(Uniform uniform, const glm::vec4 &value) const
+{
+    if (!updateShadow(uniform, &value[0], sizeof(value)))
+        return;
+    glUniform4fv(uniform.location, 1, &value[0]);
+}
+
+void Engine::Graphics::Shader::setMat2(Uniform uniform, const glm::mat2 &mat) const
+{
+    if (!updateShadow(uniform, &mat[0][0], sizeof(mat)))
+        return;
+    glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Engine::Graphics::Shader::setMat3(Uniform uniform, const glm::mat3 &mat) const
+{
+    if (!updateShadow(uniform, &mat[0][0], sizeof(mat)))
+        return;
+    glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Engine::Graphics::Shader::setMat4(Uniform uniform, const glm::mat4 &mat) const
+{
+    if (!updateShadow(uniform, &mat[0][0], sizeof(mat)))
+        return;
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Engine::Graphics::Shader::bindUniformBlock(const std::string &blockName, GLuint binding) const
+{
+    GLuint index = glGetUniformBlockIndex(ID, blockName.c_str());
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, index, binding);
+}
+
+Engine::Graphics::UniformStats Engine::Graphics::Shader::getUniformStats() const
+{
+    return stats;
+}
+
+void Engine::Graphics::Shader::resetUniformStats()
+{
+    stats = UniformStats();
+}
+
+bool Engine::Graphics::Shader::updateShadow(Uniform uniform, const void* data, size_t size) const
+{
+    // Unknown uniforms are ignored by the driver anyway
+    if (uniform.location < 0 || (size_t)uniform.location >= shadow.size())
+        return false;
+
+    ShadowValue& value = shadow[uniform.location];
+    if (value.valid && std::memcmp(value.data, data, size) == 0)
+    {
+        stats.skipped++;
+        return false;
+    }
+
+    std::memcpy(value.data, data, size);
+    value.valid = true;
+    stats.issued++;
+    RenderStats::Current().uniformUploads++;
+    return true;
+}
+
+void Engine::Graphics::Shader::cacheUniforms()
+{
+    uniforms.clear();
+    shadow.clear();
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(maxLength > 0 ? maxLength : 1, '\0');
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &size, &type, &name[0]);
+        std::string uniformName(name.c_str(), length);
+
+        // Uniforms living in a uniform block have no location
+        GLint location = glGetUniformLocation(ID, uniformName.c_str());
+        if (location < 0)
+            continue;
+
+        uniforms.insert(uniformName, Uniform{location, type});
+        if (shadow.size() <= (size_t)location)
+            shadow.resize(location + 1);
+
+        // Arrays are reported once as "name[0]": register the bare name and every element as well
+        const std::string suffix = "[0]";
+        if (uniformName.size() > suffix.size() &&
+            uniformName.compare(uniformName.size() - suffix.size(), suffix.size(), suffix) == 0)
+        {
+            std::string base = uniformName.substr(0, uniformName.size() - suffix.size());
+            uniforms.insert(base, Uniform{location, type});
+            for (GLint element = 1; element < size; element++)
+            {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                GLint elementLocation = glGetUniformLocation(ID, elementName.c_str());
+                uniforms.insert(elementName, Uniform{elementLocation, type});
+                if (shadow.size() <= (size_t)elementLocation)
+                    shadow.resize(elementLocation + 1);
+            }
+        }
+    }
 }
 
 void Engine::Graphics::Shader::checkCompileErrors(GLuint shader, std::string type)
@@ -165,11 +398,41 @@ void Engine::Graphics::Shader::checkCompileErrors(GLuint shader, std::string typ
 
 void Engine::Graphics::Shader::Activate()
 {
-	glUseProgram(ID);
+	GLState::UseProgram(ID);
 }
 
 // Deletes the Shader Program
 void Engine::Graphics::Shader::Delete()
 {
-	glDeleteProgram(ID);
+	if (ID != 0)
+	{
+		GLState::ForgetProgram(ID);
+		glDeleteProgram(ID);
+	}
+	ID = 0;
+}
+
+Engine::Graphics::Shader::~Shader()
+{
+	Delete();
+}
+
+Engine::Graphics::Shader::Shader(Shader&& other) noexcept
+    : ID(other.ID), uniforms(std::move(other.uniforms)), shadow(std::move(other.shadow)), stats(other.stats)
+{
+    other.ID = 0;
+}
+
+Engine::Graphics::Shader& Engine::Graphics::Shader::operator=(Shader&& other) noexcept
+{
+    if (this != &other)
+    {
+        Delete();
+        ID = other.ID;
+        uniforms = std::move(other.uniforms);
+        shadow = std::move(other.shadow);
+        stats = other.stats;
+        other.ID = 0;
+    }
+    return *this;
 }
@@ -5,34 +5,77 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "uniformtable.hpp"
 
 namespace Engine{
 namespace Graphics{
 
+// Number of uniform uploads sent to the driver vs. skipped because the value was unchanged
+struct UniformStats
+{
+    unsigned int issued = 0;
+    unsigned int skipped = 0;
+};
+
 class Shader
 {
 public:
     unsigned int ID;
 
-    // Constructor
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // Constructor, optionally compiling a variant with "#define" lines injected after the #version directive
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines = {});
+    // Holds no program until a compiled one is moved in
+    Shader();
+    // Compute program from a single source file (GL 4.3)
+    static Shader Compute(const char* computePath, const std::vector<std::string>& defines = {});
+    // Deletes the program if Delete was not called
+    ~Shader();
+    // Move-only: exactly one object owns the program
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+    Shader(Shader&& other) noexcept;
+    Shader& operator=(Shader&& other) noexcept;
 
     // Activate the shader
     void use() const;
 
     // Utility uniform functions
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, int value) const;
-    void setFloat(const std::string &name, float value) const;
-    void setVec2(const std::string &name, const glm::vec2 &value) const;
-    void setVec2(const std::string &name, float x, float y) const;
-    void setVec3(const std::string &name, const glm::vec3 &value) const;
-    void setVec3(const std::string &name, float x, float y, float z) const;
-    void setVec4(const std::string &name, const glm::vec4 &value) const;
-    void setVec4(const std::string &name, float x, float y, float z, float w) const;
-    void setMat2(const std::string &name, const glm::mat2 &mat) const;
-    void setMat3(const std::string &name, const glm::mat3 &mat) const;
-    void setMat4(const std::string &name, const glm::mat4 &mat) const;
+    void setBool(std::string_view name, bool value) const;
+    void setInt(std::string_view name, int value) const;
+    void setFloat(std::string_view name, float value) const;
+    void setVec2(std::string_view name, const glm::vec2 &value) const;
+    void setVec2(std::string_view name, float x, float y) const;
+    void setVec3(std::string_view name, const glm::vec3 &value) const;
+    void setVec3(std::string_view name, float x, float y, float z) const;
+    void setVec4(std::string_view name, const glm::vec4 &value) const;
+    void setVec4(std::string_view name, float x, float y, float z, float w) const;
+    void setMat2(std::string_view name, const glm::mat2 &mat) const;
+    void setMat3(std::string_view name, const glm::mat3 &mat) const;
+    void setMat4(std::string_view name, const glm::mat4 &mat) const;
+
+    // Returns the pre-resolved handle of an active uniform (invalid if the program has no such uniform)
+    Uniform getUniform(std::string_view name) const;
+
+    // Uniform functions taking a pre-resolved handle, for hot paths
+    void setBool(Uniform uniform, bool value) const;
+    void setInt(Uniform uniform, int value) const;
+    void setFloat(Uniform uniform, float value) const;
+    void setVec2(Uniform uniform, const glm::vec2 &value) const;
+    void setVec3(Uniform uniform, const glm::vec3 &value) const;
+    void setVec4(Uniform uniform, const glm::vec4 &value) const;
+    void setMat2(Uniform uniform, const glm::mat2 &mat) const;
+    void setMat3(Uniform uniform, const glm::mat3 &mat) const;
+    void setMat4(Uniform uniform, const glm::mat4 &mat) const;
+
+    // Attaches a uniform block of the program to a uniform buffer binding point
+    void bindUniformBlock(const std::string &blockName, GLuint binding) const;
+
+    // Upload counters since the last reset
+    UniformStats getUniformStats() const;
+    void resetUniformStats();
 
 	 // Activates the Shader Program
 	void Activate();
@@ -40,8 +83,38 @@ public:
 	void Delete();
 
 private:
+    // Reads a source file, logging and returning an empty string on failure
+    static std::string readSource(const char* path);
     // Utility function for checking shader compilation/linking errors
     void checkCompileErrors(GLuint shader, std::string type);
+    // Returns the source with one "#define" line per define inserted after its #version directive
+    static std::string injectDefines(const std::string& source, const std::vector<std::string>& defines);
+    // Enumerates the active uniforms of the linked program into the uniform table
+    void cacheUniforms();
+    // One stage of a program: its GL shader type, its name in error messages and its source
+    struct Stage
+    {
+        GLenum type;
+        const char* name;
+        const std::string* source;
+    };
+    // Loads the program of the stages from the program cache, or compiles and links them and stores
+    // the binary there. Sets ID and fills the uniform table.
+    void buildProgram(const Stage* stages, size_t count);
+    // Compares a value against the last one uploaded to a location, recording it if it differs.
+    // Returns false when the upload can be skipped.
+    bool updateShadow(Uniform uniform, const void* data, size_t size) const;
+
+    // Last value uploaded to each uniform location of this program
+    struct ShadowValue
+    {
+        float data[16];
+        bool valid = false;
+    };
+
+    UniformTable uniforms;
+    mutable std::vector<ShadowValue> shadow;
+    mutable UniformStats stats;
 };
 }}
 
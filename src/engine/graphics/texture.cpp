@@ -1,4 +1,5 @@
 #include "texture.hpp"
+#include "glstate.hpp"
 
 Engine::Graphics::Texture::Texture(const char *image, GLenum texType, GLenum slot, GLenum format, GLenum pixelType)
 {
@@ -15,8 +16,7 @@ Engine::Graphics::Texture::Texture(const char *image, GLenum texType, GLenum slo
    // Generates an OpenGL texture object
    glGenTextures(1, &ID);
    // Assigns the texture to a Texture Unit
-   glActiveTexture(slot);
-   glBindTexture(texType, ID);
+   GLState::BindTextureUnit(slot - GL_TEXTURE0, texType, ID);
 
    // Configures the type of algorithm that is used to make the image smaller or bigger
    glTexParameteri(texType, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
@@ -39,30 +39,66 @@ Engine::Graphics::Texture::Texture(const char *image, GLenum texType, GLenum slo
    stbi_image_free(bytes);
 
    // Unbinds the OpenGL Texture object so that it can't accidentally be modified
-   glBindTexture(texType, 0);
+   GLState::BindTexture(texType, 0);
+}
+
+Engine::Graphics::Texture::Texture(GLuint id, GLenum texType)
+{
+   ID = id;
+   type = texType;
+}
+
+Engine::Graphics::Texture::~Texture()
+{
+   Delete();
+}
+
+Engine::Graphics::Texture::Texture(Texture&& other) noexcept : ID(other.ID), type(other.type)
+{
+   other.ID = 0;
+}
+
+Engine::Graphics::Texture& Engine::Graphics::Texture::operator=(Texture&& other) noexcept
+{
+   if (this != &other)
+   {
+      Delete();
+      ID = other.ID;
+      type = other.type;
+      other.ID = 0;
+   }
+   return *this;
 }
 
 void Engine::Graphics::Texture::texUnit(Shader &shader, const char *uniform, GLuint unit)
 {
-   // Gets the location of the uniform
-   GLuint texUni = glGetUniformLocation(shader.ID, uniform);
    // Shader needs to be activated before changing the value of a uniform
    shader.Activate();
    // Sets the value of the uniform
-   glUniform1i(texUni, unit);
+   shader.setInt(uniform, unit);
 }
 
 void Engine::Graphics::Texture::Bind()
 {
-   glBindTexture(type, ID);
+   GLState::BindTexture(type, ID);
+}
+
+void Engine::Graphics::Texture::Bind(GLuint unit)
+{
+   GLState::BindTextureUnit(unit, type, ID);
 }
 
 void Engine::Graphics::Texture::Unbind()
 {
-   glBindTexture(type, 0);
+   GLState::BindTexture(type, 0);
 }
 
 void Engine::Graphics::Texture::Delete()
 {
-   glDeleteTextures(1, &ID);
+   if (ID != 0)
+   {
+      GLState::ForgetTexture(ID);
+      glDeleteTextures(1, &ID);
+   }
+   ID = 0;
 }
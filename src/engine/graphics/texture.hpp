@@ -4,6 +4,7 @@
 #include <GL/glew.h>
 #include <stb_image/stb_image.h>
 
+#include "../core/handlepool.hpp"
 #include "shader.hpp"
 
 namespace Engine{
@@ -15,15 +16,30 @@ public:
    GLuint ID;
    GLenum type;
    Texture(const char *image, GLenum texType, GLenum slot, GLenum format, GLenum pixelType);
+   // Takes ownership of an existing texture object (e.g. one being filled by a TextureLoader)
+   Texture(GLuint id, GLenum texType);
+   // Deletes the texture if Delete was not called
+   ~Texture();
+   // Move-only: exactly one object owns the texture
+   Texture(const Texture&) = delete;
+   Texture& operator=(const Texture&) = delete;
+   Texture(Texture&& other) noexcept;
+   Texture& operator=(Texture&& other) noexcept;
 
    // Assigns a texture unit to a texture
    void texUnit(Shader &shader, const char *uniform, GLuint unit);
-   // Binds a texture
+   // Binds a texture on the active texture unit
    void Bind();
+   // Binds a texture on texture unit GL_TEXTURE0 + unit
+   void Bind(GLuint unit);
    // Unbinds a texture
    void Unbind();
    // Deletes a texture
    void Delete();
 };
+
+// Textures are owned by a pool and referenced by handle, so a handle to a released texture is detected
+typedef Core::Handle<Texture> TextureHandle;
+typedef Core::HandlePool<Texture> TexturePool;
 }}
 #endif
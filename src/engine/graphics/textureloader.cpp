@@ -0,0 +1,206 @@
+#include "textureloader.hpp"
+#include "glstate.hpp"
+#include "../core/trace.hpp"
+#include <cstring>
+#include <iostream>
+#include <stb_image/stb_image.h>
+
+Engine::Graphics::TextureLoader::TextureLoader(Core::ThreadPool& pool, TexturePool& textures, size_t uploadBudget)
+    : pool(pool), textures(textures), uploadBudget(uploadBudget), uploadedBytes(0), nextBuffer(0), decoding(0)
+{
+    for (int i = 0; i < PBO_COUNT; i++)
+    {
+        pixelBuffers[i] = 0;
+        fences[i] = nullptr;
+    }
+}
+
+void Engine::Graphics::TextureLoader::bindForUpload(GLuint texture)
+{
+    static_assert(UPLOAD_UNIT < GLState::TEXTURE_UNITS, "the upload unit must be tracked by GLState");
+    GLState::ActiveTexture(GL_TEXTURE0 + UPLOAD_UNIT);
+    GLState::BindTexture(GL_TEXTURE_2D, texture);
+}
+
+Engine::Graphics::TextureHandle Engine::Graphics::TextureLoader::Load(const std::string& path)
+{
+    GLuint id;
+    glGenTextures(1, &id);
+    bindForUpload(id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // 1x1 grey placeholder, a complete mipmap chain on its own
+    const unsigned char placeholder[4] = {128, 128, 128, 255};
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+    TextureHandle texture = textures.Create(Texture(id, GL_TEXTURE_2D));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decoding++;
+    }
+    pool.Submit([this, texture, path]() { decode(texture, path); });
+
+    return texture;
+}
+
+void Engine::Graphics::TextureLoader::decode(TextureHandle texture, const std::string& path)
+{
+    ENGINE_TRACE_SCOPE("Decode texture");
+    // The flip flag is per thread, other loads keep their own setting
+    stbi_set_flip_vertically_on_load_thread(true);
+    Decoded image = {texture, 0, 0, nullptr, path};
+    int channels;
+    image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &channels, 4);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    decoded.push_back(std::move(image));
+    decoding--;
+    decodedSignal.notify_all();
+}
+
+bool Engine::Graphics::TextureLoader::upload(const Decoded& image)
+{
+    if (image.pixels == nullptr)
+    {
+        std::cout << "ERROR::TEXTURE::FILE_NOT_SUCCESSFULLY_READ: " << image.path << std::endl;
+        return true;
+    }
+    Texture* texture = textures.Get(image.texture);
+    if (texture == nullptr)
+    {
+        stbi_image_free(image.pixels);
+        return true;
+    }
+
+    if (pixelBuffers[0] == 0)
+        glGenBuffers(PBO_COUNT, pixelBuffers);
+
+    GLsync& fence = fences[nextBuffer];
+    if (fence != nullptr)
+    {
+        if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // Orphan the buffer's old storage and write the pixels straight into the new one
+    GLsizeiptr size = (GLsizeiptr)image.width * image.height * 4;
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[nextBuffer]);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped != nullptr)
+    {
+        std::memcpy(mapped, image.pixels, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else
+    {
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, image.pixels);
+    }
+
+    // The texture reads from the bound pixel buffer, so the driver can copy asynchronously
+    bindForUpload(texture->ID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    // Other uploads pass client memory and must not read from the pixel buffer
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextBuffer = (nextBuffer + 1) % PBO_COUNT;
+    stbi_image_free(image.pixels);
+    return true;
+}
+
+void Engine::Graphics::TextureLoader::uploadAll(size_t budget)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Decoded& image : decoded)
+            ready.push_back(std::move(image));
+        decoded.clear();
+    }
+
+    size_t uploaded = 0;
+    for (; uploaded < ready.size(); uploaded++)
+    {
+        size_t bytes = ready[uploaded].pixels != nullptr ? (size_t)ready[uploaded].width * ready[uploaded].height * 4 : 0;
+        // Always take at least one image, so textures larger than the budget still arrive
+        if (uploadedBytes > 0 && uploadedBytes + bytes > budget)
+            break;
+        if (!upload(ready[uploaded]))
+            break;
+        uploadedBytes += bytes;
+    }
+    ready.erase(ready.begin(), ready.begin() + uploaded);
+}
+
+void Engine::Graphics::TextureLoader::Update()
+{
+    uploadedBytes = 0;
+    uploadAll(uploadBudget);
+}
+
+void Engine::Graphics::TextureLoader::Finish()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decodedSignal.wait(lock, [this]() { return !decoded.empty() || decoding == 0; });
+            if (decoding == 0 && decoded.empty() && ready.empty())
+                break;
+        }
+
+        uploadedBytes = 0;
+        uploadAll((size_t)-1);
+        // Still blocked on the oldest pixel buffer: wait for the GPU to release it
+        GLsync fence = fences[nextBuffer];
+        if (!ready.empty() && fence != nullptr)
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    }
+}
+
+void Engine::Graphics::TextureLoader::Delete()
+{
+    {
+        // Decode jobs hold a pointer to this loader
+        std::unique_lock<std::mutex> lock(mutex);
+        decodedSignal.wait(lock, [this]() { return decoding == 0; });
+        for (Decoded& image : decoded)
+            ready.push_back(std::move(image));
+        decoded.clear();
+    }
+    for (Decoded& image : ready)
+        stbi_image_free(image.pixels);
+    ready.clear();
+
+    for (int i = 0; i < PBO_COUNT; i++)
+    {
+        if (fences[i] != nullptr)
+            glDeleteSync(fences[i]);
+        fences[i] = nullptr;
+    }
+    if (pixelBuffers[0] != 0)
+    {
+        for (int i = 0; i < PBO_COUNT; i++)
+            GLState::ForgetBuffer(pixelBuffers[i]);
+        glDeleteBuffers(PBO_COUNT, pixelBuffers);
+    }
+    for (int i = 0; i < PBO_COUNT; i++)
+        pixelBuffers[i] = 0;
+}
+
+size_t Engine::Graphics::TextureLoader::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return decoding + decoded.size() + ready.size();
+}
+
+size_t Engine::Graphics::TextureLoader::GetUploadedBytes() const
+{
+    return uploadedBytes;
+}
@@ -0,0 +1,91 @@
+#ifndef ENGINE_GRAPHICS_TEXTURELOADER_HPP
+#define ENGINE_GRAPHICS_TEXTURELOADER_HPP
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../core/threadpool.hpp"
+#include "texture.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Loads 2D textures without stalling the render thread: images are decoded by stb_image on the
+// thread pool, and Update() copies finished ones through a ring of pixel buffer objects into their
+// textures, up to a byte budget per frame. Textures are usable right away and show a grey
+// placeholder until their data arrives. A texture released from the pool before its data arrives is
+// skipped, since its handle has gone stale.
+class TextureLoader
+{
+public:
+    // Pixel buffers in the ring; a buffer is reused once the GPU has finished the upload it last fed
+    static const int PBO_COUNT = 4;
+    // Texture unit textures are created and filled on, so loading never replaces what the material
+    // units hold. The last unit GLState tracks, which nothing else uses.
+    static const GLuint UPLOAD_UNIT = 15;
+
+    TextureLoader(Core::ThreadPool& pool, TexturePool& textures, size_t uploadBudget = 8 << 20);
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Adds a texture with its placeholder to the pool and queues the file for decoding (RGBA8, mipmapped).
+    // Leaves UPLOAD_UNIT active, as Update and Finish do when they upload.
+    TextureHandle Load(const std::string& path);
+    // Uploads decoded images within the per-frame budget; call once per frame on the GL thread
+    void Update();
+    // Blocks until every queued texture is decoded and uploaded
+    void Finish();
+    // Waits for the decode jobs and deletes the pixel buffers (not the textures)
+    void Delete();
+
+    // Textures still waiting for decoding or upload
+    size_t GetPendingCount() const;
+    // Bytes uploaded by the last Update
+    size_t GetUploadedBytes() const;
+
+private:
+    struct Decoded
+    {
+        TextureHandle texture;
+        int width;
+        int height;
+        // stb_image pixels, nullptr if decoding failed
+        unsigned char* pixels;
+        std::string path;
+    };
+
+    // Makes UPLOAD_UNIT active and binds a texture there for the calls that follow
+    void bindForUpload(GLuint texture);
+    // Decodes one file on a worker thread
+    void decode(TextureHandle texture, const std::string& path);
+    // Copies one image into the next free pixel buffer and from there into its texture
+    // (returns false if that buffer is still in use by the GPU)
+    bool upload(const Decoded& image);
+    // Takes over the images decoded so far and uploads them until the byte budget is spent
+    void uploadAll(size_t budget);
+
+    Core::ThreadPool& pool;
+    TexturePool& textures;
+    size_t uploadBudget;
+    size_t uploadedBytes;
+
+    GLuint pixelBuffers[PBO_COUNT];
+    GLsync fences[PBO_COUNT];
+    int nextBuffer;
+
+    // Shared with the decode jobs
+    mutable std::mutex mutex;
+    std::condition_variable decodedSignal;
+    std::vector<Decoded> decoded;
+    size_t decoding;
+    // Decoded images taken from the shared list but not uploaded yet
+    std::vector<Decoded> ready;
+};
+}}
+
+#endif
@@ -0,0 +1,79 @@
+#include "uniformtable.hpp"
+#include <functional>
+
+// Capacity is always a power of two so that probing can mask instead of modulo
+Engine::Graphics::UniformTable::UniformTable() : slots(16), count(0)
+{
+}
+
+void Engine::Graphics::UniformTable::insert(std::string_view name, Uniform uniform)
+{
+    // Keep the load factor under 0.5 so probe sequences stay short
+    if ((count + 1) * 2 > slots.size())
+        grow();
+
+    size_t hash = std::hash<std::string_view>{}(name);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        Entry& entry = slots[i];
+        if (!entry.used)
+        {
+            entry.hash = hash;
+            entry.name = std::string(name);
+            entry.uniform = uniform;
+            entry.used = true;
+            count++;
+            return;
+        }
+        if (entry.hash == hash && entry.name == name)
+        {
+            entry.uniform = uniform;
+            return;
+        }
+    }
+}
+
+const Engine::Graphics::Uniform* Engine::Graphics::UniformTable::find(std::string_view name) const
+{
+    size_t hash = std::hash<std::string_view>{}(name);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        const Entry& entry = slots[i];
+        if (!entry.used)
+            return nullptr;
+        if (entry.hash == hash && entry.name == name)
+            return &entry.uniform;
+    }
+}
+
+void Engine::Graphics::UniformTable::clear()
+{
+    slots.assign(16, Entry());
+    count = 0;
+}
+
+size_t Engine::Graphics::UniformTable::size() const
+{
+    return count;
+}
+
+void Engine::Graphics::UniformTable::grow()
+{
+    std::vector<Entry> old(slots.size() * 2);
+    old.swap(slots);
+    count = 0;
+
+    size_t mask = slots.size() - 1;
+    for (Entry& entry : old)
+    {
+        if (!entry.used)
+            continue;
+        size_t i = entry.hash & mask;
+        while (slots[i].used)
+            i = (i + 1) & mask;
+        slots[i] = std::move(entry);
+        count++;
+    }
+}
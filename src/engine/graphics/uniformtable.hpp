@@ -0,0 +1,55 @@
+#ifndef ENGINE_GRAPHICS_UNIFORMTABLE_HPP
+#define ENGINE_GRAPHICS_UNIFORMTABLE_HPP
+
+#include <GL/glew.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Engine{
+namespace Graphics{
+
+// Pre-resolved handle to an active uniform of a linked shader program
+struct Uniform
+{
+    GLint location = -1;
+    GLenum type = GL_NONE;
+
+    bool valid() const { return location >= 0; }
+};
+
+// Open addressing hash table (linear probing) mapping uniform names to their handles.
+// Filled once after the program is linked, then only read from.
+class UniformTable
+{
+public:
+    UniformTable();
+
+    // Inserts or replaces the handle stored for a name
+    void insert(std::string_view name, Uniform uniform);
+    // Returns the handle stored for a name, or nullptr if the program has no such uniform
+    const Uniform* find(std::string_view name) const;
+
+    // Removes every entry
+    void clear();
+    size_t size() const;
+
+private:
+    struct Entry
+    {
+        size_t hash = 0;
+        std::string name;
+        Uniform uniform;
+        bool used = false;
+    };
+
+    // Doubles the slot count and re-inserts every entry
+    void grow();
+
+    std::vector<Entry> slots;
+    size_t count;
+};
+}}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef ENGINE_GRAPHICS_VERTEX_HPP
+#define ENGINE_GRAPHICS_VERTEX_HPP
+
+#include <glm/glm.hpp>
+
+namespace Engine{
+namespace Graphics{
+
+// Struct for vertex data containing {position [x, y, z], texture mapping [0, 1], normal vector for lighting) [x, y, z]}
+struct Vertex {
+    glm::vec3 position;
+    glm::vec2 texCoords;
+    glm::vec3 normal;
+
+    Vertex(glm::vec3 pos, glm::vec2 tex, glm::vec3 norm)
+        : position(pos), texCoords(tex), normal(norm) {}
+
+    Vertex()
+        : position(0.0f), texCoords(0.0f), normal(0.0f, 0.0f, 1.0f) {}
+};
+
+}}
+
+#endif
@@ -0,0 +1,167 @@
+#include "vertexformat.hpp"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// -1 for negative components and 1 otherwise, so points on the axes fold consistently
+static glm::vec2 signNotZero(const glm::vec2& v)
+{
+    return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+// Projects a unit vector onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the
+// upper one, giving a point of the square [-1, 1]^2
+static glm::vec2 encodeOctahedral(const glm::vec3& normal)
+{
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec3 n = normal / length;
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+        e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * signNotZero(e);
+    return e;
+}
+
+// Same as decodeNormal in default.vert
+static glm::vec3 decodeOctahedral(const glm::vec2& e)
+{
+    glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    if (n.z < 0.0f)
+    {
+        glm::vec2 folded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n));
+        n.x = folded.x;
+        n.y = folded.y;
+    }
+    return glm::normalize(n);
+}
+
+static int16_t toSnorm16(float value)
+{
+    return (int16_t)std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+static float fromSnorm16(int16_t value)
+{
+    return std::max(value / 32767.0f, -1.0f);
+}
+
+size_t Engine::Graphics::GetVertexSize(VertexFormat format)
+{
+    return format == VertexFormat::Float ? sizeof(Vertex) : sizeof(PackedVertex);
+}
+
+std::vector<unsigned char> Engine::Graphics::EncodeVertices(const std::vector<Vertex>& vertices, VertexFormat format,
+                                                            const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    std::vector<unsigned char> data(vertices.size() * GetVertexSize(format));
+    if (format == VertexFormat::Float)
+    {
+        if (!vertices.empty())
+            std::memcpy(data.data(), vertices.data(), data.size());
+        return data;
+    }
+
+    glm::vec3 extent = boundsMax - boundsMin;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const Vertex& vertex = vertices[i];
+        PackedVertex packed;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (format == VertexFormat::Quantized)
+            {
+                float t = extent[axis] > 0.0f ? (vertex.position[axis] - boundsMin[axis]) / extent[axis] : 0.0f;
+                packed.position[axis] = (uint16_t)std::lround(glm::clamp(t, 0.0f, 1.0f) * 65535.0f);
+            }
+            else
+                packed.position[axis] = glm::packHalf1x16(vertex.position[axis]);
+        }
+        packed.position[3] = 0;
+        packed.texCoords[0] = glm::packHalf1x16(vertex.texCoords.x);
+        packed.texCoords[1] = glm::packHalf1x16(vertex.texCoords.y);
+        glm::vec2 normal = encodeOctahedral(vertex.normal);
+        packed.normal[0] = toSnorm16(normal.x);
+        packed.normal[1] = toSnorm16(normal.y);
+        std::memcpy(&data[i * sizeof(PackedVertex)], &packed, sizeof(PackedVertex));
+    }
+    return data;
+}
+
+std::vector<Engine::Graphics::Vertex> Engine::Graphics::DecodeVertices(const void* data, size_t count, VertexFormat format,
+                                                                       const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    std::vector<Vertex> vertices(count);
+    if (format == VertexFormat::Float)
+    {
+        if (count != 0)
+            std::memcpy(vertices.data(), data, count * sizeof(Vertex));
+        return vertices;
+    }
+
+    glm::vec3 extent = boundsMax - boundsMin;
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < count; i++)
+    {
+        PackedVertex packed;
+        std::memcpy(&packed, bytes + i * sizeof(PackedVertex), sizeof(PackedVertex));
+        Vertex& vertex = vertices[i];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (format == VertexFormat::Quantized)
+                vertex.position[axis] = boundsMin[axis] + extent[axis] * (packed.position[axis] / 65535.0f);
+            else
+                vertex.position[axis] = glm::unpackHalf1x16(packed.position[axis]);
+        }
+        vertex.texCoords = glm::vec2(glm::unpackHalf1x16(packed.texCoords[0]), glm::unpackHalf1x16(packed.texCoords[1]));
+        vertex.normal = decodeOctahedral(glm::vec2(fromSnorm16(packed.normal[0]), fromSnorm16(packed.normal[1])));
+    }
+    return vertices;
+}
+
+void Engine::Graphics::LinkVertexFormat(Buffers::VAO& vao, Buffers::VBO& vbo, VertexFormat format)
+{
+    if (format == VertexFormat::Float)
+    {
+        // Position
+        vao.LinkAttrib(vbo, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)0);
+        // Texture Coordinates
+        vao.LinkAttrib(vbo, 1, 2, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+        // Normal
+        vao.LinkAttrib(vbo, 2, 3, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        return;
+    }
+
+    // Quantized positions read as 0-1 and are scaled to the bounds in the shader
+    if (format == VertexFormat::Quantized)
+        vao.LinkAttrib(vbo, 0, 3, GL_UNSIGNED_SHORT, sizeof(PackedVertex), (void*)0, GL_TRUE);
+    else
+        vao.LinkAttrib(vbo, 0, 3, GL_HALF_FLOAT, sizeof(PackedVertex), (void*)0);
+    vao.LinkAttrib(vbo, 1, 2, GL_HALF_FLOAT, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+    // The octahedral point reads as -1 to 1 and is unfolded in the shader
+    vao.LinkAttrib(vbo, 2, 2, GL_SHORT, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal), GL_TRUE);
+}
+
+std::vector<std::string> Engine::Graphics::VertexFormatDefines(VertexFormat format, std::vector<std::string> defines)
+{
+    if (format != VertexFormat::Float)
+        defines.push_back("OCTAHEDRAL_NORMALS");
+    if (format == VertexFormat::Quantized)
+        defines.push_back("QUANTIZED_POSITIONS");
+    return defines;
+}
+
+const char* Engine::Graphics::GetVertexFormatName(VertexFormat format)
+{
+    switch (format)
+    {
+    case VertexFormat::Compact:
+        return "compact";
+    case VertexFormat::Quantized:
+        return "quantized";
+    default:
+        return "float";
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef ENGINE_GRAPHICS_VERTEXFORMAT_HPP
+#define ENGINE_GRAPHICS_VERTEXFORMAT_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "buffers/vao.hpp"
+#include "buffers/vbo.hpp"
+#include "vertex.hpp"
+
+namespace Engine{
+namespace Graphics{
+
+// Layouts a mesh's vertices can be stored in on the GPU:
+//   Float:     Vertex as is, 32 bytes
+//   Compact:   half float position and texture coordinates, octahedral normal in two snorm16, 16 bytes
+//   Quantized: unorm16 position within the mesh bounds, otherwise as Compact, 16 bytes. Programs decode
+//              it as positionOffset + positionScale * position, with the bounds minimum and size
+//              (Mesh::SetDecodeUniforms).
+enum class VertexFormat
+{
+    Float,
+    Compact,
+    Quantized
+};
+
+// GPU layout of Compact and Quantized vertices
+struct PackedVertex
+{
+    // Half floats (Compact) or unorm16 within the bounds (Quantized); the fourth is padding
+    uint16_t position[4];
+    // Half floats
+    uint16_t texCoords[2];
+    // Unit vector projected onto an octahedron and unfolded into a square, snorm16
+    int16_t normal[2];
+};
+
+// Bytes per vertex
+size_t GetVertexSize(VertexFormat format);
+// Encodes vertices in a format; Quantized positions are stored relative to the box boundsMin-boundsMax,
+// which must hold every position
+std::vector<unsigned char> EncodeVertices(const std::vector<Vertex>& vertices, VertexFormat format,
+                                          const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+// Reverses EncodeVertices as the vertex shader does, e.g. to measure the precision lost
+std::vector<Vertex> DecodeVertices(const void* data, size_t count, VertexFormat format,
+                                   const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+// Points attributes 0-2 (position, texture coordinates, normal) of the bound vertex array at a buffer
+// of vertices in a format
+void LinkVertexFormat(Buffers::VAO& vao, Buffers::VBO& vbo, VertexFormat format);
+// Shader defines of the variant of a program with the given defines that reads a format
+std::vector<std::string> VertexFormatDefines(VertexFormat format, std::vector<std::string> defines = {});
+const char* GetVertexFormatName(VertexFormat format);
+}}
+
+#endif
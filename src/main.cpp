@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <iostream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -5,15 +6,18 @@
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 
-#include "engine/graphics/light.hpp"
+#include "engine/core/allocationcounter.hpp"
+#include "engine/core/trace.hpp"
 #include "engine/graphics/lightmanager.hpp"
-#include "engine/graphics/mesh.hpp"
+#include "engine/graphics/profiler.hpp"
+#include "engine/graphics/programcache.hpp"
+#include "engine/graphics/renderstats.hpp"
 #include <ostream>
 #include <stb_image/stb_image.h>
-#include "engine/graphics/shader.hpp"
-#include "engine/graphics/texture.hpp"
 #include "engine/graphics/camera.hpp"
-#include "glm/ext/matrix_transform.hpp"
+#include "benchmark.hpp"
+#include "profilerpanel.hpp"
+#include "scene.hpp"
 
 const int WIDTH = 1500;
 const int HEIGHT = 700;
@@ -29,10 +33,14 @@ bool cursorMode = false;
 float deltaTime = 0.0f; // Time between current frame and last frame
 float lastFrame = 0.0f; // Time of last frame
 
+// Size of the 3D viewport in framebuffer pixels (the settings panel takes the rest)
+glm::vec2 viewportSize(0.0f);
+
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
     glViewport(0, 0, width - 600, height);
+    viewportSize = glm::vec2(width - 600, height);
 }
 
 void processInput(GLFWwindow *window)
@@ -55,6 +63,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     if (key == GLFW_KEY_LEFT_ALT && action == GLFW_PRESS){
         cursorMode = !cursorMode;
         std::cout << cursorMode << std::endl;
+        // Only when the mode changes; setting it every frame makes some platforms re-center the cursor
+        glfwSetInputMode(window, GLFW_CURSOR, cursorMode ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
     }
     if(key == GLFW_KEY_F && action == GLFW_PRESS){
         lightManager.setUseFlashLight(!lightManager.getUseFlashLight());
@@ -92,8 +102,50 @@ void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
     // camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    // Headless runs (--bench) render offscreen and never open a window
+    BenchmarkOptions benchOptions;
+    if (!ParseBenchmarkOptions(argc, argv, benchOptions))
+    {
+        return -1;
+    }
+    Engine::Core::TraceRecorder::SetThreadName("Render thread");
+    if (!benchOptions.trace.empty())
+    {
+        // The profiler provides the GPU track of the trace
+        Engine::Core::TraceRecorder::SetEnabled(true);
+        Engine::Graphics::Profiler::SetEnabled(true);
+    }
+    if (benchOptions.cullBenchmark)
+    {
+        return RunCullingBenchmark(benchOptions);
+    }
+    if (benchOptions.bvhBenchmark)
+    {
+        return RunBVHBenchmark(benchOptions);
+    }
+    if (benchOptions.meshBenchmark)
+    {
+        return RunMeshBenchmark(benchOptions);
+    }
+    if (benchOptions.lodBenchmark)
+    {
+        return RunLodBenchmark(benchOptions);
+    }
+    if (benchOptions.meshletBenchmark)
+    {
+        return RunMeshletBenchmark(benchOptions);
+    }
+    if (benchOptions.uniformBenchmark)
+    {
+        return RunUniformBenchmark(benchOptions);
+    }
+    if (benchOptions.enabled)
+    {
+        return RunBenchmark(benchOptions);
+    }
+
     // Initialize GLFW
     glfwInit();
 
@@ -131,6 +183,7 @@ int main()
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width - 600, height);
+    viewportSize = glm::vec2(width - 600, height);
     
     //ImGUI setup
     IMGUI_CHECKVERSION();
@@ -141,23 +194,14 @@ int main()
     
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
     
-    // Generates Shader object using shaders defualt.vert and default.frag
-    Engine::Graphics::Shader shaderProgram("../shaders/default.vert", "../shaders/default.frag");
-    Engine::Graphics::Shader lightProgram("../shaders/light.vert", "../shaders/light.frag");
-
-    // Textures
-    
-    shaderProgram.Activate();
-    Engine::Graphics::Texture Dirt("../textures/dirt.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE);
-    Dirt.texUnit(shaderProgram, "material.diffuse", 0);
-    Dirt.Bind();
-    
-    Engine::Graphics::Texture Specular("../textures/specular.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE);
-    Specular.texUnit(shaderProgram, "material.specular", 1);
-    Specular.Bind();
-
-    Engine::Graphics::Mesh cubeMesh = Engine::Graphics::Mesh::CreateCube(1.0f, &Dirt);
-    Engine::Graphics::Mesh lightCube = Engine::Graphics::Mesh::CreateCube(1.0f);
+    // Reuse program binaries from earlier runs instead of compiling every shader variant again
+    Engine::Graphics::ProgramCache::SetDirectory("shader_cache");
+    double loadStart = glfwGetTime();
+    Scene scene(lightManager, camera, benchOptions.vertexFormat);
+    SceneSettings settings;
+    std::cout << "Scene loaded in " << (glfwGetTime() - loadStart) * 1000.0 << " ms (program cache: "
+              << Engine::Graphics::ProgramCache::GetHits() << " hits, "
+              << Engine::Graphics::ProgramCache::GetMisses() << " misses)" << std::endl;
     
     // Check for OpenGL errors
     GLenum err;
@@ -170,54 +214,29 @@ int main()
     std::cout << "Starting render loop..." << std::endl;
     std::cout << "Camera position: " << camera.Position.x << ", " << camera.Position.y << ", " << camera.Position.z << std::endl;
     
-    const int activePointLight = 4;
-    std::vector<glm::vec3> pointLightPositions(activePointLight);
-    
-    // Directional light properties
-    Engine::Graphics::DirectionalLight dirLight(
-        glm::vec3(-0.2f, -1.0f, -0.3f),
-        glm::vec3(0.05f, 0.05f, 0.05f),
-        glm::vec3(0.4f, 0.4f, 0.4f),
-        glm::vec3(0.5f, 0.5f, 0.5f)
-    );
-    lightManager.setDirectionalLight(dirLight);
-    
-    // Point light properties
-    for(size_t i = 0; i < 4; i++){
-        Engine::Graphics::PointLight light(
-            pointLightPositions[i],
-            1.0f,
-            0.09f,
-            0.032f,
-            glm::vec3(0.05f, 0.05f, 0.05f),
-            glm::vec3(0.8f, 0.8f, 0.8f),
-            glm::vec3(1.0f, 1.0f, 1.0f)
-        );
-        lightManager.addPointLight(light);
-    }
-    
-    // FlashLight properties
-    Engine::Graphics::FlashLight flashLight(camera.Position, camera.Front);
-    lightManager.setFlashLight(flashLight);
+    // Heap allocations made by the last scene update and render
+    size_t sceneAllocations = 0;
+    // Cube last clicked in cursor mode, -1 for none
+    int pickedCube = -1;
 
     // Main while loop
     while (!glfwWindowShouldClose(window))
     {
+        ENGINE_TRACE_SCOPE("Frame");
         // Synchronising delta between frames for all machines
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        Engine::Graphics::Profiler::BeginFrame();
         
         //ImGUI
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
         
-        static float cutOff = 0.0f;
-        static float outerCutOff = 0.0f;
-        
         // 2. Show a simple window that we create ourselves. We use a Begin/End pair to create a named window.
         {
+            ENGINE_PROFILE_SCOPE("Interface");
             // Set up the ImGui window to be a fixed panel on the right
             ImGui::SetNextWindowPos(ImVec2(WIDTH - 300, 0));  // Position at right edge
             ImGui::SetNextWindowSize(ImVec2(300, HEIGHT));     // 300px wide, full height
@@ -230,134 +249,115 @@ int main()
             ImGui::Begin("Light Settings", nullptr, window_flags);
             ImGui::Checkbox("Use Directional Light", lightManager.setUseDirLight());
             
-            for(size_t i = 0; i < lightManager.getPointLightCount(); i++){
-                std::string label = "Use Point Light " + std::to_string(i + 1);
+            for(size_t i = 0; i < Scene::ANIMATED_POINT_LIGHTS; i++){
+                char label[32];
+                std::snprintf(label, sizeof(label), "Use Point Light %zu", i + 1);
                 bool tempBool = lightManager.getUsePointLight(i);
-                if(ImGui::Checkbox(label.c_str(), &tempBool)){
+                if(ImGui::Checkbox(label, &tempBool)){
                     lightManager.setUsePointLight(i, tempBool);
                 }
                 
             }
-            ImGui::SliderFloat("Flash Light Cut Off", &cutOff, 0, 45);
-            ImGui::SliderFloat("Flash Light Outer Cut Off", &outerCutOff, 0, 45);
+            ImGui::Checkbox("Clustered Lighting", &settings.clusteredLighting);
+            ImGui::Checkbox("Instanced Drawing", &settings.instancedDrawing);
+            ImGui::Checkbox("Render Queue", &settings.renderQueue);
+            ImGui::Checkbox("Batched Drawing (multi-draw)", &settings.batchedDrawing);
+            if(settings.batchedDrawing){
+                ImGui::Text("Batch path: %s", Engine::Graphics::GetBatchPathName(scene.GetBatchPath()));
+            }
+            ImGui::Checkbox("Frustum Culling", &settings.frustumCulling);
+            ImGui::Checkbox("Hierarchical Culling (BVH)", &settings.hierarchicalCulling);
+            ImGui::Checkbox("GPU Culling (compute)", &settings.gpuCulling);
+            if(settings.gpuCulling && !scene.IsGpuCulling()){
+                ImGui::Text("GPU culling needs OpenGL 4.3");
+            }
+            ImGui::SliderInt("Extra Point Lights", &settings.extraPointLights, 0, 4096);
+            ImGui::SliderInt("Extra Cubes", &settings.extraCubes, 0, 100000);
+            ImGui::SliderInt("Detail Meshes", &settings.detailMeshes, 0, 1000);
+            ImGui::Checkbox("Meshlet Culling", &settings.meshletCulling);
+            ImGui::Text("Cubes: %zu visible of %zu", scene.GetVisibleCubeCount(), scene.GetCubeCount());
+            ImGui::Text("Picked cube: %d (click in cursor mode)", pickedCube);
+            ImGui::Text("Point lights: %d visible, %d culled",
+                lightManager.getVisiblePointLightCount(), lightManager.getCulledPointLightCount());
+            ImGui::Text("Flash light: %s", lightManager.isFlashLightVisible() ? "visible" : "culled");
+            if(settings.clusteredLighting){
+                ImGui::Text("Clustered lights: %zu, cluster refs: %zu",
+                    scene.GetLightClusters().GetLightCount(), scene.GetLightClusters().GetIndexCount());
+            }
+            ImGui::SliderFloat("Flash Light Cut Off", &settings.cutOff, 0, 45);
+            ImGui::SliderFloat("Flash Light Outer Cut Off", &settings.outerCutOff, 0, 45);
             ImGui::ColorEdit3("clear color", (float*)&clear_color); // TODO: Make Point Light / Directional Light / Flashlight configurable
         
             ImGui::Text("FPS: %.1f", io.Framerate);
+
+            // Counters of the previous frame
+            const Engine::Graphics::RenderStats& renderStats = Engine::Graphics::RenderStats::Current();
+            ImGui::Text("Draw calls: %u, state changes: %u", renderStats.drawCalls, renderStats.StateChanges());
+            ImGui::Text("GL binds: %u issued, %u skipped", renderStats.Binds(), renderStats.skippedBinds);
+            Engine::Graphics::UniformStats uniformStats = scene.GetUniformStats();
+            ImGui::Text("Uniform uploads: %u issued, %u skipped", uniformStats.issued, uniformStats.skipped);
+            ImGui::Text("Heap allocations: %zu", sceneAllocations);
+            if(scene.GetPendingTextureCount() > 0){
+                ImGui::Text("Loading textures: %zu", scene.GetPendingTextureCount());
+            }
+#ifdef ENGINE_PROFILING
+            DrawProfilerPanel(benchOptions.trace.empty() ? "trace.json" : benchOptions.trace);
+#endif
             ImGui::End();
         }
+        scene.ResetUniformStats();
+        Engine::Graphics::RenderStats::Reset();
         ImGui::Render();
         
-        processInput(window);
+        {
+            ENGINE_PROFILE_SCOPE("Input");
+            processInput(window);
+            if(cursorMode && ImGui::IsMouseClicked(0) && !io.WantCaptureMouse){
+                // ImGui reports the cursor in window coordinates
+                glm::vec2 cursor(io.MousePos.x * io.DisplayFramebufferScale.x, io.MousePos.y * io.DisplayFramebufferScale.y);
+                pickedCube = scene.Pick(camera, cursor, viewportSize, (float)WIDTH / (float)HEIGHT);
+            }
+        }
         // Specify the color of the background
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         // Clean the back buffer and assign the new color to it
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        if(cursorMode){
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-        } else{
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-        }
 
-        glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
-
-        // Multiple cube positions;
-        std::vector<glm::vec3> cubePositions = {
-            glm::vec3(1.2f, 2.8f, -1.5f),
-            glm::vec3(-2.3f, 0.9f, 3.1f),
-            glm::vec3(3.5f, -1.7f, 2.4f),
-            glm::vec3(-3.2f, 3.6f, -0.8f),
-            glm::vec3(0.7f, -2.5f, 1.9f),
-            glm::vec3(-1.8f, 1.4f, -3.3f),
-            glm::vec3(2.9f, -3.1f, 0.6f),
-            glm::vec3(-0.5f, 2.2f, -2.7f),
-            glm::vec3(1.6f, -0.4f, 3.8f),
-            glm::vec3(-2.7f, 3.3f, 1.1f)
-        };
-        
-        shaderProgram.Activate();
-        
-        shaderProgram.setVec3("lightColor", lightColor);
-        shaderProgram.setVec3("viewPos", camera.Position);
-        
-        // Material properties
-        // 
-        shaderProgram.setFloat("material.shininess", 16.0f);
-        
-        
-        // Point light positions
-        for(size_t i = 0; i < pointLightPositions.size(); i++){
-            if(i % 2 == 0){
-            float x = 4 * glm::sin(currentFrame +  i * 3.14 / 2);
-            pointLightPositions[i] = glm::vec3(x, 0.0, 0.0);
-            }
-            else{
-            float y = 4 * glm::sin(currentFrame +  i * 3.14 / 2);
-            pointLightPositions[i] = glm::vec3(0.0, y, 0.0);
-            }
-        }
-        
-        for(size_t i = 0; i < pointLightPositions.size(); i++){
-            Engine::Graphics::PointLight& pLight = lightManager.setPointLight(i);
-            pLight.setPosition(pointLightPositions[i]);
-        }
-        
-        // Update Flashlight
-        if(lightManager.getUseFlashLight()){
-            Engine::Graphics::FlashLight& fLight = lightManager.setFlashLight();
-            fLight.setPosition(camera.Position);
-            fLight.setDirection(camera.Front);
-            fLight.setCutOff(glm::cos(glm::radians(cutOff)), glm::cos(glm::radians(outerCutOff)));
-        }
-        
-        
-
-        lightManager.applyAll(shaderProgram);
-
-        glm::mat4 proj = glm::mat4(1.0f);
 
-        proj = glm::perspective(glm::radians(camera.GetZoom()), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+        scene.ApplySettings(settings);
+        size_t allocationsBefore = Engine::Core::GetAllocationCount();
+        scene.Update(currentFrame, camera);
+        scene.Render(camera, viewportSize, (float)WIDTH / (float)HEIGHT);
+        sceneAllocations = Engine::Core::GetAllocationCount() - allocationsBefore;
 
-        glm::mat4 view = camera.GetViewMatrix();
-
-        shaderProgram.setMat4("view", view);
-        shaderProgram.setMat4("proj", proj);
-        
-        glm::mat4 model;
-        for(int i = 0; i < cubePositions.size(); i++){
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            shaderProgram.setMat4("model", model);
-            cubeMesh.Draw(shaderProgram);
+        {
+            ENGINE_PROFILE_GPU_SCOPE("Interface rendering");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         }
-        
-
-        lightProgram.Activate();
-        lightProgram.setVec3("lightColor", lightColor);
-        lightProgram.setMat4("view", view);
-        lightProgram.setMat4("proj", proj);
-        
-        for(int i = 0; i < pointLightPositions.size(); i++){
-            if(lightManager.getUsePointLight(i)){
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, pointLightPositions[i]);
-                model = glm::scale(model, glm::vec3(0.2f)); 
-                lightProgram.setMat4("model", model);
-                lightCube.Draw(lightProgram);
-            }
+        {
+            // Swap the back buffer with the front buffer
+            ENGINE_PROFILE_SCOPE("Swap buffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            // Take care of all GLFW events
+            ENGINE_PROFILE_SCOPE("Poll events");
+            glfwPollEvents();
         }
+        Engine::Graphics::Profiler::EndFrame();
+    }
 
-        
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        // Swap the back buffer with the front buffer
-        glfwSwapBuffers(window);
-        // Take care of all GLFW events
-        glfwPollEvents();
+    if(!benchOptions.trace.empty()){
+        if(Engine::Core::TraceRecorder::Write(benchOptions.trace)){
+            std::cout << "Trace written to " << benchOptions.trace << std::endl;
+        } else {
+            std::cout << "Failed to write trace " << benchOptions.trace << std::endl;
+        }
     }
 
     // Delete all the objects we've created
-    Dirt.Delete();
-    shaderProgram.Delete();
+    scene.Delete();
+    Engine::Graphics::Profiler::Delete();
     // Delete window before ending the program
     glfwDestroyWindow(window);
 
@@ -0,0 +1,110 @@
+#include "profilerpanel.hpp"
+#include <cstdio>
+#include <imgui/imgui.h>
+
+#include "engine/core/trace.hpp"
+#include "engine/graphics/profiler.hpp"
+
+using Engine::Graphics::Profiler;
+
+static const float ROW_HEIGHT = 16.0f;
+
+// One row per nesting depth, bars scaled so the whole frame spans the panel width
+static void drawTimeline(const char* id, const Engine::Graphics::ProfileFrame& frame, bool gpu){
+    float frameTime = gpu ? frame.gpuTime : frame.cpuTime;
+    int depth = 0;
+    for(const Engine::Graphics::ProfileSample& sample : frame.samples){
+        if(!gpu || sample.query >= 0){
+            depth = sample.depth + 1 > depth ? sample.depth + 1 : depth;
+        }
+    }
+
+    float width = ImGui::GetContentRegionAvail().x;
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton(id, ImVec2(width, depth > 0 ? depth * ROW_HEIGHT : ROW_HEIGHT));
+    if(frameTime <= 0.0f){
+        return;
+    }
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    float scale = width / frameTime;
+    for(size_t i = 0; i < frame.samples.size(); i++){
+        const Engine::Graphics::ProfileSample& sample = frame.samples[i];
+        float start = gpu ? sample.gpuStart : sample.cpuStart;
+        float time = gpu ? sample.gpuTime : sample.cpuTime;
+        if(time < 0.0f){
+            continue;
+        }
+
+        ImVec2 min(origin.x + start * scale, origin.y + sample.depth * ROW_HEIGHT);
+        ImVec2 max(min.x + (time * scale > 1.0f ? time * scale : 1.0f), min.y + ROW_HEIGHT - 1.0f);
+        // Stable color per scope so a bar keeps its color from frame to frame
+        ImU32 hue = (ImU32)(size_t)sample.name * 2654435761u;
+        ImU32 color = IM_COL32(96 + ((hue >> 8) & 127), 96 + ((hue >> 16) & 127), 96 + ((hue >> 24) & 127), 255);
+        drawList->AddRectFilled(min, max, color);
+        if(ImGui::CalcTextSize(sample.name).x < max.x - min.x - 4.0f){
+            drawList->AddText(ImVec2(min.x + 2.0f, min.y + 1.0f), IM_COL32(0, 0, 0, 255), sample.name);
+        }
+        if(ImGui::IsMouseHoveringRect(min, max)){
+            ImGui::SetTooltip("%s\nCPU %.3f ms\nGPU %.3f ms", sample.name, sample.cpuTime,
+                sample.query >= 0 ? sample.gpuTime : 0.0f);
+        }
+    }
+}
+
+static void drawHistory(const char* label, const float* history){
+    Engine::Graphics::ProfileSummary summary = Profiler::Summarize(history);
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "%s p50 %.2f p95 %.2f", label, summary.p50, summary.p95);
+    ImGui::PlotHistogram("##history", history, Profiler::GetHistoryCount(), Profiler::GetHistoryOffset(),
+        overlay, 0.0f, summary.max * 1.2f, ImVec2(ImGui::GetContentRegionAvail().x, 40.0f));
+    ImGui::Text("mean %.2f  p99 %.2f  max %.2f ms", summary.mean, summary.p99, summary.max);
+}
+
+void DrawProfilerPanel(const std::string& tracePath){
+    if(!ImGui::CollapsingHeader("Profiler")){
+        return;
+    }
+
+    bool enabled = Profiler::IsEnabled();
+    if(ImGui::Checkbox("Enable Profiler", &enabled)){
+        Profiler::SetEnabled(enabled);
+    }
+
+    // GPU events come from the profiler, so recording turns it on
+    bool recording = Engine::Core::TraceRecorder::IsEnabled();
+    if(ImGui::Checkbox("Record Trace", &recording)){
+        Engine::Core::TraceRecorder::SetEnabled(recording);
+        if(recording){
+            Profiler::SetEnabled(true);
+        }
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Save Trace")){
+        Engine::Core::TraceRecorder::Write(tracePath);
+    }
+    if(ImGui::IsItemHovered()){
+        ImGui::SetTooltip("Writes %s (open in ui.perfetto.dev or chrome://tracing)", tracePath.c_str());
+    }
+    if(!enabled || Profiler::GetHistoryCount() == 0){
+        return;
+    }
+
+    const Engine::Graphics::ProfileFrame& frame = Profiler::GetLastFrame();
+    ImGui::Text("Frame %llu: CPU %.2f ms, GPU %.2f ms", (unsigned long long)frame.number, frame.cpuTime, frame.gpuTime);
+
+    ImGui::PushID("cpu");
+    drawHistory("CPU", Profiler::GetCpuHistory());
+    ImGui::PopID();
+    ImGui::PushID("gpu");
+    drawHistory("GPU", Profiler::GetGpuHistory());
+    ImGui::PopID();
+    if(Profiler::GetDroppedFrames() > 0){
+        ImGui::Text("Frames dropped waiting for the GPU: %llu", (unsigned long long)Profiler::GetDroppedFrames());
+    }
+
+    ImGui::Text("CPU scopes");
+    drawTimeline("##cpuTimeline", frame, false);
+    ImGui::Text("GPU scopes");
+    drawTimeline("##gpuTimeline", frame, true);
+}
@@ -0,0 +1,11 @@
+#ifndef PROFILERPANEL_HPP
+#define PROFILERPANEL_HPP
+
+#include <string>
+
+// Draws the profiler inside the current ImGui window: an enable toggle, frame time histograms with
+// percentiles, and a timeline of the last frame's CPU and GPU scopes (hover a bar for its times),
+// plus trace recording controls that save to tracePath
+void DrawProfilerPanel(const std::string& tracePath);
+
+#endif
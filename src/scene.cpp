@@ -0,0 +1,563 @@
+#include "scene.hpp"
+#include "engine/graphics/profiler.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/gtc/constants.hpp"
+#include <cmath>
+#include <random>
+
+// Texture decodes are a loading-time job; a couple of threads keep them from crowding the frame's work
+static const unsigned int DECODE_THREADS = 2;
+// Detail meshes: 16384 triangles each, twelve to a ring
+static const int DETAIL_MESH_SEGMENTS = 128;
+static const float DETAIL_MESH_BUMP_HEIGHT = 0.2f;
+static const float DETAIL_MESH_SCALE = 1.5f;
+static const int DETAIL_MESHES_PER_RING = 12;
+
+// Defines of a program variant reading the meshes of a geometry arena created with the format
+static std::vector<std::string> arenaDefines(Engine::Graphics::VertexFormat format, std::vector<std::string> defines = {})
+{
+    return Engine::Graphics::VertexFormatDefines(Engine::Graphics::GeometryArena::GetStorageFormat(format), defines);
+}
+
+Scene::Scene(Engine::Graphics::LightManager& lightManager, const Engine::Graphics::Camera& camera,
+             Engine::Graphics::VertexFormat vertexFormat)
+    : lightManager(lightManager),
+      shaderProgram("../shaders/default.vert", "../shaders/default.frag", arenaDefines(vertexFormat)),
+      lightProgram("../shaders/light.vert", "../shaders/light.frag", arenaDefines(vertexFormat)),
+      clusteredProgram("../shaders/default.vert", "../shaders/default.frag", arenaDefines(vertexFormat, {"CLUSTERED_LIGHTING"})),
+      instancedProgram("../shaders/default.vert", "../shaders/default.frag", arenaDefines(vertexFormat, {"INSTANCED"})),
+      clusteredInstancedProgram("../shaders/default.vert", "../shaders/default.frag",
+                                arenaDefines(vertexFormat, {"CLUSTERED_LIGHTING", "INSTANCED"})),
+      instancedLightProgram("../shaders/light.vert", "../shaders/light.frag", arenaDefines(vertexFormat, {"INSTANCED"})),
+      batchedProgram("../shaders/default.vert", "../shaders/default.frag",
+                     Engine::Graphics::BatchRenderer::BatchDefines(arenaDefines(vertexFormat))),
+      clusteredBatchedProgram("../shaders/default.vert", "../shaders/default.frag",
+                              Engine::Graphics::BatchRenderer::BatchDefines(arenaDefines(vertexFormat, {"CLUSTERED_LIGHTING"}))),
+      batchedLightProgram("../shaders/light.vert", "../shaders/light.frag",
+                          Engine::Graphics::BatchRenderer::BatchDefines(arenaDefines(vertexFormat))),
+      litPrograms{&shaderProgram, &clusteredProgram, &instancedProgram, &clusteredInstancedProgram,
+                  &batchedProgram, &clusteredBatchedProgram},
+      allPrograms{&shaderProgram, &clusteredProgram, &instancedProgram, &clusteredInstancedProgram,
+                  &batchedProgram, &clusteredBatchedProgram, &lightProgram, &instancedLightProgram, &batchedLightProgram},
+      decodePool(DECODE_THREADS),
+      textureLoader(decodePool, textures),
+      dirt(textureLoader.Load("../textures/dirt.png")),
+      specular(textureLoader.Load("../textures/specular.png")),
+      geometry(vertexFormat),
+      cubeMesh(Engine::Graphics::Mesh::CreateCube(1.0f, &textures, dirt, &geometry)),
+      lightCube(Engine::Graphics::Mesh::CreateCube(1.0f, nullptr, {}, &geometry)),
+      gpuCuller("../shaders/cull.comp"),
+      visibleCubeCount(0),
+      pointLightPositions(ANIMATED_POINT_LIGHTS)
+{
+    // Material maps on texture units 0 and 1
+    textures.Get(dirt)->Bind(0);
+    textures.Get(specular)->Bind(1);
+
+    for(Engine::Graphics::Shader* program : litPrograms){
+        program->bindUniformBlock("Lights", Engine::Graphics::LightBuffer::BINDING);
+        program->Activate();
+        program->setInt("material.diffuse", 0);
+        program->setInt("material.specular", 1);
+    }
+
+    // The cubes' texture seams leave them a single level. Before resetCubes, which hands the cube's
+    // range to the GPU culler.
+    cubeMesh.GenerateLods();
+    lightCube.GenerateLods();
+
+    modelUniform = shaderProgram.getUniform("model");
+    lightModelUniform = lightProgram.getUniform("model");
+    clusteredModelUniform = clusteredProgram.getUniform("model");
+
+    // Directional light properties
+    Engine::Graphics::DirectionalLight dirLight(
+        glm::vec3(-0.2f, -1.0f, -0.3f),
+        glm::vec3(0.05f, 0.05f, 0.05f),
+        glm::vec3(0.4f, 0.4f, 0.4f),
+        glm::vec3(0.5f, 0.5f, 0.5f)
+    );
+    lightManager.setDirectionalLight(dirLight);
+
+    // Point light properties
+    resetPointLights(settings.extraPointLights);
+
+    // FlashLight properties
+    Engine::Graphics::FlashLight flashLight(camera.Position, camera.Front);
+    lightManager.setFlashLight(flashLight);
+
+    resetCubes(settings.extraCubes);
+    resetDetailMeshes(settings.detailMeshes);
+}
+
+void Scene::resetPointLights(int extraCount)
+{
+    lightManager.clearPointLights();
+    for(int i = 0; i < ANIMATED_POINT_LIGHTS; i++){
+        Engine::Graphics::PointLight light(
+            glm::vec3(0.0f),
+            1.0f,
+            0.09f,
+            0.032f,
+            glm::vec3(0.05f, 0.05f, 0.05f),
+            glm::vec3(0.8f, 0.8f, 0.8f),
+            glm::vec3(1.0f, 1.0f, 1.0f)
+        );
+        lightManager.addPointLight(light);
+    }
+
+    // Fixed seed so the same count always gives the same scene
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+    std::uniform_real_distribution<float> color(0.2f, 1.0f);
+    for(int i = 0; i < extraCount; i++){
+        glm::vec3 lightColor(color(rng), color(rng), color(rng));
+        Engine::Graphics::PointLight light(
+            glm::vec3(position(rng), position(rng), position(rng)),
+            1.0f,
+            0.7f,
+            1.8f,
+            glm::vec3(0.0f),
+            lightColor * 0.5f,
+            lightColor * 0.5f
+        );
+        lightManager.addPointLight(light);
+    }
+}
+
+void Scene::resetCubes(int extraCount)
+{
+    // Multiple cube positions;
+    cubePositions = {
+        glm::vec3(1.2f, 2.8f, -1.5f),
+        glm::vec3(-2.3f, 0.9f, 3.1f),
+        glm::vec3(3.5f, -1.7f, 2.4f),
+        glm::vec3(-3.2f, 3.6f, -0.8f),
+        glm::vec3(0.7f, -2.5f, 1.9f),
+        glm::vec3(-1.8f, 1.4f, -3.3f),
+        glm::vec3(2.9f, -3.1f, 0.6f),
+        glm::vec3(-0.5f, 2.2f, -2.7f),
+        glm::vec3(1.6f, -0.4f, 3.8f),
+        glm::vec3(-2.7f, 3.3f, 1.1f)
+    };
+
+    // Square grid of cubes two units apart, centered under the others
+    int side = (int)std::ceil(std::sqrt((float)extraCount));
+    for(int i = 0; i < extraCount; i++){
+        float x = (i % side - (side - 1) * 0.5f) * 2.0f;
+        float z = (i / side - (side - 1) * 0.5f) * 2.0f;
+        cubePositions.push_back(glm::vec3(x, -6.0f, z));
+    }
+
+    const Engine::Graphics::MeshBounds& meshBounds = cubeMesh.GetBounds();
+    std::vector<Engine::Graphics::AABB> boxes(cubePositions.size());
+    cubeBounds.Clear();
+    cubeBounds.Reserve(cubePositions.size());
+    for(size_t i = 0; i < cubePositions.size(); i++){
+        boxes[i].min = cubePositions[i] + meshBounds.min;
+        boxes[i].max = cubePositions[i] + meshBounds.max;
+        cubeBounds.Add(boxes[i].min, boxes[i].max);
+    }
+    cubeBVH.Build(boxes);
+
+    gpuCuller.Clear();
+    uint32_t cubeCommand = gpuCuller.AddMesh(cubeMesh.GetRange());
+    for(size_t i = 0; i < cubePositions.size(); i++){
+        gpuCuller.AddObject(cubeCommand, glm::translate(glm::mat4(1.0f), cubePositions[i]), boxes[i].min, boxes[i].max);
+    }
+    visibleCubes.resize(cubeBounds.GetPaddedCount());
+}
+
+void Scene::resetDetailMeshes(int count)
+{
+    if(count > 0 && !detailMesh){
+        detailMesh = Engine::Graphics::Mesh::CreateSphere(DETAIL_MESH_SEGMENTS, DETAIL_MESH_BUMP_HEIGHT, &textures, dirt,
+                                                          &geometry);
+        detailMesh->GenerateLods();
+        detailMesh->BuildMeshlets();
+    }
+
+    // Each ring further out and turned by half a step, so the rings don't line up
+    detailTransforms.clear();
+    for(int i = 0; i < count; i++){
+        int ring = i / DETAIL_MESHES_PER_RING;
+        float angle = glm::two_pi<float>() * (i % DETAIL_MESHES_PER_RING + 0.5f * (ring % 2)) / DETAIL_MESHES_PER_RING;
+        float radius = 7.0f + 4.0f * ring;
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(radius * glm::cos(angle), 0.0f, radius * glm::sin(angle)));
+        detailTransforms.push_back(glm::scale(model, glm::vec3(DETAIL_MESH_SCALE)));
+    }
+}
+
+void Scene::ApplySettings(const SceneSettings& newSettings)
+{
+    if(newSettings.extraPointLights != settings.extraPointLights){
+        resetPointLights(newSettings.extraPointLights);
+    }
+    if(newSettings.extraCubes != settings.extraCubes){
+        resetCubes(newSettings.extraCubes);
+    }
+    if(newSettings.detailMeshes != settings.detailMeshes){
+        resetDetailMeshes(newSettings.detailMeshes);
+    }
+    settings = newSettings;
+}
+
+void Scene::Update(float time, const Engine::Graphics::Camera& camera)
+{
+    ENGINE_PROFILE_SCOPE("Update");
+    frameArena.BeginFrame();
+    {
+        // Textures decoded since the last frame replace their placeholders
+        ENGINE_PROFILE_GPU_SCOPE("Texture uploads");
+        textureLoader.Update();
+    }
+
+    // Point light positions
+    for(size_t i = 0; i < pointLightPositions.size(); i++){
+        if(i % 2 == 0){
+        float x = 4 * glm::sin(time +  i * 3.14 / 2);
+        pointLightPositions[i] = glm::vec3(x, 0.0, 0.0);
+        }
+        else{
+        float y = 4 * glm::sin(time +  i * 3.14 / 2);
+        pointLightPositions[i] = glm::vec3(0.0, y, 0.0);
+        }
+    }
+
+    for(size_t i = 0; i < pointLightPositions.size(); i++){
+        Engine::Graphics::PointLight& pLight = lightManager.setPointLight(i);
+        pLight.setPosition(pointLightPositions[i]);
+    }
+
+    // Update Flashlight
+    if(lightManager.getUseFlashLight()){
+        Engine::Graphics::FlashLight& fLight = lightManager.setFlashLight();
+        fLight.setPosition(camera.Position);
+        fLight.setDirection(camera.Front);
+        fLight.setCutOff(glm::cos(glm::radians(settings.cutOff)), glm::cos(glm::radians(settings.outerCutOff)));
+    }
+}
+
+void Scene::Render(const Engine::Graphics::Camera& camera, const glm::vec2& viewportSize, float aspect)
+{
+    ENGINE_PROFILE_GPU_SCOPE("Render");
+    glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
+
+    bool batched = settings.batchedDrawing && !settings.instancedDrawing;
+    // GPU culled cubes are drawn as instances of the compacted matrices
+    bool gpuCulled = IsGpuCulling();
+    bool instancedCubes = settings.instancedDrawing || gpuCulled;
+    Engine::Graphics::Shader& litProgram = settings.clusteredLighting
+        ? (instancedCubes ? clusteredInstancedProgram : batched ? clusteredBatchedProgram : clusteredProgram)
+        : (instancedCubes ? instancedProgram : batched ? batchedProgram : shaderProgram);
+    Engine::Graphics::Uniform litModelUniform = settings.clusteredLighting ? clusteredModelUniform : modelUniform;
+    litProgram.Activate();
+
+    litProgram.setVec3("lightColor", lightColor);
+    litProgram.setVec3("viewPos", camera.Position);
+
+    // Material properties
+    litProgram.setFloat("material.shininess", 16.0f);
+
+    glm::mat4 proj = camera.GetProjectionMatrix(aspect, NEAR_PLANE, FAR_PLANE);
+
+    glm::mat4 view = camera.GetViewMatrix();
+    Engine::Graphics::Frustum frustum = Engine::Graphics::Frustum::FromMatrix(proj * view);
+
+    if(gpuCulled){
+        ENGINE_PROFILE_GPU_SCOPE("GPU culling");
+        gpuCuller.Cull(frustum);
+        visibleCubeCount = gpuCuller.GetVisibleCount();
+        // The cull ran its own program
+        litProgram.Activate();
+    } else if(settings.frustumCulling){
+        ENGINE_PROFILE_SCOPE("Frustum culling");
+        visibleCubeCount = settings.hierarchicalCulling
+            ? cubeBVH.QueryFrustum(frustum, visibleCubes.data())
+            : Engine::Graphics::CullAABBs(frustum, cubeBounds, visibleCubes.data());
+    } else {
+        for(size_t i = 0; i < cubePositions.size(); i++){
+            visibleCubes[i] = (uint32_t)i;
+        }
+        visibleCubeCount = cubePositions.size();
+    }
+
+    {
+        // Drop lights that cannot reach anything visible before uploading them
+        ENGINE_PROFILE_GPU_SCOPE("Lights");
+        lightManager.cullLights(frustum, cubeBVH);
+        lightManager.applyAll();
+    }
+
+    litProgram.setMat4("view", view);
+    litProgram.setMat4("proj", proj);
+
+    if(settings.clusteredLighting){
+        ENGINE_PROFILE_GPU_SCOPE("Light clusters");
+        lightClusters.Build(lightManager, view, proj, NEAR_PLANE, FAR_PLANE, threadPool);
+        lightClusters.Upload();
+        lightClusters.Bind(litProgram, viewportSize);
+    }
+
+    // Per-object draws go through the render queue unless it is turned off; instancing and batching
+    // already draw each mesh with a single call
+    bool queued = settings.renderQueue && !settings.instancedDrawing && !batched;
+    if(queued){
+        renderQueue.Begin(view, FAR_PLANE);
+    }
+
+    glm::mat4 model;
+    if(gpuCulled){
+        ENGINE_PROFILE_GPU_SCOPE("Cubes");
+        cubeMesh.BindTexture();
+        cubeBatch.SubmitIndirect(geometry, litProgram, gpuCuller.GetCommandBuffer(), gpuCuller.GetCommandCount(),
+                                 gpuCuller.GetInstanceBuffer());
+    } else if(settings.instancedDrawing){
+        ENGINE_PROFILE_GPU_SCOPE("Cubes");
+        Engine::Core::FrameVector<glm::mat4> instanceTransforms{Engine::Core::FrameAllocator<glm::mat4>(frameArena)};
+        instanceTransforms.reserve(visibleCubeCount);
+        for(size_t i = 0; i < visibleCubeCount; i++){
+            instanceTransforms.push_back(glm::translate(glm::mat4(1.0f), cubePositions[visibleCubes[i]]));
+        }
+        cubeMesh.DrawInstanced(litProgram, instanceTransforms.data(), instanceTransforms.size());
+    } else if(batched){
+        ENGINE_PROFILE_GPU_SCOPE("Cubes");
+        cubeBatch.Begin();
+        for(size_t i = 0; i < visibleCubeCount; i++){
+            model = glm::translate(glm::mat4(1.0f), cubePositions[visibleCubes[i]]);
+            cubeBatch.Add(cubeMesh.GetRange(cubeMesh.SelectLod(camera, model, viewportSize.y)), model);
+        }
+        cubeMesh.BindTexture();
+        cubeBatch.Submit(geometry, litProgram, settings.batchPath);
+    } else {
+        ENGINE_PROFILE_GPU_SCOPE("Cubes");
+        for(size_t i = 0; i < visibleCubeCount; i++){
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, cubePositions[visibleCubes[i]]);
+            uint32_t lod = (uint32_t)cubeMesh.SelectLod(camera, model, viewportSize.y);
+            if(queued){
+                renderQueue.Push(Engine::Graphics::RenderPass::Opaque, {&litProgram, litModelUniform, &cubeMesh, model, lod});
+            } else {
+                litProgram.setMat4(litModelUniform, model);
+                cubeMesh.Draw(litProgram, lod);
+            }
+        }
+    }
+
+    if(!detailTransforms.empty()){
+        ENGINE_PROFILE_GPU_SCOPE("Detail meshes");
+        const Engine::Graphics::MeshBounds& detailBounds = detailMesh->GetBounds();
+        const std::vector<Engine::Graphics::Meshlet>& meshlets = detailMesh->GetMeshlets();
+        Engine::Core::FrameVector<glm::mat4> instanceTransforms{Engine::Core::FrameAllocator<glm::mat4>(frameArena)};
+        Engine::Core::FrameVector<uint32_t> instanceLods{Engine::Core::FrameAllocator<uint32_t>(frameArena)};
+        if(instancedCubes){
+            instanceTransforms.reserve(detailTransforms.size());
+            instanceLods.reserve(detailTransforms.size());
+        }
+        detailBatch.Begin();
+        for(const glm::mat4& detailModel : detailTransforms){
+            glm::vec3 center = glm::vec3(detailModel * glm::vec4(detailBounds.center, 1.0f));
+            if(settings.frustumCulling && !frustum.IntersectsSphere(center, detailBounds.radius * DETAIL_MESH_SCALE)){
+                continue;
+            }
+            uint32_t lod = (uint32_t)detailMesh->SelectLod(camera, detailModel, viewportSize.y);
+            // At full detail, only the meshlets that survive culling are drawn
+            bool meshletCulled = settings.meshletCulling && lod == 0 && !instancedCubes;
+            uint32_t* visibleMeshlets = nullptr;
+            size_t visibleMeshletCount = 0;
+            if(meshletCulled){
+                visibleMeshlets = frameArena.Allocate<uint32_t>(meshlets.size());
+                visibleMeshletCount = Engine::Graphics::CullMeshlets(meshlets, detailModel, frustum, camera.Position,
+                                                                     visibleMeshlets);
+                if(visibleMeshletCount == 0){
+                    continue;
+                }
+            }
+            if(instancedCubes){
+                instanceTransforms.push_back(detailModel);
+                instanceLods.push_back(lod);
+            } else if(batched && meshletCulled){
+                // Each run of consecutive surviving meshlets becomes one indirect command
+                Engine::Graphics::GeometryRange run = detailMesh->GetMeshletRange(visibleMeshlets[0]);
+                for(size_t m = 1; m < visibleMeshletCount; m++){
+                    Engine::Graphics::GeometryRange next = detailMesh->GetMeshletRange(visibleMeshlets[m]);
+                    if(next.firstIndex == run.firstIndex + run.indexCount){
+                        run.indexCount += next.indexCount;
+                    } else {
+                        detailBatch.Add(run, detailModel);
+                        run = next;
+                    }
+                }
+                detailBatch.Add(run, detailModel);
+            } else if(batched){
+                detailBatch.Add(detailMesh->GetRange(lod), detailModel);
+            } else if(queued){
+                Engine::Graphics::DrawCommand command{&litProgram, litModelUniform, &*detailMesh, detailModel, lod};
+                command.meshlets = visibleMeshlets;
+                command.meshletCount = (uint32_t)visibleMeshletCount;
+                renderQueue.Push(Engine::Graphics::RenderPass::Opaque, command);
+            } else if(meshletCulled){
+                litProgram.setMat4(litModelUniform, detailModel);
+                detailMesh->DrawMeshlets(litProgram, visibleMeshlets, visibleMeshletCount);
+            } else {
+                litProgram.setMat4(litModelUniform, detailModel);
+                detailMesh->Draw(litProgram, lod);
+            }
+        }
+        if(instancedCubes){
+            // One instanced draw per level, of the meshes that selected it
+            Engine::Core::FrameVector<glm::mat4> levelTransforms{Engine::Core::FrameAllocator<glm::mat4>(frameArena)};
+            levelTransforms.reserve(instanceTransforms.size());
+            for(size_t lod = 0; lod < detailMesh->GetLodCount(); lod++){
+                levelTransforms.clear();
+                for(size_t i = 0; i < instanceTransforms.size(); i++){
+                    if(instanceLods[i] == lod){
+                        levelTransforms.push_back(instanceTransforms[i]);
+                    }
+                }
+                if(!levelTransforms.empty()){
+                    detailMesh->DrawInstanced(litProgram, levelTransforms.data(), levelTransforms.size(), lod);
+                }
+            }
+        } else if(batched){
+            detailMesh->BindTexture();
+            detailBatch.Submit(geometry, litProgram, settings.batchPath);
+        }
+    }
+
+    {
+        ENGINE_PROFILE_GPU_SCOPE("Light cubes");
+        Engine::Graphics::Shader& cubeLightProgram = settings.instancedDrawing ? instancedLightProgram
+            : batched ? batchedLightProgram : lightProgram;
+        cubeLightProgram.Activate();
+        cubeLightProgram.setVec3("lightColor", lightColor);
+        cubeLightProgram.setMat4("view", view);
+        cubeLightProgram.setMat4("proj", proj);
+
+        Engine::Core::FrameVector<glm::mat4> lightTransforms{Engine::Core::FrameAllocator<glm::mat4>(frameArena)};
+        lightTransforms.reserve(pointLightPositions.size());
+        lightBatch.Begin();
+        for(size_t i = 0; i < pointLightPositions.size(); i++){
+            if(lightManager.getUsePointLight(i)){
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, pointLightPositions[i]);
+                model = glm::scale(model, glm::vec3(0.2f));
+                uint32_t lod = (uint32_t)lightCube.SelectLod(camera, model, viewportSize.y);
+                if(settings.instancedDrawing){
+                    lightTransforms.push_back(model);
+                } else if(batched){
+                    lightBatch.Add(lightCube.GetRange(lod), model);
+                } else if(queued){
+                    renderQueue.Push(Engine::Graphics::RenderPass::Opaque, {&lightProgram, lightModelUniform, &lightCube, model, lod});
+                } else {
+                    lightProgram.setMat4(lightModelUniform, model);
+                    lightCube.Draw(lightProgram, lod);
+                }
+            }
+        }
+        if(settings.instancedDrawing){
+            lightCube.DrawInstanced(instancedLightProgram, lightTransforms.data(), lightTransforms.size());
+        } else if(batched){
+            lightBatch.Submit(geometry, batchedLightProgram, settings.batchPath);
+        }
+    }
+
+    if(queued){
+        ENGINE_PROFILE_GPU_SCOPE("Render queue");
+        renderQueue.Sort();
+        renderQueue.Submit();
+    }
+}
+
+int Scene::Pick(const Engine::Graphics::Camera& camera, const glm::vec2& cursor, const glm::vec2& viewportSize, float aspect) const
+{
+    Engine::Graphics::BVHHit hit;
+    glm::vec3 direction = camera.GetCursorRay(cursor, viewportSize, aspect);
+    if(!cubeBVH.Raycast(camera.Position, direction, FAR_PLANE, hit)){
+        return -1;
+    }
+    return (int)hit.object;
+}
+
+void Scene::FinishLoading()
+{
+    textureLoader.Finish();
+}
+
+void Scene::Delete()
+{
+    textureLoader.Delete();
+    textures.Clear();
+    cubeMesh.Delete();
+    lightCube.Delete();
+    if(detailMesh){
+        detailMesh->Delete();
+    }
+    geometry.Delete();
+    cubeBatch.Delete();
+    lightBatch.Delete();
+    detailBatch.Delete();
+    gpuCuller.Delete();
+    for(Engine::Graphics::Shader* program : allPrograms){
+        program->Delete();
+    }
+    lightManager.deleteBuffer();
+    lightClusters.Delete();
+}
+
+const SceneSettings& Scene::GetSettings() const
+{
+    return settings;
+}
+
+const Engine::Graphics::LightClusters& Scene::GetLightClusters() const
+{
+    return lightClusters;
+}
+
+size_t Scene::GetCubeCount() const
+{
+    return cubePositions.size();
+}
+
+Engine::Graphics::VertexFormat Scene::GetVertexFormat() const
+{
+    return geometry.GetFormat();
+}
+
+size_t Scene::GetVisibleCubeCount() const
+{
+    return visibleCubeCount;
+}
+
+bool Scene::IsGpuCulling() const
+{
+    return settings.gpuCulling && Engine::Graphics::GpuCuller::IsSupported();
+}
+
+Engine::Graphics::BatchPath Scene::GetBatchPath() const
+{
+    return cubeBatch.GetLastPath();
+}
+
+size_t Scene::GetPendingTextureCount() const
+{
+    return textureLoader.GetPendingCount();
+}
+
+Engine::Graphics::UniformStats Scene::GetUniformStats() const
+{
+    Engine::Graphics::UniformStats uniformStats;
+    for(Engine::Graphics::Shader* program : allPrograms){
+        uniformStats.issued += program->getUniformStats().issued;
+        uniformStats.skipped += program->getUniformStats().skipped;
+    }
+    return uniformStats;
+}
+
+void Scene::ResetUniformStats()
+{
+    for(Engine::Graphics::Shader* program : allPrograms){
+        program->resetUniformStats();
+    }
+}
@@ -0,0 +1,173 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+
+#include "engine/core/framearena.hpp"
+#include "engine/core/threadpool.hpp"
+#include "engine/graphics/batchrenderer.hpp"
+#include "engine/graphics/bvh.hpp"
+#include "engine/graphics/camera.hpp"
+#include "engine/graphics/culling.hpp"
+#include "engine/graphics/geometryarena.hpp"
+#include "engine/graphics/gpuculler.hpp"
+#include "engine/graphics/lightclusters.hpp"
+#include "engine/graphics/lightmanager.hpp"
+#include "engine/graphics/mesh.hpp"
+#include "engine/graphics/renderqueue.hpp"
+#include "engine/graphics/shader.hpp"
+#include "engine/graphics/texture.hpp"
+#include "engine/graphics/textureloader.hpp"
+
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+
+// Options of the demo scene, edited in the settings panel or set from the command line
+struct SceneSettings
+{
+    bool clusteredLighting = false;
+    bool instancedDrawing = false;
+    // Sort per-object draws by state and depth before submitting them
+    bool renderQueue = true;
+    // Submit per-object draws as multi-draw batches instead (ignored when instancing)
+    bool batchedDrawing = false;
+    Engine::Graphics::BatchPath batchPath = Engine::Graphics::BatchPath::Best;
+    // Skip cubes outside the view frustum
+    bool frustumCulling = true;
+    // Cull through the bounding volume hierarchy instead of testing every cube's box
+    bool hierarchicalCulling = false;
+    // Cull the cubes in a compute shader and draw the survivors indirectly (GL 4.3), in place of the
+    // culling and drawing options above for the cubes
+    bool gpuCulling = false;
+    // Static point lights added to the animated ones
+    int extraPointLights = 0;
+    // Cubes laid out on a grid below the hand placed ones
+    int extraCubes = 0;
+    // Dense spheres in rings around the cubes, each drawn at the coarsest level of detail that stays
+    // within a pixel of the full one. Lights are only culled against the cubes.
+    int detailMeshes = 0;
+    // Draw only the meshlets of full detail meshes that are in view and facing the camera (CullMeshlets);
+    // not when instancing, as the instances share one draw
+    bool meshletCulling = true;
+    // Flash light cone angles in degrees
+    float cutOff = 0.0f;
+    float outerCutOff = 0.0f;
+};
+
+// The demo scene: textured cubes lit by a directional light, animated point lights and a flash light
+// following the camera. Shared by the interactive window and the headless benchmark.
+class Scene
+{
+public:
+    static const int ANIMATED_POINT_LIGHTS = 4;
+
+    // Loads the shaders, textures and meshes and fills the light manager. The meshes are stored in
+    // vertexFormat (Quantized is stored as Compact, see GeometryArena).
+    Scene(Engine::Graphics::LightManager& lightManager, const Engine::Graphics::Camera& camera,
+          Engine::Graphics::VertexFormat vertexFormat = Engine::Graphics::VertexFormat::Float);
+
+    // Rebuilds the lights and cubes if their counts changed
+    void ApplySettings(const SceneSettings& settings);
+    // Starts a new frame: animates the point lights and moves the flash light with the camera
+    void Update(float time, const Engine::Graphics::Camera& camera);
+    // Culls and uploads the lights, then draws the cubes into the bound framebuffer
+    void Render(const Engine::Graphics::Camera& camera, const glm::vec2& viewportSize, float aspect);
+    // Returns the index of the closest cube under a cursor position (in viewport pixels from the top left
+    // corner), or -1 if there is none
+    int Pick(const Engine::Graphics::Camera& camera, const glm::vec2& cursor, const glm::vec2& viewportSize, float aspect) const;
+    // Blocks until every texture has been decoded and uploaded
+    void FinishLoading();
+    // Deletes the shaders, textures, meshes and light buffers; must run while the GL context is alive
+    void Delete();
+
+    const SceneSettings& GetSettings() const;
+    const Engine::Graphics::LightClusters& GetLightClusters() const;
+    size_t GetCubeCount() const;
+    Engine::Graphics::VertexFormat GetVertexFormat() const;
+    // Cubes drawn by the last Render; with GPU culling, by the one GpuCuller::READBACK_FRAMES before
+    size_t GetVisibleCubeCount() const;
+    // True if the cubes are culled on the GPU (the setting is on and the driver supports it)
+    bool IsGpuCulling() const;
+    // Path the batched cubes were last submitted with
+    Engine::Graphics::BatchPath GetBatchPath() const;
+    // Textures still loading in the background
+    size_t GetPendingTextureCount() const;
+
+    // Uniform uploads summed over every program, and their reset
+    Engine::Graphics::UniformStats GetUniformStats() const;
+    void ResetUniformStats();
+
+private:
+    // Recreates the animated point lights, followed by extra static ones scattered around the cubes
+    void resetPointLights(int extraCount);
+    // Recreates the cube positions, their culling bounds and the hierarchy used for culling, picking and lights
+    void resetCubes(int extraCount);
+    // Recreates the transforms of the detail meshes, and their mesh the first time there are any
+    void resetDetailMeshes(int count);
+
+    Engine::Graphics::LightManager& lightManager;
+    SceneSettings settings;
+
+    // Generates Shader object using shaders defualt.vert and default.frag
+    Engine::Graphics::Shader shaderProgram;
+    Engine::Graphics::Shader lightProgram;
+    // Variant that only shades the point lights binned into each fragment's cluster
+    Engine::Graphics::Shader clusteredProgram;
+    // Variants reading the model matrix from a per-instance attribute
+    Engine::Graphics::Shader instancedProgram;
+    Engine::Graphics::Shader clusteredInstancedProgram;
+    Engine::Graphics::Shader instancedLightProgram;
+    Engine::Graphics::Shader batchedProgram;
+    Engine::Graphics::Shader clusteredBatchedProgram;
+    Engine::Graphics::Shader batchedLightProgram;
+    std::vector<Engine::Graphics::Shader*> litPrograms;
+    std::vector<Engine::Graphics::Shader*> allPrograms;
+
+    // Bins lights every frame, declared before everything that uses it
+    Engine::Core::ThreadPool threadPool;
+    // Decodes the textures. Separate from threadPool, so the per-frame binning never waits behind a
+    // long decode while loading.
+    Engine::Core::ThreadPool decodePool;
+    Engine::Graphics::TexturePool textures;
+    Engine::Graphics::TextureLoader textureLoader;
+
+    // Textures
+    Engine::Graphics::TextureHandle dirt;
+    Engine::Graphics::TextureHandle specular;
+
+    // Every mesh lives in one set of buffers, so switching meshes doesn't rebind
+    Engine::Graphics::GeometryArena geometry;
+    Engine::Graphics::Mesh cubeMesh;
+    Engine::Graphics::Mesh lightCube;
+    // Created the first time detail meshes are asked for, since generating its levels takes a while
+    std::optional<Engine::Graphics::Mesh> detailMesh;
+
+    Engine::Graphics::LightClusters lightClusters;
+    Engine::Graphics::RenderQueue renderQueue;
+    Engine::Graphics::BatchRenderer cubeBatch;
+    Engine::Graphics::BatchRenderer lightBatch;
+    Engine::Graphics::BatchRenderer detailBatch;
+    // Culls the cubes and writes the indirect draw of the survivors
+    Engine::Graphics::GpuCuller gpuCuller;
+
+    // Resolved once instead of looking them up by name for every cube
+    Engine::Graphics::Uniform modelUniform;
+    Engine::Graphics::Uniform lightModelUniform;
+    Engine::Graphics::Uniform clusteredModelUniform;
+
+    std::vector<glm::vec3> cubePositions;
+    // World space box of every cube, and the indices of those that passed culling this frame
+    Engine::Graphics::CullBounds cubeBounds;
+    std::vector<uint32_t> visibleCubes;
+    size_t visibleCubeCount;
+    // Cubes by index, for hierarchical culling, picking and culling lights that touch no cube
+    Engine::Graphics::BVH cubeBVH;
+    std::vector<glm::vec3> pointLightPositions;
+    std::vector<glm::mat4> detailTransforms;
+    // Transient per-frame data such as instance transforms
+    Engine::Core::FrameArena frameArena;
+};
+
+#endif